@@ -7,9 +7,26 @@ project "Walnut"
 
    files { "src/**.h", "src/**.cpp" }
 
+   -- Shaders are compiled to SPIR-V and included as C initializer lists (<name>.inl).
+   -- Without glslc bindless textures and Tonemapper are compiled out (WL_NO_SHADERS), as in the CMake build.
+   local glslc = (VULKAN_SDK or "") .. "/Bin/glslc"
+   if VULKAN_SDK and (os.isfile(glslc) or os.isfile(glslc .. ".exe")) then
+      prebuildcommands
+      {
+         '{MKDIR} "%{wks.location}/bin-int/shaders"',
+         '"%{VULKAN_SDK}/Bin/glslc" --target-env=vulkan1.2 -mfmt=c -o "%{wks.location}/bin-int/shaders/ImGuiBindless.vert.inl" "src/Walnut/ImGui/Shaders/ImGuiBindless.vert"',
+         '"%{VULKAN_SDK}/Bin/glslc" --target-env=vulkan1.2 -mfmt=c -o "%{wks.location}/bin-int/shaders/ImGuiBindless.frag.inl" "src/Walnut/ImGui/Shaders/ImGuiBindless.frag"',
+         '"%{VULKAN_SDK}/Bin/glslc" --target-env=vulkan1.2 -mfmt=c -o "%{wks.location}/bin-int/shaders/Tonemap.comp.inl" "src/Walnut/Compute/Shaders/Tonemap.comp"',
+      }
+   else
+      premake.warn("glslc not found, building without bindless textures and Tonemapper (install the Vulkan SDK or set VULKAN_SDK to enable them)")
+      defines { "WL_NO_SHADERS" }
+   end
+
    includedirs
    {
       "src",
+      "%{wks.location}/bin-int/shaders",
 
       "../vendor/imgui",
       "../vendor/glfw/include",
@@ -1,4 +1,15 @@
 #include "Application.h"
+#include "Image.h"
+#include "GpuTimer.h"
+#include "Profiler.h"
+#include "Metrics.h"
+#include "FrameStatsLayer.h"
+#include "MemoryInspectorLayer.h"
+#include "MemoryTracker.h"
+#include "Input/Input.h"
+#include "Input/InputRecorder.h"
+#include "ImGui/ImGuiBindlessRenderer.h"
+#include "ImGui/FontAtlasCache.h"
 
 //
 // Adapted from Dear ImGui Vulkan example
@@ -6,6 +17,7 @@
 
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_vulkan.h"
+#include "imgui_internal.h"
 #include <stdio.h>          // printf, fprintf
 #include <stdlib.h>         // abort
 #define GLFW_INCLUDE_NONE
@@ -15,10 +27,18 @@
 #include <glm/glm.hpp>
 
 #include <iostream>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
 
 // Emedded font
 #include "ImGui/Roboto-Regular.embed"
 
+static const float s_DefaultFontSize = 20.0f;
+
 extern bool g_ApplicationRunning;
 
 // [Win32] Our example includes a copy of glfw3.lib pre-compiled with VS2010 to maximize ease of testing and compatibility with old VS compilers.
@@ -33,7 +53,7 @@ extern bool g_ApplicationRunning;
 #define IMGUI_VULKAN_DEBUG_REPORT
 #endif
 
-static VkAllocationCallbacks* g_Allocator = NULL;
+static const VkAllocationCallbacks* g_Allocator = NULL;
 static VkInstance               g_Instance = VK_NULL_HANDLE;
 static VkPhysicalDevice         g_PhysicalDevice = VK_NULL_HANDLE;
 static VkDevice                 g_Device = VK_NULL_HANDLE;
@@ -45,18 +65,173 @@ static VkDescriptorPool         g_DescriptorPool = VK_NULL_HANDLE;
 
 static ImGui_ImplVulkanH_Window g_MainWindowData;
 static int                      g_MinImageCount = 2;
-static bool                     g_SwapChainRebuild = false;
+static std::atomic<bool>        g_SwapChainRebuild = false;       // Out of date, rebuilt before the next frame
+static std::atomic<bool>        g_SwapChainResizePending = false; // Size changed or suboptimal, rebuilt once debounced
+static uint32_t                 g_InstanceApiVersion = VK_API_VERSION_1_0;
+static bool                     g_VSync = true;
+
+// Bindless texture mode (ApplicationSpecification::BindlessTextures), only set if the device supports it
+static bool                     g_BindlessTextures = false;
+static Walnut::Image*           g_BindlessFontImage = nullptr;
+
+// GPU timestamps are reset from the host, which needs hostQueryReset (Vulkan 1.2)
+static bool                     g_HostQueryReset = false;
+
+// The main window's swapchain images can be copied from (FrameCapture)
+static bool                     g_SwapchainTransferSource = false;
+
+// Records are preallocated per frame so that deferring a free doesn't allocate in the common case
+static const uint32_t s_ResourceFreeReserve = 256;
+
+struct ResourceFreeRecord
+{
+	Walnut::ResourceType Type;
+	uint64_t Handle;
+};
+
+struct ResourceFreeFrame
+{
+	std::vector<ResourceFreeRecord> Records;
+	std::vector<std::function<void()>> Funcs;
+
+	void Reserve()
+	{
+		Records.reserve(s_ResourceFreeReserve);
+		Funcs.reserve(s_ResourceFreeReserve / 8);
+	}
+};
 
 // Per-frame-in-flight
-static std::vector<std::vector<VkCommandBuffer>> s_AllocatedCommandBuffers;
-static std::vector<std::vector<std::function<void()>>> s_ResourceFreeQueue;
+static std::vector<ResourceFreeFrame> s_ResourceFreeQueue;
+static std::mutex s_ResourceFreeQueueMutex;
+static ResourceFreeFrame s_ResourceFreeScratch; // Swapped with a frame's queue so destruction runs outside the lock
 
 // Unlike g_MainWindowData.FrameIndex, this is not the the swapchain image index
 // and is always guaranteed to increase (eg. 0, 1, 2, 0, 1, 2)
 static uint32_t s_CurrentFrameIndex = 0;
 
+// What a frame needs until the GPU is done with it (ApplicationSpecification::FramesInFlight), independent of how
+// many images the swapchain has. Only the framebuffers and the render complete semaphores are per swapchain image.
+struct FrameInFlight
+{
+	VkCommandPool CommandPool = VK_NULL_HANDLE;
+	VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+	VkFence Fence = VK_NULL_HANDLE;
+	VkSemaphore ImageAcquiredSemaphore = VK_NULL_HANDLE;
+};
+
+static std::vector<FrameInFlight> s_FramesInFlight;
+static uint32_t s_FrameInFlightIndex = 0;
+
+// g_Queue and g_DescriptorPool are used from any thread that creates or uploads resources
+static std::mutex s_QueueMutex;
+static std::mutex s_DescriptorPoolMutex;
+
+// Application::GetCommandBuffer allocates from a pool owned by the calling thread. Pools of threads that have
+// exited are reused by new ones; all of them are destroyed with the context, which bumps the generation.
+static std::mutex s_CommandPoolsMutex;
+static std::vector<VkCommandPool> s_CommandPools;
+static std::vector<VkCommandPool> s_FreeCommandPools;
+static std::atomic<uint64_t> s_CommandPoolGeneration = 1;
+
+struct ThreadCommandPool
+{
+	VkCommandPool Pool = VK_NULL_HANDLE;
+	uint64_t Generation = 0;
+
+	~ThreadCommandPool()
+	{
+		std::scoped_lock<std::mutex> lock(s_CommandPoolsMutex);
+		if (Pool && Generation == s_CommandPoolGeneration.load())
+			s_FreeCommandPools.push_back(Pool);
+	}
+};
+
+static thread_local ThreadCommandPool s_ThreadCommandPool;
+static std::thread::id s_MainThread;
+
+// Recorded into the next frame's command buffer ahead of the UI pass (Application::SubmitFrameCommands)
+static std::vector<std::function<void(VkCommandBuffer)>> s_FrameCommands;
+static std::vector<std::function<void(VkCommandBuffer)>> s_FrameCommandsScratch;
+static std::mutex s_FrameCommandsMutex;
+
+// Pipelined rendering (ApplicationSpecification::RenderThreadDepth). The main thread copies each frame's draw data into a
+// free slot of the ring and goes on with the next frame; the render thread acquires, records, submits and presents the
+// slots in order. The swapchain is only rebuilt while the render thread has nothing pending.
+struct RenderThreadFrame
+{
+	ImDrawData DrawData;
+	std::vector<ImDrawList*> CmdLists; // Kept across frames, so copying stops allocating once they have grown
+	VkClearValue ClearValue = {};
+	Walnut::Timer InputTimer;          // Started when the frame's input was polled
+};
+
+struct RenderThreadData
+{
+	std::vector<RenderThreadFrame> Frames;
+	uint32_t Head = 0;    // Next slot the main thread fills
+	uint32_t Pending = 0; // Handed off and not presented yet
+	bool Stopping = false;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::thread Thread;
+
+	// SubmitResourceFree functions of the frames the render thread flushed, they run on the main thread
+	std::vector<std::function<void()>> MainThreadFuncs;
+	std::vector<std::function<void()>> MainThreadFuncsScratch;
+};
+
+static uint32_t g_RenderThreadDepth = 0;
+static RenderThreadData* s_RenderThread = nullptr; // Only while Application::Run is pipelined
+static std::atomic<bool> s_RenderThreadRunning = false;
+static thread_local bool s_IsRenderThread = false;
+// Frame arenas are reset by the main thread when it hands a frame off, see InitContext for the slot count
+static uint32_t s_ArenaFrameIndex = 0;
+
+// Font atlas upload submitted by Application::Init, released once the fence has signaled
+static VkCommandPool s_FontUploadCommandPool = VK_NULL_HANDLE;
+static VkFence s_FontUploadFence = VK_NULL_HANDLE;
+
+// The default font at other sizes (Application::GetFont), each in its own atlas. These are built on the main thread
+// between frames: ImGui::MemAlloc bumps the context's allocation counter, so a worker would race with the frame.
+struct FontSizeAtlas
+{
+	float Size = 0.0f;
+	ImFontAtlas* Atlas = nullptr;
+	ImFont* Font = nullptr;
+	Walnut::Image* Texture = nullptr; // Set once the atlas has been built and uploaded
+
+	~FontSizeAtlas()
+	{
+		delete Texture;
+		delete Atlas;
+	}
+};
+
+static std::vector<std::unique_ptr<FontSizeAtlas>> s_FontSizes;
+static std::string s_FontCacheDirectory;
+
 static Walnut::Application* s_Instance = nullptr;
 
+// Window, device, swapchain and ImGui context handed from an Application that was soft restarted to the next one
+static GLFWwindow* s_RestartWindow = nullptr;
+static Walnut::ApplicationSpecification s_RestartSpecification;
+
+// Layer scheduling (Walnut::LayerSchedule): costs are smoothed over roughly the throttle period
+static const float s_LayerCostSmoothing = 1.0f / 30.0f;
+static const uint32_t s_LayerThrottlePeriod = 30;
+static const uint32_t s_MaxLayerThrottle = 16;
+
+// A window that was submitted this frame but shows nothing: collapsed, or docked behind another tab
+static bool IsWindowHidden(const std::string& name)
+{
+	if (name.empty())
+		return false;
+
+	ImGuiWindow* window = ImGui::FindWindowByName(name.c_str());
+	return window && window->Active && (window->Collapsed || (window->DockIsActive && !window->DockTabIsVisible));
+}
+
 void check_vk_result(VkResult err)
 {
 	if (err == 0)
@@ -75,14 +250,28 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debug_report(VkDebugReportFlagsEXT flags,
 }
 #endif // IMGUI_VULKAN_DEBUG_REPORT
 
-static void SetupVulkan(const char** extensions, uint32_t extensions_count)
+static void SetupVulkan(const char** extensions, uint32_t extensions_count, bool requestBindless)
 {
 	VkResult err;
 
+	// Host allocations of the driver are accounted by scope
+	g_Allocator = Walnut::MemoryTracker::GetAllocationCallbacks();
+
 	// Create Vulkan Instance
 	{
+		// Ask for Vulkan 1.2 when the loader knows about versions at all (1.0 loaders reject anything above 1.0)
+		auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(NULL, "vkEnumerateInstanceVersion");
+		if (enumerateInstanceVersion && enumerateInstanceVersion(&g_InstanceApiVersion) == VK_SUCCESS)
+			g_InstanceApiVersion = glm::min<uint32_t>(g_InstanceApiVersion, VK_API_VERSION_1_2);
+
+		VkApplicationInfo app_info = {};
+		app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		app_info.pEngineName = "Walnut";
+		app_info.apiVersion = g_InstanceApiVersion;
+
 		VkInstanceCreateInfo create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		create_info.pApplicationInfo = &app_info;
 		create_info.enabledExtensionCount = extensions_count;
 		create_info.ppEnabledExtensionNames = extensions;
 #ifdef IMGUI_VULKAN_DEBUG_REPORT
@@ -172,7 +361,7 @@ static void SetupVulkan(const char** extensions, uint32_t extensions_count)
 	// Create Logical Device (with 1 queue)
 	{
 		int device_extension_count = 1;
-		const char* device_extensions[] = { "VK_KHR_swapchain" };
+		const char* device_extensions[2] = { "VK_KHR_swapchain" };
 		const float queue_priority[] = { 1.0f };
 		VkDeviceQueueCreateInfo queue_info[1] = {};
 		queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -183,11 +372,69 @@ static void SetupVulkan(const char** extensions, uint32_t extensions_count)
 		create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		create_info.queueCreateInfoCount = sizeof(queue_info) / sizeof(queue_info[0]);
 		create_info.pQueueCreateInfos = queue_info;
-		create_info.enabledExtensionCount = device_extension_count;
 		create_info.ppEnabledExtensionNames = device_extensions;
+
+		// Optional Vulkan 1.2 features are chained in front of create_info.pNext
+		VkPhysicalDeviceProperties device_properties;
+		vkGetPhysicalDeviceProperties(g_PhysicalDevice, &device_properties);
+		const bool vulkan12 = g_InstanceApiVersion >= VK_API_VERSION_1_2 && device_properties.apiVersion >= VK_API_VERSION_1_2;
+
+		// Per-heap usage and budget of the whole process, read through vkGetPhysicalDeviceMemoryProperties2 (Vulkan 1.1)
+		bool memory_budget = false;
+		if (g_InstanceApiVersion >= VK_API_VERSION_1_1 && device_properties.apiVersion >= VK_API_VERSION_1_1)
+		{
+			uint32_t count = 0;
+			vkEnumerateDeviceExtensionProperties(g_PhysicalDevice, NULL, &count, NULL);
+			VkExtensionProperties* properties = (VkExtensionProperties*)malloc(sizeof(VkExtensionProperties) * count);
+			vkEnumerateDeviceExtensionProperties(g_PhysicalDevice, NULL, &count, properties);
+			for (uint32_t i = 0; i < count; i++)
+				if (strcmp(properties[i].extensionName, "VK_EXT_memory_budget") == 0)
+					memory_budget = true;
+			free(properties);
+		}
+		if (memory_budget)
+			device_extensions[device_extension_count++] = "VK_EXT_memory_budget";
+		create_info.enabledExtensionCount = device_extension_count;
+
+		// Bindless textures fall back to per-image descriptor sets if descriptor indexing is missing
+		VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {};
+		if (requestBindless && vulkan12 && Walnut::ImGuiBindlessRenderer::QuerySupport(g_PhysicalDevice, indexing_features))
+		{
+			indexing_features.pNext = (void*)create_info.pNext;
+			create_info.pNext = &indexing_features;
+			g_BindlessTextures = true;
+		}
+
+		VkPhysicalDeviceHostQueryResetFeatures host_query_reset_features = {};
+		host_query_reset_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
+		if (vulkan12)
+		{
+			VkPhysicalDeviceFeatures2 features = {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &host_query_reset_features;
+			vkGetPhysicalDeviceFeatures2(g_PhysicalDevice, &features);
+			if (host_query_reset_features.hostQueryReset)
+			{
+				host_query_reset_features.pNext = (void*)create_info.pNext;
+				create_info.pNext = &host_query_reset_features;
+				g_HostQueryReset = true;
+			}
+		}
+
 		err = vkCreateDevice(g_PhysicalDevice, &create_info, g_Allocator, &g_Device);
 		check_vk_result(err);
 		vkGetDeviceQueue(g_Device, g_QueueFamily, 0, &g_Queue);
+
+		Walnut::MemoryTracker::Init(g_PhysicalDevice, memory_budget);
+	}
+
+	// Create Pipeline Cache
+	// Kept in memory only, it saves recompiling pipelines that are created more than once (ImGui, compute)
+	{
+		VkPipelineCacheCreateInfo pipeline_cache_info = {};
+		pipeline_cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		err = vkCreatePipelineCache(g_Device, &pipeline_cache_info, g_Allocator, &g_PipelineCache);
+		check_vk_result(err);
 	}
 
 	// Create Descriptor Pool
@@ -217,6 +464,264 @@ static void SetupVulkan(const char** extensions, uint32_t extensions_count)
 	}
 }
 
+static void SelectPresentMode(ImGui_ImplVulkanH_Window* wd)
+{
+#ifdef IMGUI_UNLIMITED_FRAME_RATE
+	g_VSync = false;
+#endif
+	VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	int first_present_mode = g_VSync ? 2 : 0; // With vsync only FIFO is considered
+	wd->PresentMode = ImGui_ImplVulkanH_SelectPresentMode(g_PhysicalDevice, wd->Surface, &present_modes[first_present_mode], IM_ARRAYSIZE(present_modes) - first_present_mode);
+	//printf("[vulkan] Selected PresentMode = %d\n", wd->PresentMode);
+}
+
+static void FreeWindowFrames(ImGui_ImplVulkanH_Window* wd)
+{
+	IM_FREE(wd->Frames);
+	IM_FREE(wd->FrameSemaphores);
+	wd->Frames = nullptr;
+	wd->FrameSemaphores = nullptr;
+	wd->ImageCount = 0;
+	wd->SemaphoreIndex = 0;
+}
+
+// The per swapchain image objects, command buffers and fences are per frame in flight
+static void DestroyWindowFrames(ImGui_ImplVulkanH_Window* wd)
+{
+	for (uint32_t i = 0; i < wd->ImageCount; i++)
+	{
+		vkDestroyImageView(g_Device, wd->Frames[i].BackbufferView, g_Allocator);
+		vkDestroyFramebuffer(g_Device, wd->Frames[i].Framebuffer, g_Allocator);
+		vkDestroySemaphore(g_Device, wd->FrameSemaphores[i].RenderCompleteSemaphore, g_Allocator);
+	}
+	FreeWindowFrames(wd);
+}
+
+// Frames still in flight can render to the old images or wait to present them, so rather than waiting for the
+// device to go idle the old swapchain and its views, framebuffers and semaphores go through the resource free
+// queue like everything else. The present that waits on a render complete semaphore has no fence of its own,
+// it is assumed done a full free queue later.
+static void RetireWindowFrames(ImGui_ImplVulkanH_Window* wd, VkSwapchainKHR old_swapchain)
+{
+	struct RetiredFrame
+	{
+		VkImageView BackbufferView;
+		VkFramebuffer Framebuffer;
+		VkSemaphore RenderCompleteSemaphore;
+	};
+
+	std::vector<RetiredFrame> frames(wd->ImageCount);
+	for (uint32_t i = 0; i < wd->ImageCount; i++)
+		frames[i] = { wd->Frames[i].BackbufferView, wd->Frames[i].Framebuffer, wd->FrameSemaphores[i].RenderCompleteSemaphore };
+	FreeWindowFrames(wd);
+
+	std::scoped_lock<std::mutex> lock(s_ResourceFreeQueueMutex);
+	s_ResourceFreeQueue[s_CurrentFrameIndex].Funcs.emplace_back([frames = std::move(frames), old_swapchain]()
+	{
+		for (const RetiredFrame& frame : frames)
+		{
+			vkDestroyFramebuffer(g_Device, frame.Framebuffer, g_Allocator);
+			vkDestroyImageView(g_Device, frame.BackbufferView, g_Allocator);
+			vkDestroySemaphore(g_Device, frame.RenderCompleteSemaphore, g_Allocator);
+		}
+		vkDestroySwapchainKHR(g_Device, old_swapchain, g_Allocator);
+	});
+}
+
+static void CreateFramesInFlight(uint32_t count)
+{
+	s_FramesInFlight.resize(count);
+	s_FrameInFlightIndex = 0;
+	for (FrameInFlight& frame : s_FramesInFlight)
+	{
+		VkCommandPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		pool_info.queueFamilyIndex = g_QueueFamily;
+		VkResult err = vkCreateCommandPool(g_Device, &pool_info, g_Allocator, &frame.CommandPool);
+		check_vk_result(err);
+
+		VkCommandBufferAllocateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		buffer_info.commandPool = frame.CommandPool;
+		buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		buffer_info.commandBufferCount = 1;
+		err = vkAllocateCommandBuffers(g_Device, &buffer_info, &frame.CommandBuffer);
+		check_vk_result(err);
+
+		VkFenceCreateInfo fence_info = {};
+		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		err = vkCreateFence(g_Device, &fence_info, g_Allocator, &frame.Fence);
+		check_vk_result(err);
+
+		VkSemaphoreCreateInfo semaphore_info = {};
+		semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		err = vkCreateSemaphore(g_Device, &semaphore_info, g_Allocator, &frame.ImageAcquiredSemaphore);
+		check_vk_result(err);
+	}
+}
+
+static void DestroyFramesInFlight()
+{
+	for (FrameInFlight& frame : s_FramesInFlight)
+	{
+		vkDestroyFence(g_Device, frame.Fence, g_Allocator);
+		vkFreeCommandBuffers(g_Device, frame.CommandPool, 1, &frame.CommandBuffer);
+		vkDestroyCommandPool(g_Device, frame.CommandPool, g_Allocator);
+		vkDestroySemaphore(g_Device, frame.ImageAcquiredSemaphore, g_Allocator);
+	}
+	s_FramesInFlight.clear();
+}
+
+// ImGui_ImplVulkanH_CreateOrResizeWindow for the main window, except that the swapchain images can also
+// be copied from (FrameCapture) and a resize doesn't wait for the device to go idle or recreate the render pass.
+// Secondary viewports still go through the ImGui backend.
+static void CreateOrResizeWindow(ImGui_ImplVulkanH_Window* wd, int width, int height)
+{
+	VkResult err;
+	VkSwapchainKHR old_swapchain = wd->Swapchain;
+	wd->Swapchain = VK_NULL_HANDLE;
+	if (old_swapchain)
+		RetireWindowFrames(wd, old_swapchain);
+
+	// Create Swapchain
+	{
+		VkSurfaceCapabilitiesKHR cap;
+		err = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(g_PhysicalDevice, wd->Surface, &cap);
+		check_vk_result(err);
+
+		VkSwapchainCreateInfoKHR info = {};
+		info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		info.surface = wd->Surface;
+		info.minImageCount = g_MinImageCount;
+		info.imageFormat = wd->SurfaceFormat.format;
+		info.imageColorSpace = wd->SurfaceFormat.colorSpace;
+		info.imageArrayLayers = 1;
+		info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		g_SwapchainTransferSource = (cap.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+		if (g_SwapchainTransferSource)
+			info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE; // Assume that graphics family == present family
+		info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+		info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		info.presentMode = wd->PresentMode;
+		info.clipped = VK_TRUE;
+		info.oldSwapchain = old_swapchain;
+		if (info.minImageCount < cap.minImageCount)
+			info.minImageCount = cap.minImageCount;
+		else if (cap.maxImageCount != 0 && info.minImageCount > cap.maxImageCount)
+			info.minImageCount = cap.maxImageCount;
+
+		if (cap.currentExtent.width == 0xffffffff)
+		{
+			info.imageExtent.width = wd->Width = width;
+			info.imageExtent.height = wd->Height = height;
+		}
+		else
+		{
+			info.imageExtent.width = wd->Width = cap.currentExtent.width;
+			info.imageExtent.height = wd->Height = cap.currentExtent.height;
+		}
+		err = vkCreateSwapchainKHR(g_Device, &info, g_Allocator, &wd->Swapchain);
+		check_vk_result(err);
+
+		VkImage backbuffers[16] = {};
+		err = vkGetSwapchainImagesKHR(g_Device, wd->Swapchain, &wd->ImageCount, NULL);
+		check_vk_result(err);
+		IM_ASSERT(wd->ImageCount < IM_ARRAYSIZE(backbuffers));
+		err = vkGetSwapchainImagesKHR(g_Device, wd->Swapchain, &wd->ImageCount, backbuffers);
+		check_vk_result(err);
+
+		wd->Frames = (ImGui_ImplVulkanH_Frame*)IM_ALLOC(sizeof(ImGui_ImplVulkanH_Frame) * wd->ImageCount);
+		wd->FrameSemaphores = (ImGui_ImplVulkanH_FrameSemaphores*)IM_ALLOC(sizeof(ImGui_ImplVulkanH_FrameSemaphores) * wd->ImageCount);
+		memset(wd->Frames, 0, sizeof(wd->Frames[0]) * wd->ImageCount);
+		memset(wd->FrameSemaphores, 0, sizeof(wd->FrameSemaphores[0]) * wd->ImageCount);
+		for (uint32_t i = 0; i < wd->ImageCount; i++)
+			wd->Frames[i].Backbuffer = backbuffers[i];
+
+		// The formats SetupVulkanWindow picks are all 4 bytes per pixel
+		Walnut::MemoryTracker::SetSwapchainMemory((uint64_t)wd->Width * wd->Height * 4 * wd->ImageCount, wd->ImageCount);
+	}
+	// Create the Render Pass, it only depends on the surface format so it outlives resizes
+	if (!wd->RenderPass)
+	{
+		VkAttachmentDescription attachment = {};
+		attachment.format = wd->SurfaceFormat.format;
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachment.loadOp = wd->ClearEnable ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		VkAttachmentReference color_attachment = {};
+		color_attachment.attachment = 0;
+		color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &color_attachment;
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.srcAccessMask = 0;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		VkRenderPassCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		info.attachmentCount = 1;
+		info.pAttachments = &attachment;
+		info.subpassCount = 1;
+		info.pSubpasses = &subpass;
+		info.dependencyCount = 1;
+		info.pDependencies = &dependency;
+		err = vkCreateRenderPass(g_Device, &info, g_Allocator, &wd->RenderPass);
+		check_vk_result(err);
+	}
+
+	// Create the Image Views and Framebuffers
+	for (uint32_t i = 0; i < wd->ImageCount; i++)
+	{
+		ImGui_ImplVulkanH_Frame* fd = &wd->Frames[i];
+
+		VkImageViewCreateInfo view_info = {};
+		view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		view_info.format = wd->SurfaceFormat.format;
+		view_info.components.r = VK_COMPONENT_SWIZZLE_R;
+		view_info.components.g = VK_COMPONENT_SWIZZLE_G;
+		view_info.components.b = VK_COMPONENT_SWIZZLE_B;
+		view_info.components.a = VK_COMPONENT_SWIZZLE_A;
+		view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		view_info.subresourceRange.levelCount = 1;
+		view_info.subresourceRange.layerCount = 1;
+		view_info.image = fd->Backbuffer;
+		err = vkCreateImageView(g_Device, &view_info, g_Allocator, &fd->BackbufferView);
+		check_vk_result(err);
+
+		VkFramebufferCreateInfo framebuffer_info = {};
+		framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebuffer_info.renderPass = wd->RenderPass;
+		framebuffer_info.attachmentCount = 1;
+		framebuffer_info.pAttachments = &fd->BackbufferView;
+		framebuffer_info.width = wd->Width;
+		framebuffer_info.height = wd->Height;
+		framebuffer_info.layers = 1;
+		err = vkCreateFramebuffer(g_Device, &framebuffer_info, g_Allocator, &fd->Framebuffer);
+		check_vk_result(err);
+	}
+
+	// Presenting an image waits on its own semaphore, so reacquiring the image means the present is done with it
+	for (uint32_t i = 0; i < wd->ImageCount; i++)
+	{
+		VkSemaphoreCreateInfo semaphore_info = {};
+		semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		err = vkCreateSemaphore(g_Device, &semaphore_info, g_Allocator, &wd->FrameSemaphores[i].RenderCompleteSemaphore);
+		check_vk_result(err);
+	}
+}
+
 // All the ImGui_ImplVulkanH_XXX structures/functions are optional helpers used by the demo.
 // Your real engine/app may not use them.
 static void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height)
@@ -238,22 +743,18 @@ static void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface
 	wd->SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(g_PhysicalDevice, wd->Surface, requestSurfaceImageFormat, (size_t)IM_ARRAYSIZE(requestSurfaceImageFormat), requestSurfaceColorSpace);
 
 	// Select Present Mode
-#ifdef IMGUI_UNLIMITED_FRAME_RATE
-	VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
-#else
-	VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_FIFO_KHR };
-#endif
-	wd->PresentMode = ImGui_ImplVulkanH_SelectPresentMode(g_PhysicalDevice, wd->Surface, &present_modes[0], IM_ARRAYSIZE(present_modes));
-	//printf("[vulkan] Selected PresentMode = %d\n", wd->PresentMode);
+	SelectPresentMode(wd);
 
 	// Create SwapChain, RenderPass, Framebuffer, etc.
 	IM_ASSERT(g_MinImageCount >= 2);
-	ImGui_ImplVulkanH_CreateOrResizeWindow(g_Instance, g_PhysicalDevice, g_Device, wd, g_QueueFamily, g_Allocator, width, height, g_MinImageCount);
+	CreateOrResizeWindow(wd, width, height);
 }
 
 static void CleanupVulkan()
 {
 	vkDestroyDescriptorPool(g_Device, g_DescriptorPool, g_Allocator);
+	vkDestroyPipelineCache(g_Device, g_PipelineCache, g_Allocator);
+	g_PipelineCache = VK_NULL_HANDLE;
 
 #ifdef IMGUI_VULKAN_DEBUG_REPORT
 	// Remove the debug report callback
@@ -267,58 +768,162 @@ static void CleanupVulkan()
 
 static void CleanupVulkanWindow()
 {
-	ImGui_ImplVulkanH_DestroyWindow(g_Instance, g_Device, &g_MainWindowData, g_Allocator);
+	// Not ImGui_ImplVulkanH_DestroyWindow, the frames have no command pools or fences of their own
+	ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+	DestroyWindowFrames(wd);
+	vkDestroyRenderPass(g_Device, wd->RenderPass, g_Allocator);
+	vkDestroySwapchainKHR(g_Device, wd->Swapchain, g_Allocator);
+	vkDestroySurfaceKHR(g_Instance, wd->Surface, g_Allocator);
+	*wd = ImGui_ImplVulkanH_Window();
+
+	DestroyFramesInFlight();
+	Walnut::MemoryTracker::SetSwapchainMemory(0, 0);
+}
+
+static void FlushResourceFreeQueue(uint32_t frameIndex)
+{
+	{
+		std::scoped_lock<std::mutex> lock(s_ResourceFreeQueueMutex);
+		std::swap(s_ResourceFreeScratch, s_ResourceFreeQueue[frameIndex]);
+	}
+
+	ResourceFreeFrame& frame = s_ResourceFreeScratch;
+	if (s_RenderThread)
+	{
+		std::scoped_lock<std::mutex> lock(s_RenderThread->Mutex);
+		for (auto& func : frame.Funcs)
+			s_RenderThread->MainThreadFuncs.emplace_back(std::move(func));
+	}
+	else
+	{
+		for (auto& func : frame.Funcs)
+			func();
+	}
+	frame.Funcs.clear();
+
+	// One pass per type keeps dependent objects in order (views before images, images before memory)
+	// without sorting, and lets descriptor sets go back to the pool in a single call per chunk
+	const uint32_t descriptorSetBatchSize = 64;
+	VkDescriptorSet descriptorSets[descriptorSetBatchSize];
+	uint32_t descriptorSetCount = 0;
+
+	for (uint32_t type = 0; type < (uint32_t)Walnut::ResourceType::Count; type++)
+	{
+		for (const ResourceFreeRecord& record : frame.Records)
+		{
+			if ((uint32_t)record.Type != type)
+				continue;
+
+			switch (record.Type)
+			{
+				case Walnut::ResourceType::BindlessTexture:
+					Walnut::ImGuiBindlessRenderer::RemoveTexture(Walnut::ImGuiBindlessRenderer::GetTextureIndex((ImTextureID)record.Handle));
+					break;
+				case Walnut::ResourceType::DescriptorSet:
+					descriptorSets[descriptorSetCount++] = (VkDescriptorSet)record.Handle;
+					if (descriptorSetCount == descriptorSetBatchSize)
+					{
+						std::scoped_lock<std::mutex> lock(s_DescriptorPoolMutex);
+						vkFreeDescriptorSets(g_Device, g_DescriptorPool, descriptorSetCount, descriptorSets);
+						descriptorSetCount = 0;
+					}
+					break;
+				case Walnut::ResourceType::Sampler:      vkDestroySampler(g_Device, (VkSampler)record.Handle, g_Allocator); break;
+				case Walnut::ResourceType::ImageView:    vkDestroyImageView(g_Device, (VkImageView)record.Handle, g_Allocator); break;
+				case Walnut::ResourceType::Image:        vkDestroyImage(g_Device, (VkImage)record.Handle, g_Allocator); break;
+				case Walnut::ResourceType::Buffer:       vkDestroyBuffer(g_Device, (VkBuffer)record.Handle, g_Allocator); break;
+				case Walnut::ResourceType::DeviceMemory: Walnut::MemoryTracker::FreeDeviceMemory(g_Device, (VkDeviceMemory)record.Handle); break;
+			}
+		}
+
+		if (descriptorSetCount > 0)
+		{
+			std::scoped_lock<std::mutex> lock(s_DescriptorPoolMutex);
+			vkFreeDescriptorSets(g_Device, g_DescriptorPool, descriptorSetCount, descriptorSets);
+			descriptorSetCount = 0;
+		}
+	}
+	frame.Records.clear();
 }
 
+// Filled in by FrameRender and FramePresent for the frame statistics, on the render thread when pipelined
+static std::atomic<float> s_FenceWaitMillis = 0.0f;
+static std::atomic<float> s_PresentMillis = 0.0f;
+static std::atomic<float> s_InputLatencyMillis = 0.0f;
+
 static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
 {
+	WL_PROFILE_FUNCTION();
+
 	VkResult err;
 
-	VkSemaphore image_acquired_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
-	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
-	err = vkAcquireNextImageKHR(g_Device, wd->Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
-	if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+	// The fence comes first, the acquire semaphore can only be signaled again once the submit that waited on it is done
+	FrameInFlight* frame = &s_FramesInFlight[s_FrameInFlightIndex];
+	{
+		WL_PROFILE_SCOPE("Wait Frame Fence");
+		Walnut::Timer fenceTimer;
+		err = vkWaitForFences(g_Device, 1, &frame->Fence, VK_TRUE, UINT64_MAX);    // wait indefinitely instead of periodically checking
+		check_vk_result(err);
+		s_FenceWaitMillis = fenceTimer.ElapsedMillis();
+	}
+
+	VkSemaphore image_acquired_semaphore = frame->ImageAcquiredSemaphore;
+	{
+		WL_PROFILE_SCOPE("Acquire Image");
+		err = vkAcquireNextImageKHR(g_Device, wd->Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
+	}
+	// The fence stays signaled, the next attempt reuses this frame. A suboptimal image was still acquired and has
+	// to be presented, the present reports it again.
+	if (err == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		g_SwapChainRebuild = true;
 		return;
 	}
-	check_vk_result(err);
+	if (err != VK_SUBOPTIMAL_KHR)
+		check_vk_result(err);
+	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->FrameIndex].RenderCompleteSemaphore;
 
-	s_CurrentFrameIndex = (s_CurrentFrameIndex + 1) % g_MainWindowData.ImageCount;
+	{
+		std::scoped_lock<std::mutex> lock(s_ResourceFreeQueueMutex);
+		s_CurrentFrameIndex = (s_CurrentFrameIndex + 1) % (uint32_t)s_ResourceFreeQueue.size();
+	}
 
 	ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
 	{
-		err = vkWaitForFences(g_Device, 1, &fd->Fence, VK_TRUE, UINT64_MAX);    // wait indefinitely instead of periodically checking
+		err = vkResetFences(g_Device, 1, &frame->Fence);
 		check_vk_result(err);
 
-		err = vkResetFences(g_Device, 1, &fd->Fence);
-		check_vk_result(err);
+		// Everything recorded for this frame slot has finished, so its timestamps can be read without stalling
+		Walnut::GpuTimer::BeginFrame(s_FrameInFlightIndex);
 	}
 	
 	{
+		WL_PROFILE_SCOPE("Free Resources");
 		// Free resources in queue
-		for (auto& func : s_ResourceFreeQueue[s_CurrentFrameIndex])
-			func();
-		s_ResourceFreeQueue[s_CurrentFrameIndex].clear();
+		FlushResourceFreeQueue(s_CurrentFrameIndex);
+		if (!s_RenderThread)
+			Walnut::FrameAllocator::BeginFrame(s_CurrentFrameIndex);
 	}
 	{
-		// Free command buffers allocated by Application::GetCommandBuffer
-		// These use g_MainWindowData.FrameIndex and not s_CurrentFrameIndex because they're tied to the swapchain image index
-		auto& allocatedCommandBuffers = s_AllocatedCommandBuffers[wd->FrameIndex];
-		if (allocatedCommandBuffers.size() > 0)
-		{
-			vkFreeCommandBuffers(g_Device, fd->CommandPool, (uint32_t)allocatedCommandBuffers.size(), allocatedCommandBuffers.data());
-			allocatedCommandBuffers.clear();
-		}
-
-		err = vkResetCommandPool(g_Device, fd->CommandPool, 0);
+		err = vkResetCommandPool(g_Device, frame->CommandPool, 0);
 		check_vk_result(err);
 		VkCommandBufferBeginInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-		err = vkBeginCommandBuffer(fd->CommandBuffer, &info);
+		err = vkBeginCommandBuffer(frame->CommandBuffer, &info);
 		check_vk_result(err);
 	}
+	{
+		WL_PROFILE_SCOPE("Record Frame Commands");
+		{
+			std::scoped_lock<std::mutex> lock(s_FrameCommandsMutex);
+			std::swap(s_FrameCommandsScratch, s_FrameCommands);
+		}
+		for (auto& func : s_FrameCommandsScratch)
+			func(frame->CommandBuffer);
+		s_FrameCommandsScratch.clear();
+	}
+	uint32_t imguiGpuScope = Walnut::GpuTimer::BeginScope(frame->CommandBuffer, "ImGui");
 	{
 		VkRenderPassBeginInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -328,14 +933,23 @@ static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
 		info.renderArea.extent.height = wd->Height;
 		info.clearValueCount = 1;
 		info.pClearValues = &wd->ClearValue;
-		vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(frame->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
 	}
 
 	// Record dear imgui primitives into command buffer
-	ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
+	{
+		WL_PROFILE_SCOPE("Record Draw Data");
+		if (g_BindlessTextures)
+			Walnut::ImGuiBindlessRenderer::RenderDrawData(draw_data, frame->CommandBuffer, s_FrameInFlightIndex);
+		else
+			ImGui_ImplVulkan_RenderDrawData(draw_data, frame->CommandBuffer);
+	}
 
 	// Submit command buffer
-	vkCmdEndRenderPass(fd->CommandBuffer);
+	vkCmdEndRenderPass(frame->CommandBuffer);
+	Walnut::GpuTimer::EndScope(frame->CommandBuffer, imguiGpuScope);
+
+	Walnut::FrameCapture::RecordFrame(frame->CommandBuffer, g_SwapchainTransferSource ? fd->Backbuffer : VK_NULL_HANDLE, wd->SurfaceFormat.format, wd->Width, wd->Height);
 	{
 		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		VkSubmitInfo info = {};
@@ -344,22 +958,41 @@ static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
 		info.pWaitSemaphores = &image_acquired_semaphore;
 		info.pWaitDstStageMask = &wait_stage;
 		info.commandBufferCount = 1;
-		info.pCommandBuffers = &fd->CommandBuffer;
+		info.pCommandBuffers = &frame->CommandBuffer;
 		info.signalSemaphoreCount = 1;
 		info.pSignalSemaphores = &render_complete_semaphore;
 
-		err = vkEndCommandBuffer(fd->CommandBuffer);
+		err = vkEndCommandBuffer(frame->CommandBuffer);
 		check_vk_result(err);
-		err = vkQueueSubmit(g_Queue, 1, &info, fd->Fence);
+		WL_PROFILE_SCOPE("Queue Submit");
+		std::scoped_lock<std::mutex> lock(s_QueueMutex);
+		err = vkQueueSubmit(g_Queue, 1, &info, frame->Fence);
 		check_vk_result(err);
 	}
+	s_FrameInFlightIndex = (s_FrameInFlightIndex + 1) % (uint32_t)s_FramesInFlight.size();
+}
+
+// For debouncing rebuilds. Set before g_SwapChainResizePending, so the main thread sees them once it sees the flag,
+// also when a suboptimal present on the render thread sets it.
+static std::atomic<double> s_ResizePendingSince = 0.0;
+static std::atomic<double> s_LastResizeTime = 0.0;
+
+static void MarkResizePending()
+{
+	double time = glfwGetTime();
+	if (!g_SwapChainResizePending)
+		s_ResizePendingSince = time;
+	s_LastResizeTime = time;
+	g_SwapChainResizePending = true;
 }
 
 static void FramePresent(ImGui_ImplVulkanH_Window* wd)
 {
 	if (g_SwapChainRebuild)
 		return;
-	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
+
+	WL_PROFILE_FUNCTION();
+	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->FrameIndex].RenderCompleteSemaphore;
 	VkPresentInfoKHR info = {};
 	info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	info.waitSemaphoreCount = 1;
@@ -367,88 +1000,402 @@ static void FramePresent(ImGui_ImplVulkanH_Window* wd)
 	info.swapchainCount = 1;
 	info.pSwapchains = &wd->Swapchain;
 	info.pImageIndices = &wd->FrameIndex;
-	VkResult err = vkQueuePresentKHR(g_Queue, &info);
-	if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+	Walnut::Timer presentTimer;
+	VkResult err;
+	{
+		std::scoped_lock<std::mutex> lock(s_QueueMutex);
+		err = vkQueuePresentKHR(g_Queue, &info);
+	}
+	s_PresentMillis = presentTimer.ElapsedMillis();
+	if (err == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		g_SwapChainRebuild = true;
 		return;
 	}
+	// Reported again every frame until the rebuild, only the first report starts the debounce
+	if (err == VK_SUBOPTIMAL_KHR)
+	{
+		if (!g_SwapChainResizePending)
+			MarkResizePending();
+		return;
+	}
 	check_vk_result(err);
-	wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->ImageCount; // Now we can use the next set of semaphores
 }
 
-static void glfw_error_callback(int error, const char* description)
+static void RecordInputLatency(Walnut::Timer& inputTimer)
 {
-	fprintf(stderr, "Glfw Error %d: %s\n", error, description);
+	static Walnut::Histogram& s_InputLatency = Walnut::MetricsRegistry::GetHistogram("Walnut/InputLatency(us)");
+	uint64_t nanos = inputTimer.ElapsedNanos();
+	s_InputLatency.Record(nanos / 1000);
+	s_InputLatencyMillis = (float)nanos / 1000000.0f;
 }
 
-namespace Walnut {
-
-	Application::Application(const ApplicationSpecification& specification)
-		: m_Specification(specification)
-	{
-		s_Instance = this;
+template<typename T>
+static void CopyImVector(ImVector<T>& destination, const ImVector<T>& source)
+{
+	// Unlike operator=, resize keeps the allocation
+	destination.resize(source.Size);
+	if (source.Size > 0)
+		memcpy(destination.Data, source.Data, source.size_in_bytes());
+}
 
-		Init();
-	}
+// ImGui reuses its draw lists for the next frame, so the render thread gets its own copies
+static void CopyDrawData(const ImDrawData* source, RenderThreadFrame& frame)
+{
+	while ((int)frame.CmdLists.size() < source->CmdListsCount)
+		frame.CmdLists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
 
-	Application::~Application()
+	for (int i = 0; i < source->CmdListsCount; i++)
 	{
-		Shutdown();
-
-		s_Instance = nullptr;
+		const ImDrawList* list = source->CmdLists[i];
+		ImDrawList* copy = frame.CmdLists[i];
+		CopyImVector(copy->CmdBuffer, list->CmdBuffer);
+		CopyImVector(copy->IdxBuffer, list->IdxBuffer);
+		CopyImVector(copy->VtxBuffer, list->VtxBuffer);
+		copy->Flags = list->Flags;
 	}
 
-	Application& Application::Get()
-	{
-		return *s_Instance;
-	}
+	frame.DrawData = *source;
+	frame.DrawData.CmdLists = frame.CmdLists.data();
+}
 
-	void Application::Init()
+static void RunRenderThread()
+{
+	Walnut::Profiler::SetThreadName("Render Thread");
+	s_IsRenderThread = true;
+
+	RenderThreadData& data = *s_RenderThread;
+	while (true)
 	{
-		// Setup GLFW window
-		glfwSetErrorCallback(glfw_error_callback);
-		if (!glfwInit())
+		RenderThreadFrame* frame;
 		{
-			std::cerr << "Could not initalize GLFW!\n";
-			return;
+			std::unique_lock<std::mutex> lock(data.Mutex);
+			data.Condition.wait(lock, [&data]() { return data.Pending > 0 || data.Stopping; });
+			// Frames handed off before stopping are still presented
+			if (data.Pending == 0)
+				break;
+
+			uint32_t count = (uint32_t)data.Frames.size();
+			frame = &data.Frames[(data.Head + count - data.Pending) % count];
 		}
 
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		m_WindowHandle = glfwCreateWindow(m_Specification.Width, m_Specification.Height, m_Specification.Name.c_str(), NULL, NULL);
+		// Dropped until the main thread has rebuilt the swapchain
+		if (!g_SwapChainRebuild)
+		{
+			WL_PROFILE_SCOPE("Render Thread Frame");
+			ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+			wd->ClearValue = frame->ClearValue;
+			FrameRender(wd, &frame->DrawData);
+			FramePresent(wd);
+			if (!g_SwapChainRebuild)
+				RecordInputLatency(frame->InputTimer);
+		}
 
-		// Setup Vulkan
-		if (!glfwVulkanSupported())
 		{
-			std::cerr << "GLFW: Vulkan not supported!\n";
-			return;
+			std::scoped_lock<std::mutex> lock(data.Mutex);
+			data.Pending--;
 		}
-		uint32_t extensions_count = 0;
-		const char** extensions = glfwGetRequiredInstanceExtensions(&extensions_count);
-		SetupVulkan(extensions, extensions_count);
+		data.Condition.notify_all();
+	}
+}
 
-		// Create Window Surface
-		VkSurfaceKHR surface;
-		VkResult err = glfwCreateWindowSurface(g_Instance, m_WindowHandle, g_Allocator, &surface);
-		check_vk_result(err);
+static void StartRenderThread(uint32_t depth)
+{
+	s_RenderThread = new RenderThreadData();
+	s_RenderThread->Frames.resize(depth);
+	s_RenderThreadRunning = true;
+	s_RenderThread->Thread = std::thread(RunRenderThread);
+}
 
-		// Create Framebuffers
-		int w, h;
-		glfwGetFramebufferSize(m_WindowHandle, &w, &h);
-		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-		SetupVulkanWindow(wd, surface, w, h);
+static void RunMainThreadFuncs()
+{
+	RenderThreadData& data = *s_RenderThread;
+	{
+		std::scoped_lock<std::mutex> lock(data.Mutex);
+		std::swap(data.MainThreadFuncsScratch, data.MainThreadFuncs);
+	}
+	for (auto& func : data.MainThreadFuncsScratch)
+		func();
+	data.MainThreadFuncsScratch.clear();
+}
 
-		s_AllocatedCommandBuffers.resize(wd->ImageCount);
-		s_ResourceFreeQueue.resize(wd->ImageCount);
+// Blocks until every frame handed off has been presented or dropped
+static void WaitForRenderThread()
+{
+	RenderThreadData& data = *s_RenderThread;
+	std::unique_lock<std::mutex> lock(data.Mutex);
+	data.Condition.wait(lock, [&data]() { return data.Pending == 0; });
+}
 
-		// Setup Dear ImGui context
+// Presents what is still pending first
+static void StopRenderThread()
+{
+	{
+		std::scoped_lock<std::mutex> lock(s_RenderThread->Mutex);
+		s_RenderThread->Stopping = true;
+	}
+	s_RenderThread->Condition.notify_all();
+	s_RenderThread->Thread.join();
+	s_RenderThreadRunning = false;
+
+	RunMainThreadFuncs();
+	for (RenderThreadFrame& frame : s_RenderThread->Frames)
+	{
+		for (ImDrawList* list : frame.CmdLists)
+			IM_DELETE(list);
+	}
+
+	delete s_RenderThread;
+	s_RenderThread = nullptr;
+}
+
+// Waits while RenderThreadDepth frames are pending, returns how long
+static float SubmitRenderThreadFrame(const ImDrawData* drawData, const VkClearValue& clearValue, const Walnut::Timer& inputTimer)
+{
+	WL_PROFILE_FUNCTION();
+
+	RenderThreadData& data = *s_RenderThread;
+	uint32_t count = (uint32_t)data.Frames.size();
+	Walnut::Timer waitTimer;
+	std::unique_lock<std::mutex> lock(data.Mutex);
+	data.Condition.wait(lock, [&data, count]() { return data.Pending < count; });
+	float waitMillis = waitTimer.ElapsedMillis();
+
+	// The render thread doesn't touch the slot until it is counted as pending
+	RenderThreadFrame& frame = data.Frames[data.Head];
+	lock.unlock();
+	CopyDrawData(drawData, frame);
+	frame.ClearValue = clearValue;
+	frame.InputTimer = inputTimer;
+
+	lock.lock();
+	data.Head = (data.Head + 1) % count;
+	data.Pending++;
+	lock.unlock();
+	data.Condition.notify_all();
+	return waitMillis;
+}
+
+// Called every frame until the asynchronous font upload from Application::Init has completed
+static void ReleaseFontUploadResources(bool wait)
+{
+	if (s_FontUploadFence == VK_NULL_HANDLE)
+		return;
+
+	if (wait)
+	{
+		VkResult err = vkWaitForFences(g_Device, 1, &s_FontUploadFence, VK_TRUE, UINT64_MAX);
+		check_vk_result(err);
+	}
+	else if (vkGetFenceStatus(g_Device, s_FontUploadFence) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	ImGui_ImplVulkan_DestroyFontUploadObjects();
+	vkDestroyFence(g_Device, s_FontUploadFence, g_Allocator);
+	vkDestroyCommandPool(g_Device, s_FontUploadCommandPool, g_Allocator);
+	s_FontUploadFence = VK_NULL_HANDLE;
+	s_FontUploadCommandPool = VK_NULL_HANDLE;
+}
+
+static void glfw_error_callback(int error, const char* description)
+{
+	fprintf(stderr, "Glfw Error %d: %s\n", error, description);
+}
+
+// Not every surface reports VK_ERROR_OUT_OF_DATE_KHR on resize (e.g. headless surfaces), so rebuild on size changes too
+static void glfw_framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	MarkResizePending();
+}
+
+// Builds and uploads one requested font size per frame, before ImGui::NewFrame can use it.
+// Sizes in the font cache only cost a load, the rest are rasterized here once.
+static void UploadFontSizes()
+{
+	for (const std::unique_ptr<FontSizeAtlas>& fontSize : s_FontSizes)
+	{
+		if (fontSize->Texture)
+			continue;
+
+		Walnut::FontAtlasCache::Build(fontSize->Atlas, s_FontCacheDirectory);
+		unsigned char* pixels;
+		int width, height;
+		fontSize->Atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+		fontSize->Texture = new Walnut::Image(width, height, Walnut::ImageFormat::RGBA, pixels);
+		fontSize->Atlas->SetTexID((ImTextureID)fontSize->Texture->GetDescriptorSet());
+		fontSize->Atlas->ClearTexData();
+		break;
+	}
+}
+
+// Tears down everything Application::InitContext created, the GPU must be idle
+static void DestroyContext(GLFWwindow* window)
+{
+	ReleaseFontUploadResources(true);
+
+	delete g_BindlessFontImage;
+	g_BindlessFontImage = nullptr;
+	s_FontSizes.clear();
+	s_FrameCommands.clear();
+
+	// Free resources in queue
+	for (uint32_t i = 0; i < (uint32_t)s_ResourceFreeQueue.size(); i++)
+		FlushResourceFreeQueue(i);
+	s_ResourceFreeQueue.clear();
+
+	Walnut::FrameCapture::Shutdown();
+	Walnut::FrameAllocator::Shutdown();
+
+	{
+		std::scoped_lock<std::mutex> lock(s_CommandPoolsMutex);
+		for (VkCommandPool pool : s_CommandPools)
+			vkDestroyCommandPool(g_Device, pool, g_Allocator);
+		s_CommandPools.clear();
+		s_FreeCommandPools.clear();
+		s_CommandPoolGeneration++;
+	}
+
+	Walnut::ImGuiBindlessRenderer::Shutdown();
+	g_BindlessTextures = false;
+
+	Walnut::GpuTimer::Shutdown();
+	g_HostQueryReset = false;
+
+	ImGui_ImplVulkan_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+
+	CleanupVulkanWindow();
+	CleanupVulkan();
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
+
+namespace Walnut {
+
+	Application::Application(const ApplicationSpecification& specification)
+		: m_Specification(specification)
+	{
+		s_Instance = this;
+		s_MainThread = std::this_thread::get_id();
+
+		Init();
+	}
+
+	Application::~Application()
+	{
+		Shutdown();
+
+		s_Instance = nullptr;
+	}
+
+	Application& Application::Get()
+	{
+		return *s_Instance;
+	}
+
+	void Application::Init()
+	{
+		m_StartupTimer.Reset();
+		m_StartupReport = {};
+		s_FontCacheDirectory = m_Specification.FontCacheDirectory;
+
+		if (!ResumeContext() && !InitContext())
+			return;
+
+		m_FrameStatsLayer = std::make_shared<FrameStatsLayer>(m_Specification.FrameStatsToggleKey, m_Specification.ShowFrameStats);
+		m_FrameStatsLayer->OnAttach();
+		m_MemoryInspectorLayer = std::make_shared<MemoryInspectorLayer>(m_Specification.MemoryInspectorToggleKey, m_Specification.ShowMemoryInspector);
+		m_MemoryInspectorLayer->OnAttach();
+
+		if (!m_Specification.InputReplayPath.empty())
+			InputRecorder::BeginReplay(m_Specification.InputReplayPath);
+		else if (!m_Specification.InputRecordPath.empty())
+			InputRecorder::BeginRecording(m_Specification.InputRecordPath, m_Specification.FixedTimeStep > 0.0f ? m_Specification.FixedTimeStep : 1.0f / 60.0f);
+
+		if (!m_Specification.Capture.Path.empty() && !FrameCapture::IsCapturing())
+			FrameCapture::Start(m_Specification.Capture);
+
+		m_StartupReport.InitMilliseconds = m_StartupTimer.ElapsedMillis();
+	}
+
+	bool Application::ResumeContext()
+	{
+		if (!s_RestartWindow)
+			return false;
+
+		Timer timer;
+		GLFWwindow* window = s_RestartWindow;
+		s_RestartWindow = nullptr;
+
+		// These are baked into the instance, device and ImGui setup
+		const ApplicationSpecification& previous = s_RestartSpecification;
+		if (previous.Headless != m_Specification.Headless || previous.BindlessTextures != m_Specification.BindlessTextures
+			|| previous.MaxBindlessTextures != m_Specification.MaxBindlessTextures || previous.RenderThreadDepth != m_Specification.RenderThreadDepth
+			|| previous.FramesInFlight != m_Specification.FramesInFlight)
+		{
+			DestroyContext(window);
+			return false;
+		}
+
+		m_WindowHandle = window;
+		glfwSetWindowTitle(window, m_Specification.Name.c_str());
+		if (previous.Width != m_Specification.Width || previous.Height != m_Specification.Height)
+			glfwSetWindowSize(window, (int)m_Specification.Width, (int)m_Specification.Height); // Rebuilds the swapchain through the size callback
+
+		if (previous.VSync != m_Specification.VSync)
+		{
+			g_VSync = m_Specification.VSync;
+			SelectPresentMode(&g_MainWindowData);
+			g_SwapChainRebuild = true;
+		}
+
+		// The GLFW clock keeps running across restarts
+		m_LastFrameTime = GetTime();
+
+		m_StartupReport.Phases.push_back({ "Soft Restart", timer.ElapsedMillis() });
+		return true;
+	}
+
+	bool Application::InitContext()
+	{
+		Timer phaseTimer;
+		auto endPhase = [this, &phaseTimer](const char* name)
+		{
+			m_StartupReport.Phases.push_back({ name, phaseTimer.ElapsedMillis() });
+			phaseTimer.Reset();
+		};
+
+		// Setup GLFW window
+		glfwSetErrorCallback(glfw_error_callback);
+#ifdef GLFW_PLATFORM_NULL
+		// GLFW 3.4+ can run without a display server, presenting to VK_EXT_headless_surface
+		if (m_Specification.Headless)
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+		if (!glfwInit())
+		{
+			std::cerr << "Could not initalize GLFW!\n";
+			return false;
+		}
+		endPhase("GLFW Init");
+
+		// Setup Dear ImGui context
 		IMGUI_CHECKVERSION();
 		ImGui::CreateContext();
 		ImGuiIO& io = ImGui::GetIO(); (void)io;
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
 		//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
 		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
-		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
+		// Platform windows are recorded by the stock backend on the main thread, which would race with the render
+		// thread recording the main window through the same backend data
+		if (!m_Specification.Headless && m_Specification.RenderThreadDepth == 0)
+			io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;     // Enable Multi-Viewport / Platform Windows
+		if (m_Specification.Headless)
+			io.IniFilename = nullptr;                               // Keep headless runs reproducible
 		//io.ConfigViewportsNoAutoMerge = true;
 		//io.ConfigViewportsNoTaskBarIcon = true;
 
@@ -464,7 +1411,85 @@ namespace Walnut {
 			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
 		}
 
+		// Load default font
+		ImFontConfig fontConfig;
+		fontConfig.FontDataOwnedByAtlas = false;
+		ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), s_DefaultFontSize, &fontConfig);
+		io.FontDefault = robotoFont;
+		endPhase("ImGui Context");
+
+		// Rasterize the font atlas (or load it from the font cache) on a worker thread while we create the window
+		// and the Vulkan device. Nothing may touch ImGui (including IM_ALLOC) on this thread until the future has been joined.
+		bool fontAtlasCached = false;
+		std::future<float> fontAtlasBuild = std::async(std::launch::async, [fonts = io.Fonts, directory = m_Specification.FontCacheDirectory, &fontAtlasCached]()
+		{
+			Timer timer;
+			fontAtlasCached = FontAtlasCache::Build(fonts, directory);
+			return timer.ElapsedMillis();
+		});
+
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		if (m_Specification.Headless)
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		m_WindowHandle = glfwCreateWindow(m_Specification.Width, m_Specification.Height, m_Specification.Name.c_str(), NULL, NULL);
+		glfwSetFramebufferSizeCallback(m_WindowHandle, glfw_framebuffer_size_callback);
+		endPhase("Window Creation");
+
+		// Setup Vulkan
+		if (!glfwVulkanSupported())
+		{
+			std::cerr << "GLFW: Vulkan not supported!\n";
+			fontAtlasBuild.wait();
+			return false;
+		}
+		uint32_t extensions_count = 0;
+		const char** extensions = glfwGetRequiredInstanceExtensions(&extensions_count);
+		SetupVulkan(extensions, extensions_count, m_Specification.BindlessTextures);
+		endPhase("Vulkan Instance/Device");
+
+		// Secondary viewports are drawn by the stock backend, which can't resolve bindless texture IDs
+		if (g_BindlessTextures)
+			io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+
+		// CreateOrResizeWindow allocates the frames through ImGui, so the atlas has to be done by now
+		float fontAtlasMillis = fontAtlasBuild.get();
+		m_StartupReport.Phases.push_back({ fontAtlasCached ? "Font Atlas Cache Load" : "Font Atlas Rasterization", fontAtlasMillis, true });
+		endPhase("Font Atlas Wait");
+
+		// Create Window Surface
+		VkSurfaceKHR surface;
+		VkResult err = glfwCreateWindowSurface(g_Instance, m_WindowHandle, g_Allocator, &surface);
+		check_vk_result(err);
+
+		// Create Framebuffers
+		int w, h;
+		glfwGetFramebufferSize(m_WindowHandle, &w, &h);
+		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+		g_VSync = m_Specification.VSync;
+		SetupVulkanWindow(wd, surface, w, h);
+		g_SwapChainRebuild = false;
+		g_SwapChainResizePending = false;
+		uint32_t framesInFlight = glm::clamp(m_Specification.FramesInFlight, 1u, 3u);
+		CreateFramesInFlight(framesInFlight);
+
+		// A frame pipelined on the render thread can still reference resources the main thread frees while building
+		// the next ones, so each frame of depth delays frees by another frame. The +1 is for the frame being built:
+		// its frees land in the slot of the last FrameRender, which is flushed behind the fences of the frames in
+		// flight before it, not its own. Frame arenas are reset when a frame is handed off rather than after its
+		// fence, which takes one more slot.
+		g_RenderThreadDepth = glm::min(m_Specification.RenderThreadDepth, 3u);
+		s_ResourceFreeQueue.resize(framesInFlight + g_RenderThreadDepth + 1);
+		for (ResourceFreeFrame& frame : s_ResourceFreeQueue)
+			frame.Reserve();
+		s_ResourceFreeScratch.Reserve();
+		FrameAllocator::Init((uint32_t)s_ResourceFreeQueue.size() + (g_RenderThreadDepth > 0 ? 1 : 0), m_Specification.FrameArenaSize);
+
+		if (g_HostQueryReset)
+			GpuTimer::Init(g_PhysicalDevice, g_Device, g_QueueFamily, framesInFlight, g_Allocator);
+		endPhase("Swapchain");
+
 		// Setup Platform/Renderer backends
+		Input::Init(m_WindowHandle);
 		ImGui_ImplGlfw_InitForVulkan(m_WindowHandle, true);
 		ImGui_ImplVulkan_InitInfo init_info = {};
 		init_info.Instance = g_Instance;
@@ -476,26 +1501,54 @@ namespace Walnut {
 		init_info.DescriptorPool = g_DescriptorPool;
 		init_info.Subpass = 0;
 		init_info.MinImageCount = g_MinImageCount;
-		init_info.ImageCount = wd->ImageCount;
+		// The backend cycles its vertex buffers by this count, not by the swapchain image
+		init_info.ImageCount = glm::max(wd->ImageCount, framesInFlight);
 		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 		init_info.Allocator = g_Allocator;
 		init_info.CheckVkResultFn = check_vk_result;
 		ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
+		endPhase("ImGui Backend");
 
-		// Load default font
-		ImFontConfig fontConfig;
-		fontConfig.FontDataOwnedByAtlas = false;
-		ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
-		io.FontDefault = robotoFont;
-
-		// Upload Fonts
+		if (g_BindlessTextures)
+		{
+			ImGuiBindlessRenderer::InitInfo bindless_info;
+			bindless_info.PhysicalDevice = g_PhysicalDevice;
+			bindless_info.Device = g_Device;
+			bindless_info.PipelineCache = g_PipelineCache;
+			bindless_info.RenderPass = wd->RenderPass;
+			bindless_info.Allocator = g_Allocator;
+			bindless_info.MaxTextures = m_Specification.MaxBindlessTextures;
+			ImGuiBindlessRenderer::Init(bindless_info);
+
+			// The atlas needs a bindless slot like every other texture, so it is uploaded as a regular Image
+			unsigned char* pixels;
+			int width, height;
+			io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+			g_BindlessFontImage = new Image(width, height, ImageFormat::RGBA, pixels);
+			io.Fonts->SetTexID((ImTextureID)g_BindlessFontImage->GetDescriptorSet());
+		}
+		else
 		{
-			// Use any command queue
-			VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
-			VkCommandBuffer command_buffer = wd->Frames[wd->FrameIndex].CommandBuffer;
+			// Upload Fonts
+			// The upload gets its own pool and fence so that nothing waits on it here. It is submitted before the
+			// first frame on the same queue, so its layout barrier is ordered before any draw that samples the atlas.
+			// The staging objects are released once the fence signals (see ReleaseFontUploadResources).
+			VkCommandPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			pool_info.queueFamilyIndex = g_QueueFamily;
+			err = vkCreateCommandPool(g_Device, &pool_info, g_Allocator, &s_FontUploadCommandPool);
+			check_vk_result(err);
 
-			err = vkResetCommandPool(g_Device, command_pool, 0);
+			VkCommandBufferAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			alloc_info.commandPool = s_FontUploadCommandPool;
+			alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			alloc_info.commandBufferCount = 1;
+			VkCommandBuffer command_buffer;
+			err = vkAllocateCommandBuffers(g_Device, &alloc_info, &command_buffer);
 			check_vk_result(err);
+
 			VkCommandBufferBeginInfo begin_info = {};
 			begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 			begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -504,49 +1557,58 @@ namespace Walnut {
 
 			ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
 
+			VkFenceCreateInfo fence_info = {};
+			fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			err = vkCreateFence(g_Device, &fence_info, g_Allocator, &s_FontUploadFence);
+			check_vk_result(err);
+
 			VkSubmitInfo end_info = {};
 			end_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 			end_info.commandBufferCount = 1;
 			end_info.pCommandBuffers = &command_buffer;
 			err = vkEndCommandBuffer(command_buffer);
 			check_vk_result(err);
-			err = vkQueueSubmit(g_Queue, 1, &end_info, VK_NULL_HANDLE);
-			check_vk_result(err);
-
-			err = vkDeviceWaitIdle(g_Device);
+			err = Application::QueueSubmit(1, &end_info, s_FontUploadFence);
 			check_vk_result(err);
-			ImGui_ImplVulkan_DestroyFontUploadObjects();
 		}
+		endPhase("Font Upload Submit");
+		return true;
 	}
 
 	void Application::Shutdown()
 	{
-		for (auto& layer : m_LayerStack)
-			layer->OnDetach();
+		for (LayerStackEntry& entry : m_LayerStack)
+			entry.Handle->OnDetach();
 
 		m_LayerStack.clear();
 
-		// Cleanup
-		VkResult err = vkDeviceWaitIdle(g_Device);
-		check_vk_result(err);
+		m_FrameStatsLayer->OnDetach();
+		m_FrameStatsLayer.reset();
+		m_MemoryInspectorLayer->OnDetach();
+		m_MemoryInspectorLayer.reset();
 
-		// Free resources in queue
-		for (auto& queue : s_ResourceFreeQueue)
+		InputRecorder::EndRecording();
+		InputRecorder::EndReplay();
+
+		// Cleanup
 		{
-			for (auto& func : queue)
-				func();
+			std::scoped_lock<std::mutex> lock(s_QueueMutex);
+			VkResult err = vkDeviceWaitIdle(g_Device);
+			check_vk_result(err);
 		}
-		s_ResourceFreeQueue.clear();
 
-		ImGui_ImplVulkan_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
-		ImGui::DestroyContext();
+		if (m_RestartRequested)
+		{
+			// Whatever the layers released must be gone before the next Application starts
+			for (uint32_t i = 0; i < (uint32_t)s_ResourceFreeQueue.size(); i++)
+				FlushResourceFreeQueue(i);
 
-		CleanupVulkanWindow();
-		CleanupVulkan();
+			s_RestartWindow = m_WindowHandle;
+			s_RestartSpecification = m_Specification;
+			return;
+		}
 
-		glfwDestroyWindow(m_WindowHandle);
-		glfwTerminate();
+		DestroyContext(m_WindowHandle);
 
 		g_ApplicationRunning = false;
 	}
@@ -559,42 +1621,125 @@ namespace Walnut {
 		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 		ImGuiIO& io = ImGui::GetIO();
 
+		Profiler::SetThreadName("Main Thread");
+		Histogram& frameTimeHistogram = MetricsRegistry::GetHistogram("Walnut/FrameTime(us)");
+		Counter& uploadBytesCounter = MetricsRegistry::GetCounter("Walnut/ImageUploadBytes");
+		Histogram& swapchainRebuildHistogram = MetricsRegistry::GetHistogram("Walnut/SwapchainRebuild(us)");
+		Counter& swapchainRebuildCounter = MetricsRegistry::GetCounter("Walnut/SwapchainRebuilds");
+		int64_t lastUploadBytes = uploadBytesCounter.Get();
+
+		if (g_RenderThreadDepth > 0)
+			StartRenderThread(g_RenderThreadDepth);
+
 		// Main loop
 		while (!glfwWindowShouldClose(m_WindowHandle) && m_Running)
 		{
+			Profiler::MarkFrame();
+			WL_PROFILE_SCOPE("Application::Run Frame");
+
+			FrameStatsSample frameStats;
+			// The render thread reports the last frame it presented
+			if (!s_RenderThread)
+			{
+				s_FenceWaitMillis = 0.0f;
+				s_PresentMillis = 0.0f;
+			}
+			m_FrameStats.SetLayerCount((uint32_t)m_LayerStack.size());
+
 			// Poll and handle events (inputs, window resize, etc.)
 			// You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
 			// - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
 			// - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
 			// Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-			glfwPollEvents();
+			{
+				WL_PROFILE_SCOPE("Poll Events");
+				glfwPollEvents();
+			}
+			Timer inputTimer;
+
+			InputSnapshot input = Input::CaptureFrame();
+			if (!InputRecorder::BeginFrame(input))
+			{
+				// Replay has ended, or stopped on a corrupt frame
+				InputRecorder::EndReplay();
+				m_Running = false;
+				break;
+			}
+			Input::Publish(input);
+			if (InputRecorder::IsReplaying())
+				m_TimeStep = InputRecorder::GetReplayTimeStep();
 
-			for (auto& layer : m_LayerStack)
-				layer->OnUpdate(m_TimeStep);
+			ReleaseFontUploadResources(false);
+			UploadFontSizes();
+			if (s_RenderThread)
+				RunMainThreadFuncs();
+
+			{
+				WL_PROFILE_SCOPE("Layer OnUpdate");
+				Timer layerTimer;
+				for (uint32_t i = 0; i < (uint32_t)m_LayerStack.size(); i++)
+				{
+					// Indexed throughout, a layer pushing another one can reallocate the stack
+					m_LayerStack[i].UpdateTime += m_TimeStep;
+					m_LayerStack[i].UpdateFrames++;
+					if (!ShouldUpdateLayer(m_LayerStack[i]))
+					{
+						m_FrameStats.AddLayerUpdate(i, 0.0f);
+						continue;
+					}
+
+					std::shared_ptr<Layer> layer = m_LayerStack[i].Handle;
+					float ts = m_LayerStack[i].UpdateTime;
+					layerTimer.Reset();
+					layer->OnUpdate(ts);
+					float millis = layerTimer.ElapsedMillis();
+					m_FrameStats.AddLayerUpdate(i, millis);
+					frameStats.UpdateMillis += millis;
+
+					LayerStackEntry& entry = m_LayerStack[i];
+					entry.UpdateTime = 0.0f;
+					entry.UpdateFrames = 0;
+					entry.UpdateMillis += (millis - entry.UpdateMillis) * s_LayerCostSmoothing;
+				}
+				UpdateLayerThrottles();
+			}
 
-			// Resize swap chain?
-			if (g_SwapChainRebuild)
+			// Resize swap chain? An out of date swapchain can't be presented to and is rebuilt right away, size changes
+			// wait for ResizeDebounceMillis so that dragging the window edge doesn't rebuild every frame
+			bool rebuildSwapchain = g_SwapChainRebuild;
+			if (!rebuildSwapchain && g_SwapChainResizePending)
 			{
+				double time = glfwGetTime();
+				double debounce = m_Specification.ResizeDebounceMillis / 1000.0;
+				rebuildSwapchain = time - s_LastResizeTime >= debounce || time - s_ResizePendingSince >= debounce * 4.0;
+			}
+			if (rebuildSwapchain)
+			{
+				WL_PROFILE_SCOPE("Swapchain Rebuild");
 				int width, height;
 				glfwGetFramebufferSize(m_WindowHandle, &width, &height);
 				if (width > 0 && height > 0)
 				{
+					ScopedHistogramTimer rebuildTimer(swapchainRebuildHistogram);
+					// Only the frames handed to the render thread have to finish, the GPU keeps running
+					if (s_RenderThread)
+						WaitForRenderThread();
 					ImGui_ImplVulkan_SetMinImageCount(g_MinImageCount);
-					ImGui_ImplVulkanH_CreateOrResizeWindow(g_Instance, g_PhysicalDevice, g_Device, &g_MainWindowData, g_QueueFamily, g_Allocator, width, height, g_MinImageCount);
-					g_MainWindowData.FrameIndex = 0;
-
-					// Clear allocated command buffers from here since entire pool is destroyed
-					s_AllocatedCommandBuffers.clear();
-					s_AllocatedCommandBuffers.resize(g_MainWindowData.ImageCount);
-
+					CreateOrResizeWindow(&g_MainWindowData, width, height);
 					g_SwapChainRebuild = false;
+					g_SwapChainResizePending = false;
+					swapchainRebuildCounter.Increment();
 				}
 			}
 
 			// Start the Dear ImGui frame
-			ImGui_ImplVulkan_NewFrame();
-			ImGui_ImplGlfw_NewFrame();
-			ImGui::NewFrame();
+			{
+				WL_PROFILE_SCOPE("ImGui NewFrame");
+				ImGui_ImplVulkan_NewFrame();
+				ImGui_ImplGlfw_NewFrame();
+				InputRecorder::ProcessImGuiEvents();
+				ImGui::NewFrame();
+			}
 
 			{
 				static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
@@ -647,40 +1792,280 @@ namespace Walnut {
 					}
 				}
 
-				for (auto& layer : m_LayerStack)
-					layer->OnUIRender();
+				{
+					WL_PROFILE_SCOPE("Layer OnUIRender");
+					Timer layerTimer;
+					for (uint32_t i = 0; i < (uint32_t)m_LayerStack.size(); i++)
+					{
+						const LayerStackEntry& entry = m_LayerStack[i];
+						if (entry.Popped || !entry.Schedule.Enabled)
+						{
+							m_FrameStats.AddLayerUIRender(i, 0.0f);
+							continue;
+						}
+
+						std::string windowName = entry.Schedule.WindowName;
+						if (entry.Hidden)
+						{
+							// Keeps the dock tab (or the collapsed title bar) so it can be brought back
+							ImGui::Begin(windowName.c_str());
+							ImGui::End();
+							m_FrameStats.AddLayerUIRender(i, 0.0f);
+						}
+						else
+						{
+							std::shared_ptr<Layer> layer = entry.Handle;
+							layerTimer.Reset();
+							layer->OnUIRender();
+							float millis = layerTimer.ElapsedMillis();
+							m_FrameStats.AddLayerUIRender(i, millis);
+							frameStats.UIRenderMillis += millis;
+						}
+
+						m_LayerStack[i].Hidden = IsWindowHidden(windowName);
+						m_FrameStats.SetLayerState(i, m_LayerStack[i].Throttle, m_LayerStack[i].Hidden);
+					}
+				}
+
+				m_FrameStatsLayer->OnUIRender();
+				m_MemoryInspectorLayer->OnUIRender();
 
 				ImGui::End();
 			}
 
+			RemovePoppedLayers();
+
 			// Rendering
-			ImGui::Render();
+			{
+				WL_PROFILE_SCOPE("ImGui Render");
+				ImGui::Render();
+			}
 			ImDrawData* main_draw_data = ImGui::GetDrawData();
 			const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
-			wd->ClearValue.color.float32[0] = clear_color.x * clear_color.w;
-			wd->ClearValue.color.float32[1] = clear_color.y * clear_color.w;
-			wd->ClearValue.color.float32[2] = clear_color.z * clear_color.w;
-			wd->ClearValue.color.float32[3] = clear_color.w;
+			VkClearValue clear_value = {};
+			clear_value.color.float32[0] = clear_color.x * clear_color.w;
+			clear_value.color.float32[1] = clear_color.y * clear_color.w;
+			clear_value.color.float32[2] = clear_color.z * clear_color.w;
+			clear_value.color.float32[3] = clear_color.w;
 			if (!main_is_minimized)
-				FrameRender(wd, main_draw_data);
+			{
+				if (s_RenderThread)
+				{
+					frameStats.RenderWaitMillis = SubmitRenderThreadFrame(main_draw_data, clear_value, inputTimer);
+					FrameAllocator::BeginFrame(++s_ArenaFrameIndex);
+				}
+				else
+				{
+					wd->ClearValue = clear_value;
+					FrameRender(wd, main_draw_data);
+				}
+			}
+
+			for (int i = 0; i < main_draw_data->CmdListsCount; i++)
+				frameStats.DrawCalls += (uint32_t)main_draw_data->CmdLists[i]->CmdBuffer.Size;
+			frameStats.Vertices = (uint32_t)main_draw_data->TotalVtxCount;
+			frameStats.Indices = (uint32_t)main_draw_data->TotalIdxCount;
 
 			// Update and Render additional Platform Windows
 			if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 			{
+				WL_PROFILE_SCOPE("Platform Windows");
 				ImGui::UpdatePlatformWindows();
+				// The backend submits and presents on g_Queue
+				std::scoped_lock<std::mutex> lock(s_QueueMutex);
 				ImGui::RenderPlatformWindowsDefault();
 			}
 
 			// Present Main Platform Window
-			if (!main_is_minimized)
+			if (!main_is_minimized && !s_RenderThread)
+			{
 				FramePresent(wd);
+				if (!g_SwapChainRebuild)
+					RecordInputLatency(inputTimer);
+			}
+
+			if (m_StartupReport.FirstFrameMilliseconds == 0.0f)
+				m_StartupReport.FirstFrameMilliseconds = m_StartupTimer.ElapsedMillis();
 
 			float time = GetTime();
 			m_FrameTime = time - m_LastFrameTime;
-			m_TimeStep = glm::min<float>(m_FrameTime, 0.0333f);
+			m_TimeStep = m_Specification.FixedTimeStep > 0.0f ? m_Specification.FixedTimeStep : glm::min<float>(m_FrameTime, 0.0333f);
 			m_LastFrameTime = time;
+
+			frameTimeHistogram.Record((uint64_t)(m_FrameTime * 1000000.0f));
+
+			int64_t uploadBytes = uploadBytesCounter.Get();
+			frameStats.FrameMillis = m_FrameTime * 1000.0f;
+			frameStats.FenceWaitMillis = s_FenceWaitMillis;
+			frameStats.PresentMillis = s_PresentMillis;
+			frameStats.InputLatencyMillis = s_InputLatencyMillis;
+			frameStats.UploadBytes = (uint64_t)(uploadBytes - lastUploadBytes);
+			lastUploadBytes = uploadBytes;
+			m_FrameStats.AddSample(frameStats);
+			MetricsRegistry::Update();
+		}
+
+		if (s_RenderThread)
+			StopRenderThread();
+	}
+
+	void Application::PushLayer(const std::shared_ptr<Layer>& layer, const LayerSchedule& schedule)
+	{
+		LayerStackEntry& entry = m_LayerStack.emplace_back();
+		entry.Handle = layer;
+		entry.Schedule = schedule;
+		layer->OnAttach();
+	}
+
+	void Application::PopLayer(Layer* layer)
+	{
+		if (LayerStackEntry* entry = FindLayer(layer))
+			entry->Popped = true;
+	}
+
+	void Application::SetLayerEnabled(Layer* layer, bool enabled)
+	{
+		if (LayerStackEntry* entry = FindLayer(layer))
+			entry->Schedule.Enabled = enabled;
+	}
+
+	bool Application::IsLayerEnabled(Layer* layer) const
+	{
+		const LayerStackEntry* entry = FindLayer(layer);
+		return entry && entry->Schedule.Enabled;
+	}
+
+	void Application::SetLayerSchedule(Layer* layer, const LayerSchedule& schedule)
+	{
+		if (LayerStackEntry* entry = FindLayer(layer))
+		{
+			entry->Schedule = schedule;
+			entry->Throttle = 1;
+		}
+	}
+
+	const LayerSchedule* Application::GetLayerSchedule(Layer* layer) const
+	{
+		const LayerStackEntry* entry = FindLayer(layer);
+		return entry ? &entry->Schedule : nullptr;
+	}
+
+	uint32_t Application::GetLayerThrottle(Layer* layer) const
+	{
+		const LayerStackEntry* entry = FindLayer(layer);
+		return entry ? entry->Throttle : 1;
+	}
+
+	Application::LayerStackEntry* Application::FindLayer(Layer* layer)
+	{
+		for (LayerStackEntry& entry : m_LayerStack)
+		{
+			if (entry.Handle.get() == layer && !entry.Popped)
+				return &entry;
+		}
+		return nullptr;
+	}
+
+	const Application::LayerStackEntry* Application::FindLayer(Layer* layer) const
+	{
+		return const_cast<Application*>(this)->FindLayer(layer);
+	}
+
+	bool Application::ShouldUpdateLayer(const LayerStackEntry& entry) const
+	{
+		if (entry.Popped || !entry.Schedule.Enabled || (entry.Hidden && !entry.Schedule.UpdateWhenHidden))
+			return false;
+
+		if (entry.Schedule.UpdateRate > 0.0f)
+			return entry.UpdateTime >= (float)entry.Throttle / entry.Schedule.UpdateRate;
+		return entry.UpdateFrames >= glm::max(entry.Schedule.UpdateDivider, 1u) * entry.Throttle;
+	}
+
+	void Application::UpdateLayerThrottles()
+	{
+		// Suspended layers start from a fresh ts once they run again
+		for (LayerStackEntry& entry : m_LayerStack)
+		{
+			if (!entry.Schedule.Enabled || (entry.Hidden && !entry.Schedule.UpdateWhenHidden))
+			{
+				entry.UpdateTime = 0.0f;
+				entry.UpdateFrames = 0;
+			}
+		}
+
+		// Re-evaluated at the rate the costs are smoothed over, so a throttled layer doesn't flip back and forth
+		if (++m_LayerThrottleFrame < s_LayerThrottlePeriod)
+			return;
+		m_LayerThrottleFrame = 0;
+
+		// Milliseconds per frame of a layer at a given throttle, counting its divider or rate
+		auto amortizedMillis = [this](const LayerStackEntry& entry, uint32_t throttle)
+		{
+			float updatesPerFrame = 1.0f / (float)(glm::max(entry.Schedule.UpdateDivider, 1u) * throttle);
+			if (entry.Schedule.UpdateRate > 0.0f && m_TimeStep > 0.0f)
+				updatesPerFrame = glm::min(entry.Schedule.UpdateRate * m_TimeStep / (float)throttle, 1.0f);
+			return entry.UpdateMillis * updatesPerFrame;
+		};
+
+		float totalMillis = 0.0f;
+		for (LayerStackEntry& entry : m_LayerStack)
+		{
+			entry.Throttle = 1;
+			if (entry.Schedule.BudgetMillis > 0.0f)
+			{
+				while (entry.Throttle < s_MaxLayerThrottle && amortizedMillis(entry, entry.Throttle) > entry.Schedule.BudgetMillis)
+					entry.Throttle *= 2;
+			}
+
+			if (entry.Schedule.Enabled && !entry.Popped)
+				totalMillis += amortizedMillis(entry, entry.Throttle);
+		}
+
+		if (m_Specification.LayerBudgetMillis <= 0.0f)
+			return;
+
+		// Halve the update rate of the most expensive layer that still can be, until the frame fits
+		while (totalMillis > m_Specification.LayerBudgetMillis)
+		{
+			LayerStackEntry* mostExpensive = nullptr;
+			float mostExpensiveMillis = 0.0f;
+			for (LayerStackEntry& entry : m_LayerStack)
+			{
+				if (!entry.Schedule.AllowThrottle || !entry.Schedule.Enabled || entry.Popped || entry.Throttle >= s_MaxLayerThrottle)
+					continue;
+
+				float millis = amortizedMillis(entry, entry.Throttle);
+				if (millis > mostExpensiveMillis)
+				{
+					mostExpensive = &entry;
+					mostExpensiveMillis = millis;
+				}
+			}
+
+			if (!mostExpensive)
+				break;
+
+			mostExpensive->Throttle *= 2;
+			totalMillis -= mostExpensiveMillis - amortizedMillis(*mostExpensive, mostExpensive->Throttle);
 		}
+	}
+
+	void Application::RemovePoppedLayers()
+	{
+		for (uint32_t i = 0; i < (uint32_t)m_LayerStack.size();)
+		{
+			if (!m_LayerStack[i].Popped)
+			{
+				i++;
+				continue;
+			}
 
+			// Erased first, OnDetach may push or pop layers itself
+			std::shared_ptr<Layer> layer = std::move(m_LayerStack[i].Handle);
+			m_LayerStack.erase(m_LayerStack.begin() + i);
+			m_FrameStats.RemoveLayer(i);
+			layer->OnDetach();
+		}
 	}
 
 	void Application::Close()
@@ -688,6 +2073,12 @@ namespace Walnut {
 		m_Running = false;
 	}
 
+	void Application::Restart()
+	{
+		m_RestartRequested = true;
+		m_Running = false;
+	}
+
 	float Application::GetTime()
 	{
 		return (float)glfwGetTime();
@@ -708,21 +2099,116 @@ namespace Walnut {
 		return g_Device;
 	}
 
-	VkCommandBuffer Application::GetCommandBuffer(bool begin)
+	const VkAllocationCallbacks* Application::GetAllocator()
 	{
-		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
+		return g_Allocator;
+	}
+
+	VkPipelineCache Application::GetPipelineCache()
+	{
+		return g_PipelineCache;
+	}
+
+	VkDescriptorPool Application::GetDescriptorPool()
+	{
+		return g_DescriptorPool;
+	}
+
+	std::vector<GpuTiming> Application::GetGpuTimings()
+	{
+		return GpuTimer::GetTimings();
+	}
+
+	FrameArena& Application::GetFrameArena()
+	{
+		return FrameAllocator::Get();
+	}
+
+	void Application::SetFrameStatsVisible(bool visible)
+	{
+		m_FrameStatsLayer->SetVisible(visible);
+	}
+
+	bool Application::IsFrameStatsVisible() const
+	{
+		return m_FrameStatsLayer->IsVisible();
+	}
+
+	void Application::SetMemoryInspectorVisible(bool visible)
+	{
+		m_MemoryInspectorLayer->SetVisible(visible);
+	}
+
+	bool Application::IsMemoryInspectorVisible() const
+	{
+		return m_MemoryInspectorLayer->IsVisible();
+	}
+
+	bool Application::IsBindlessEnabled()
+	{
+		return g_BindlessTextures;
+	}
 
-		// Use any command queue
-		VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
+	ImFont* Application::GetFont(float size)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		if (size == s_DefaultFontSize)
+			return io.FontDefault;
+
+		for (const std::unique_ptr<FontSizeAtlas>& fontSize : s_FontSizes)
+		{
+			if (fontSize->Size == size)
+				return fontSize->Texture ? fontSize->Font : io.FontDefault;
+		}
+
+		FontSizeAtlas* fontSize = s_FontSizes.emplace_back(std::make_unique<FontSizeAtlas>()).get();
+		fontSize->Size = size;
+		fontSize->Atlas = new ImFontAtlas();
 
+		ImFontConfig fontConfig;
+		fontConfig.FontDataOwnedByAtlas = false;
+		fontSize->Font = fontSize->Atlas->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), size, &fontConfig);
+		return io.FontDefault;
+	}
+
+	// The calling thread's pool, created on first use
+	static VkCommandPool GetThreadCommandPool()
+	{
+		ThreadCommandPool& threadPool = s_ThreadCommandPool;
+		uint64_t generation = s_CommandPoolGeneration.load();
+		if (threadPool.Pool && threadPool.Generation == generation)
+			return threadPool.Pool;
+
+		std::scoped_lock<std::mutex> lock(s_CommandPoolsMutex);
+		threadPool.Generation = generation;
+		if (!s_FreeCommandPools.empty())
+		{
+			threadPool.Pool = s_FreeCommandPools.back();
+			s_FreeCommandPools.pop_back();
+			return threadPool.Pool;
+		}
+
+		VkCommandPoolCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		info.queueFamilyIndex = g_QueueFamily;
+		VkResult err = vkCreateCommandPool(g_Device, &info, g_Allocator, &threadPool.Pool);
+		check_vk_result(err);
+		s_CommandPools.push_back(threadPool.Pool);
+		return threadPool.Pool;
+	}
+
+	VkCommandBuffer Application::GetCommandBuffer(bool begin)
+	{
 		VkCommandBufferAllocateInfo cmdBufAllocateInfo = {};
 		cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cmdBufAllocateInfo.commandPool = command_pool;
+		cmdBufAllocateInfo.commandPool = GetThreadCommandPool();
 		cmdBufAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 		cmdBufAllocateInfo.commandBufferCount = 1;
 
-		VkCommandBuffer& command_buffer = s_AllocatedCommandBuffers[wd->FrameIndex].emplace_back();
+		VkCommandBuffer command_buffer;
 		auto err = vkAllocateCommandBuffers(g_Device, &cmdBufAllocateInfo, &command_buffer);
+		check_vk_result(err);
 
 		VkCommandBufferBeginInfo begin_info = {};
 		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -749,22 +2235,71 @@ namespace Walnut {
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceCreateInfo.flags = 0;
 		VkFence fence;
-		err = vkCreateFence(g_Device, &fenceCreateInfo, nullptr, &fence);
+		err = vkCreateFence(g_Device, &fenceCreateInfo, g_Allocator, &fence);
 		check_vk_result(err);
 
-		err = vkQueueSubmit(g_Queue, 1, &end_info, fence);
+		err = QueueSubmit(1, &end_info, fence);
 		check_vk_result(err);
 
 		err = vkWaitForFences(g_Device, 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT);
 		check_vk_result(err);
 
-		vkDestroyFence(g_Device, fence, nullptr);
+		vkDestroyFence(g_Device, fence, g_Allocator);
+		vkFreeCommandBuffers(g_Device, GetThreadCommandPool(), 1, &commandBuffer);
 	}
 
+	VkResult Application::QueueSubmit(uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence)
+	{
+		std::scoped_lock<std::mutex> lock(s_QueueMutex);
+		return vkQueueSubmit(g_Queue, submitCount, submits, fence);
+	}
+
+	std::mutex& Application::GetDescriptorPoolMutex()
+	{
+		return s_DescriptorPoolMutex;
+	}
+
+	bool Application::IsMainThread()
+	{
+		return std::this_thread::get_id() == s_MainThread;
+	}
+
+	bool Application::IsRenderThread()
+	{
+		return s_RenderThreadRunning ? s_IsRenderThread : IsMainThread();
+	}
+
+	void Application::SubmitResourceFree(ResourceType type, uint64_t handle)
+	{
+		if (handle == 0)
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_ResourceFreeQueueMutex);
+		s_ResourceFreeQueue[s_CurrentFrameIndex].Records.push_back({ type, handle });
+	}
 
 	void Application::SubmitResourceFree(std::function<void()>&& func)
 	{
-		s_ResourceFreeQueue[s_CurrentFrameIndex].emplace_back(func);
+		std::scoped_lock<std::mutex> lock(s_ResourceFreeQueueMutex);
+		s_ResourceFreeQueue[s_CurrentFrameIndex].Funcs.emplace_back(std::move(func));
+	}
+
+	void Application::SubmitFrameCommands(std::function<void(VkCommandBuffer)>&& func)
+	{
+		std::scoped_lock<std::mutex> lock(s_FrameCommandsMutex);
+		s_FrameCommands.emplace_back(std::move(func));
+	}
+
+	uint32_t Application::GetFramesInFlight()
+	{
+		return (uint32_t)s_ResourceFreeQueue.size();
+	}
+
+	uint32_t Application::GetPendingResourceFreeCount(uint32_t frameIndex)
+	{
+		std::scoped_lock<std::mutex> lock(s_ResourceFreeQueueMutex);
+		const ResourceFreeFrame& frame = s_ResourceFreeQueue[frameIndex];
+		return (uint32_t)(frame.Records.size() + frame.Funcs.size());
 	}
 
 }
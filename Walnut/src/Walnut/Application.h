@@ -1,11 +1,17 @@
 #pragma once
 
 #include "Layer.h"
+#include "Timer.h"
+#include "GpuTimer.h"
+#include "FrameStats.h"
+#include "FrameCapture.h"
+#include "FrameAllocator.h"
 
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <mutex>
 
 #include "imgui.h"
 #include "vulkan/vulkan.h"
@@ -21,8 +27,89 @@ namespace Walnut {
 		std::string Name = "Walnut App";
 		uint32_t Width = 1600;
 		uint32_t Height = 900;
+
+		// Sample every Image from one descriptor array instead of one descriptor set per image.
+		// Needs descriptor indexing (Vulkan 1.2), otherwise per-image sets are used. Disables multi-viewport.
+		bool BindlessTextures = false;
+		uint32_t MaxBindlessTextures = 4096;
+
+		bool VSync = true;
+		// Window size changes rebuild the swapchain once the size has been unchanged for this long (a continuous drag
+		// still rebuilds every four intervals). Until then the old images are scaled to the window. 0 rebuilds right away.
+		float ResizeDebounceMillis = 50.0f;
+		// Hidden window, no multi-viewport and no imgui.ini. Doesn't need a display server with GLFW 3.4+.
+		bool Headless = false;
+		// Passed to OnUpdate instead of the measured frame time when > 0, for deterministic runs
+		float FixedTimeStep = 0.0f;
+
+		// Records input to InputRecordPath, or replays InputReplayPath and closes the application when it ends
+		std::string InputRecordPath;
+		std::string InputReplayPath;
+
+		// Captures presented frames from startup on when Path is set, see FrameCapture
+		FrameCaptureSpecification Capture;
+
+		// Rasterized font atlases are cached here (relative to the working directory, like imgui.ini) so that
+		// later launches skip rasterization. Empty disables the cache.
+		std::string FontCacheDirectory = "WalnutCache";
+
+		// Initial size of each frame's scratch arena (Application::GetFrameArena). Arenas grow to fit the
+		// largest frame, FrameAllocator::GetStats has the high-water marks to size this with.
+		size_t FrameArenaSize = 256 * 1024;
+
+		// All layers' OnUpdate milliseconds per frame, 0 disables. While the layers go over it, the most expensive ones
+		// with LayerSchedule::AllowThrottle are updated less often.
+		float LayerBudgetMillis = 0.0f;
+
+		// Frames the main thread may build ahead of a render thread that acquires, submits and presents them from a
+		// copy of the draw data, so blocking on the swapchain or the GPU overlaps the next frame's layers. 0 renders on
+		// the main thread. Clamped to 3; every frame of depth adds a frame in flight (GetFramesInFlight).
+		uint32_t RenderThreadDepth = 0;
+
+		// Frames the GPU may be working on while the CPU records the next one, 1-3. Command buffers, fences and the
+		// per-frame rings are sized by it whatever the swapchain image count is. Fewer is lower latency, more keeps
+		// the GPU busier when frame times vary.
+		uint32_t FramesInFlight = 2;
+
+		// Built-in frame statistics overlay, ImGuiKey_None disables the toggle key
+		bool ShowFrameStats = false;
+		ImGuiKey FrameStatsToggleKey = ImGuiKey_F3;
+		// Built-in memory inspector window (see MemoryTracker)
+		bool ShowMemoryInspector = false;
+		ImGuiKey MemoryInspectorToggleKey = ImGuiKey_F4;
+	};
+
+	// Vulkan objects that can be handed to the deferred free queue without a closure.
+	// Listed in the order they are destroyed within a frame.
+	enum class ResourceType : uint8_t
+	{
+		BindlessTexture = 0, // Handle is the ImTextureID
+		DescriptorSet,
+		Sampler,
+		ImageView,
+		Image,
+		Buffer,
+		DeviceMemory,
+		Count
+	};
+
+	struct StartupPhase
+	{
+		std::string Name;
+		float Milliseconds = 0.0f;
+		bool Async = false; // Ran on a worker thread, overlapping other phases
+	};
+
+	struct StartupReport
+	{
+		std::vector<StartupPhase> Phases;
+		float InitMilliseconds = 0.0f;
+		float FirstFrameMilliseconds = 0.0f; // From Init() until the first frame was presented
 	};
 
+	class FrameStatsLayer;
+	class MemoryInspectorLayer;
+
 	class Application
 	{
 	public:
@@ -35,40 +122,132 @@ namespace Walnut {
 		void SetMenubarCallback(const std::function<void()>& menubarCallback) { m_MenubarCallback = menubarCallback; }
 		
 		template<typename T>
-		void PushLayer()
+		void PushLayer(const LayerSchedule& schedule = LayerSchedule())
 		{
 			static_assert(std::is_base_of<Layer, T>::value, "Pushed type is not subclass of Layer!");
-			m_LayerStack.emplace_back(std::make_shared<T>())->OnAttach();
+			PushLayer(std::make_shared<T>(), schedule);
 		}
 
-		void PushLayer(const std::shared_ptr<Layer>& layer) { m_LayerStack.emplace_back(layer); layer->OnAttach(); }
+		void PushLayer(const std::shared_ptr<Layer>& layer, const LayerSchedule& schedule = LayerSchedule());
+		// The layer is detached at the end of the frame, so a layer can pop itself
+		void PopLayer(Layer* layer);
+
+		void SetLayerEnabled(Layer* layer, bool enabled);
+		bool IsLayerEnabled(Layer* layer) const;
+		void SetLayerSchedule(Layer* layer, const LayerSchedule& schedule);
+		// nullptr if the layer isn't on the stack
+		const LayerSchedule* GetLayerSchedule(Layer* layer) const;
+		// Frames between two OnUpdates added by the budgets, 1 while the layer isn't throttled
+		uint32_t GetLayerThrottle(Layer* layer) const;
 
 		void Close();
+		// Ends Run so that Main calls CreateApplication again, but keeps the window, Vulkan device, swapchain,
+		// pipelines and font atlas alive for the next Application. Only layers and user state are rebuilt.
+		// Changing Headless or the bindless settings in the new specification falls back to a full restart.
+		void Restart();
 
 		float GetTime();
 		GLFWwindow* GetWindowHandle() const { return m_WindowHandle; }
 
+		const StartupReport& GetStartupReport() const { return m_StartupReport; }
+
+		float GetFrameTime() const { return m_FrameTime; }
+		float GetTimeStep() const { return m_TimeStep; }
+		const FrameStats& GetFrameStats() const { return m_FrameStats; }
+		void SetFrameStatsVisible(bool visible);
+		bool IsFrameStatsVisible() const;
+		void SetMemoryInspectorVisible(bool visible);
+		bool IsMemoryInspectorVisible() const;
+
 		static VkInstance GetInstance();
 		static VkPhysicalDevice GetPhysicalDevice();
 		static VkDevice GetDevice();
+		// Pass to every vkCreate/vkDestroy, see MemoryTracker
+		static const VkAllocationCallbacks* GetAllocator();
+		static VkPipelineCache GetPipelineCache();
+		// Allows freeing individual sets, which go through SubmitResourceFree(ResourceType::DescriptorSet)
+		static VkDescriptorPool GetDescriptorPool();
+		// Held around vkAllocateDescriptorSets on GetDescriptorPool() (ImGui_ImplVulkan_AddTexture included), the pool isn't thread-safe
+		static std::mutex& GetDescriptorPoolMutex();
+
+		static bool IsBindlessEnabled();
+
+		// The default font at another pixel size. The first request queues it into its own atlas, which is
+		// rasterized (or loaded from the font cache) before a later frame; until then the default font is returned.
+		static ImFont* GetFont(float size);
+
+		// Named GPU scopes (the ImGui pass, uploads, anything wrapped in ScopedGpuTimer) from a few frames ago
+		static std::vector<GpuTiming> GetGpuTimings();
+
+		// Scratch memory for the current frame on the calling thread, see FrameAllocator
+		static FrameArena& GetFrameArena();
 
+		// From a command pool owned by the calling thread, so any thread can record uploads.
+		// Flush it on the thread that got it; FlushCommandBuffer blocks until the GPU is done and frees it.
 		static VkCommandBuffer GetCommandBuffer(bool begin);
 		static void FlushCommandBuffer(VkCommandBuffer commandBuffer);
+		// vkQueueSubmit on the graphics queue, serialized with the frame loop and other threads
+		static VkResult QueueSubmit(uint32_t submitCount, const VkSubmitInfo* submits, VkFence fence);
 
+		static bool IsMainThread();
+		// The thread that records and submits frames: the render thread with RenderThreadDepth > 0, otherwise the main thread
+		static bool IsRenderThread();
+
+		// Destroys the object once the GPU is done with the current frame. Safe to call from any thread, functions run on the main thread.
+		static void SubmitResourceFree(ResourceType type, uint64_t handle);
 		static void SubmitResourceFree(std::function<void()>&& func);
+
+		// Records into the next frame's command buffer before the UI pass, in submission order, on the render thread.
+		// Anything the function references has to stay alive until that frame is done. Safe to call from any thread.
+		static void SubmitFrameCommands(std::function<void(VkCommandBuffer)>&& func);
+
+		// FramesInFlight plus RenderThreadDepth plus the frame being built, what the free queue and per-frame rings
+		// (StreamingImage, FrameCapture) are sized by
+		static uint32_t GetFramesInFlight();
+		static uint32_t GetPendingResourceFreeCount(uint32_t frameIndex);
 	private:
+		struct LayerStackEntry
+		{
+			std::shared_ptr<Layer> Handle;
+			LayerSchedule Schedule;
+
+			float UpdateTime = 0.0f;   // Since the last OnUpdate
+			uint32_t UpdateFrames = 0; // Frames since the last OnUpdate
+			float UpdateMillis = 0.0f; // Smoothed cost of one OnUpdate
+			uint32_t Throttle = 1;
+			bool Hidden = false;
+			bool Popped = false;
+		};
+
 		void Init();
+		bool InitContext();
+		bool ResumeContext();
 		void Shutdown();
+
+		LayerStackEntry* FindLayer(Layer* layer);
+		const LayerStackEntry* FindLayer(Layer* layer) const;
+		bool ShouldUpdateLayer(const LayerStackEntry& entry) const;
+		void UpdateLayerThrottles();
+		void RemovePoppedLayers();
 	private:
 		ApplicationSpecification m_Specification;
 		GLFWwindow* m_WindowHandle = nullptr;
 		bool m_Running = false;
+		bool m_RestartRequested = false;
 
 		float m_TimeStep = 0.0f;
 		float m_FrameTime = 0.0f;
 		float m_LastFrameTime = 0.0f;
 
-		std::vector<std::shared_ptr<Layer>> m_LayerStack;
+		Timer m_StartupTimer;
+		StartupReport m_StartupReport;
+
+		FrameStats m_FrameStats;
+		std::shared_ptr<FrameStatsLayer> m_FrameStatsLayer;
+		std::shared_ptr<MemoryInspectorLayer> m_MemoryInspectorLayer;
+
+		std::vector<LayerStackEntry> m_LayerStack;
+		uint32_t m_LayerThrottleFrame = 0;
 		std::function<void()> m_MenubarCallback;
 	};
 
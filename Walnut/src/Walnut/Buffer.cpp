@@ -0,0 +1,348 @@
+#include "Buffer.h"
+
+#include "Application.h"
+#include "GpuTimer.h"
+#include "Profiler.h"
+#include "Metrics.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace Walnut {
+
+	// Ranges written by SetData since the last upload, non-overlapping
+	struct PendingBufferRegion
+	{
+		uint64_t Offset;
+		std::vector<uint8_t> Data;
+	};
+
+	struct PendingBufferUpdates
+	{
+		std::mutex Mutex;
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		std::vector<PendingBufferRegion> Regions;
+		bool Submitted = false; // A frame command will pick the regions up
+	};
+
+	namespace Utils {
+
+		// vkCmdUpdateBuffer limit, larger regions go through a staging buffer
+		static const uint64_t s_InlineUpdateSize = 65536;
+
+		// Written so that offset + size cannot overflow
+		static bool IsRangeValid(uint64_t offset, uint64_t size, uint64_t bufferSize)
+		{
+			return offset <= bufferSize && size <= bufferSize - offset;
+		}
+
+		static uint32_t GetVulkanMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
+		{
+			VkPhysicalDeviceMemoryProperties prop;
+			vkGetPhysicalDeviceMemoryProperties(Application::GetPhysicalDevice(), &prop);
+			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
+			{
+				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
+					return i;
+			}
+
+			return 0xffffffff;
+		}
+
+		static VkBufferUsageFlags WalnutUsageToVulkanUsage(BufferUsage usage)
+		{
+			VkBufferUsageFlags flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			if (usage & BufferUsage::Vertex)  flags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+			if (usage & BufferUsage::Index)   flags |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+			if (usage & BufferUsage::Storage) flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			if (usage & BufferUsage::Uniform) flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			return flags;
+		}
+
+		static void CreateBuffer(uint64_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties, DeviceMemoryCategory category, VkBuffer& outBuffer, VkDeviceMemory& outMemory)
+		{
+			VkDevice device = Application::GetDevice();
+
+			VkResult err;
+
+			VkBufferCreateInfo buffer_info = {};
+			buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_info.size = size;
+			buffer_info.usage = usage;
+			buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			err = vkCreateBuffer(device, &buffer_info, Application::GetAllocator(), &outBuffer);
+			check_vk_result(err);
+
+			VkMemoryRequirements req;
+			vkGetBufferMemoryRequirements(device, outBuffer, &req);
+			uint32_t memoryType = GetVulkanMemoryType(properties | preferredProperties, req.memoryTypeBits);
+			if (memoryType == 0xffffffff)
+				memoryType = GetVulkanMemoryType(properties, req.memoryTypeBits);
+
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = req.size;
+			alloc_info.memoryTypeIndex = memoryType;
+			err = MemoryTracker::AllocateDeviceMemory(device, alloc_info, category, &outMemory);
+			check_vk_result(err);
+			err = vkBindBufferMemory(device, outBuffer, outMemory, 0);
+			check_vk_result(err);
+		}
+
+		static void RecordUpdates(VkCommandBuffer commandBuffer, PendingBufferUpdates& pending)
+		{
+			std::vector<PendingBufferRegion> regions;
+			VkBuffer buffer;
+			{
+				std::scoped_lock<std::mutex> lock(pending.Mutex);
+				std::swap(regions, pending.Regions);
+				pending.Submitted = false;
+				buffer = pending.Buffer;
+			}
+			if (regions.empty() || !buffer)
+				return;
+
+			ScopedGpuTimer gpuTimer(commandBuffer, "Buffer Upload");
+
+			// Earlier frames and dispatches are done reading and writing the buffer
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+				| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+			// Small aligned regions go inline into the command buffer, the rest share one staging buffer
+			std::vector<VkBufferCopy> copies;
+			std::vector<const PendingBufferRegion*> stagedRegions;
+			uint64_t stagingSize = 0;
+			for (const PendingBufferRegion& region : regions)
+			{
+				uint64_t size = region.Data.size();
+				if (size <= s_InlineUpdateSize && size % 4 == 0 && region.Offset % 4 == 0)
+				{
+					vkCmdUpdateBuffer(commandBuffer, buffer, region.Offset, size, region.Data.data());
+					continue;
+				}
+
+				VkBufferCopy& copy = copies.emplace_back();
+				copy.srcOffset = stagingSize;
+				copy.dstOffset = region.Offset;
+				copy.size = size;
+				stagingSize += size;
+				stagedRegions.push_back(&region);
+			}
+
+			if (!copies.empty())
+			{
+				VkDevice device = Application::GetDevice();
+
+				VkBuffer stagingBuffer;
+				VkDeviceMemory stagingMemory;
+				CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, DeviceMemoryCategory::Staging, stagingBuffer, stagingMemory);
+
+				uint8_t* map = NULL;
+				VkResult err = vkMapMemory(device, stagingMemory, 0, stagingSize, 0, (void**)(&map));
+				check_vk_result(err);
+				for (size_t i = 0; i < copies.size(); i++)
+					memcpy(map + copies[i].srcOffset, stagedRegions[i]->Data.data(), stagedRegions[i]->Data.size());
+				vkUnmapMemory(device, stagingMemory);
+
+				vkCmdCopyBuffer(commandBuffer, stagingBuffer, buffer, (uint32_t)copies.size(), copies.data());
+
+				Application::SubmitResourceFree(ResourceType::Buffer, (uint64_t)stagingBuffer);
+				Application::SubmitResourceFree(ResourceType::DeviceMemory, (uint64_t)stagingMemory);
+			}
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT
+				| VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+				| VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+		}
+
+	}
+
+	Buffer::Buffer(uint64_t size, BufferUsage usage, BufferMemory memory, const void* data)
+		: m_Size(size), m_Usage(usage), m_Memory(memory), m_PendingUpdates(std::make_shared<PendingBufferUpdates>())
+	{
+		AllocateMemory();
+		if (data)
+			SetData(data, m_Size);
+	}
+
+	Buffer::~Buffer()
+	{
+		Release();
+	}
+
+	void Buffer::AllocateMemory()
+	{
+		VkMemoryPropertyFlags properties = m_Memory == BufferMemory::HostVisible
+			? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			: VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		Utils::CreateBuffer(m_Size, Utils::WalnutUsageToVulkanUsage(m_Usage), properties, 0, DeviceMemoryCategory::Buffer, m_Buffer, m_DeviceMemory);
+
+		if (m_Memory == BufferMemory::HostVisible)
+		{
+			VkResult err = vkMapMemory(Application::GetDevice(), m_DeviceMemory, 0, VK_WHOLE_SIZE, 0, &m_MappedData);
+			check_vk_result(err);
+		}
+
+		std::scoped_lock<std::mutex> lock(m_PendingUpdates->Mutex);
+		m_PendingUpdates->Buffer = m_Buffer;
+	}
+
+	void Buffer::Release()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_PendingUpdates->Mutex);
+			m_PendingUpdates->Buffer = VK_NULL_HANDLE;
+			m_PendingUpdates->Regions.clear();
+		}
+
+		// Freeing the memory unmaps it
+		Application::SubmitResourceFree(ResourceType::Buffer, (uint64_t)m_Buffer);
+		Application::SubmitResourceFree(ResourceType::DeviceMemory, (uint64_t)m_DeviceMemory);
+
+		m_Buffer = nullptr;
+		m_DeviceMemory = nullptr;
+		m_MappedData = nullptr;
+	}
+
+	void Buffer::SetData(const void* data, uint64_t size, uint64_t offset)
+	{
+		WL_PROFILE_FUNCTION();
+		static Counter& s_UploadBytes = MetricsRegistry::GetCounter("Walnut/BufferUploadBytes");
+		if (!Utils::IsRangeValid(offset, size, m_Size))
+		{
+			std::cerr << "[Buffer] SetData of " << size << " bytes at offset " << offset << " is out of range of a " << m_Size << " byte buffer\n";
+			return;
+		}
+
+		s_UploadBytes.Increment((int64_t)size);
+
+		if (m_MappedData)
+		{
+			memcpy((uint8_t*)m_MappedData + offset, data, size);
+			return;
+		}
+
+		PendingBufferUpdates& pending = *m_PendingUpdates;
+		std::scoped_lock<std::mutex> lock(pending.Mutex);
+
+		// Merge with the regions this one overlaps or touches, the new bytes on top
+		uint64_t begin = offset, end = offset + size;
+		std::vector<uint8_t> bytes((const uint8_t*)data, (const uint8_t*)data + size);
+		for (auto it = pending.Regions.begin(); it != pending.Regions.end();)
+		{
+			uint64_t regionBegin = it->Offset, regionEnd = it->Offset + it->Data.size();
+			if (regionEnd < begin || regionBegin > end)
+			{
+				++it;
+				continue;
+			}
+
+			uint64_t mergedBegin = std::min(begin, regionBegin), mergedEnd = std::max(end, regionEnd);
+			std::vector<uint8_t> merged(mergedEnd - mergedBegin);
+			memcpy(merged.data() + (regionBegin - mergedBegin), it->Data.data(), it->Data.size());
+			memcpy(merged.data() + (begin - mergedBegin), bytes.data(), bytes.size());
+			begin = mergedBegin;
+			end = mergedEnd;
+			bytes = std::move(merged);
+			it = pending.Regions.erase(it);
+		}
+		pending.Regions.push_back({ begin, std::move(bytes) });
+
+		if (!pending.Submitted)
+		{
+			pending.Submitted = true;
+			Application::SubmitFrameCommands([pendingUpdates = m_PendingUpdates](VkCommandBuffer commandBuffer)
+			{
+				Utils::RecordUpdates(commandBuffer, *pendingUpdates);
+			});
+		}
+	}
+
+	void Buffer::ReadData(std::function<void(const void* data, uint64_t size)>&& callback, uint64_t offset, uint64_t size)
+	{
+		if (size == VK_WHOLE_SIZE && offset <= m_Size)
+			size = m_Size - offset;
+		if (!Utils::IsRangeValid(offset, size, m_Size))
+		{
+			std::cerr << "[Buffer] ReadData of " << size << " bytes at offset " << offset << " is out of range of a " << m_Size << " byte buffer\n";
+			return;
+		}
+
+		// The range was checked against this buffer. If it has been resized or released since, the handle is already
+		// queued for freeing and the read is dropped.
+		Application::SubmitFrameCommands([pendingUpdates = m_PendingUpdates, buffer = m_Buffer, offset, size, callback = std::move(callback)](VkCommandBuffer commandBuffer) mutable
+		{
+			{
+				std::scoped_lock<std::mutex> lock(pendingUpdates->Mutex);
+				if (pendingUpdates->Buffer != buffer)
+					return;
+			}
+
+			ScopedGpuTimer gpuTimer(commandBuffer, "Buffer Readback");
+
+			VkBuffer readbackBuffer;
+			VkDeviceMemory readbackMemory;
+			Utils::CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, DeviceMemoryCategory::Readback, readbackBuffer, readbackMemory);
+
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+			VkBufferCopy copy = {};
+			copy.srcOffset = offset;
+			copy.size = size;
+			vkCmdCopyBuffer(commandBuffer, buffer, readbackBuffer, 1, &copy);
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+			// Runs once this frame's fence has signaled
+			Application::SubmitResourceFree([readbackBuffer, readbackMemory, size, callback = std::move(callback)]()
+			{
+				VkDevice device = Application::GetDevice();
+
+				void* map = NULL;
+				VkResult err = vkMapMemory(device, readbackMemory, 0, VK_WHOLE_SIZE, 0, &map);
+				check_vk_result(err);
+				VkMappedMemoryRange range = {};
+				range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+				range.memory = readbackMemory;
+				range.size = VK_WHOLE_SIZE;
+				err = vkInvalidateMappedMemoryRanges(device, 1, &range);
+				check_vk_result(err);
+
+				callback(map, size);
+
+				vkUnmapMemory(device, readbackMemory);
+				vkDestroyBuffer(device, readbackBuffer, Application::GetAllocator());
+				MemoryTracker::FreeDeviceMemory(device, readbackMemory);
+			});
+		});
+	}
+
+	void Buffer::Resize(uint64_t size)
+	{
+		if (m_Buffer && m_Size == size)
+			return;
+
+		m_Size = size;
+
+		Release();
+		AllocateMemory();
+	}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	// What the buffer is bound as, can be combined (a storage buffer that is also drawn as vertices)
+	enum class BufferUsage : uint8_t
+	{
+		None    = 0,
+		Vertex  = 1 << 0,
+		Index   = 1 << 1,
+		Storage = 1 << 2,
+		Uniform = 1 << 3
+	};
+
+	inline BufferUsage operator|(BufferUsage a, BufferUsage b) { return (BufferUsage)((uint8_t)a | (uint8_t)b); }
+	inline bool operator&(BufferUsage a, BufferUsage b) { return ((uint8_t)a & (uint8_t)b) != 0; }
+
+	enum class BufferMemory : uint8_t
+	{
+		// Fastest for the GPU. SetData is batched into the frame's command buffer.
+		DeviceLocal = 0,
+		// Persistently mapped and coherent, SetData writes straight into it, with no copy in between. Frames still in
+		// flight may be reading it, so data rewritten every frame needs Application::GetFramesInFlight() copies
+		// (buffers or regions) that the caller rotates through, one per frame.
+		HostVisible
+	};
+
+	struct PendingBufferUpdates;
+
+	class Buffer
+	{
+	public:
+		Buffer(uint64_t size, BufferUsage usage, BufferMemory memory = BufferMemory::DeviceLocal, const void* data = nullptr);
+		~Buffer();
+
+		// DeviceLocal buffers copy the range now and upload it with the frame's commands (Application::SubmitFrameCommands),
+		// where the first SetData of the frame was submitted. Overlapping updates within a frame are merged, later writes win.
+		// HostVisible buffers are written immediately, so the GPU must not be reading the range anymore.
+		// Ranges past the end of the buffer are rejected.
+		void SetData(const void* data, uint64_t size, uint64_t offset = 0);
+
+		// Copies the range back after the frame commands submitted before this call (uploads, dispatches).
+		// The callback runs on the main thread once that frame is done on the GPU, a few frames later.
+		// Ranges past the end of the buffer are rejected and the callback never runs, as it doesn't when the buffer
+		// is resized or released before the frame is recorded.
+		void ReadData(std::function<void(const void* data, uint64_t size)>&& callback, uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE);
+
+		// Contents are lost
+		void Resize(uint64_t size);
+
+		uint64_t GetSize() const { return m_Size; }
+		BufferUsage GetUsage() const { return m_Usage; }
+		BufferMemory GetMemory() const { return m_Memory; }
+
+		VkBuffer GetVulkanBuffer() const { return m_Buffer; }
+		// nullptr for DeviceLocal buffers
+		void* GetMappedData() const { return m_MappedData; }
+	private:
+		void AllocateMemory();
+		void Release();
+	private:
+		uint64_t m_Size = 0;
+		BufferUsage m_Usage = BufferUsage::None;
+		BufferMemory m_Memory = BufferMemory::DeviceLocal;
+
+		VkBuffer m_Buffer = nullptr;
+		VkDeviceMemory m_DeviceMemory = nullptr;
+		void* m_MappedData = nullptr;
+
+		// Shared with the frame command that uploads them, which can outlive the buffer by a frame
+		std::shared_ptr<PendingBufferUpdates> m_PendingUpdates;
+	};
+
+}
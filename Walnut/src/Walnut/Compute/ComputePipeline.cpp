@@ -0,0 +1,311 @@
+#include "ComputePipeline.h"
+
+#include "Walnut/Application.h"
+#include "Walnut/Image.h"
+#include "Walnut/Buffer.h"
+#include "Walnut/GpuTimer.h"
+#include "Walnut/Profiler.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace Walnut {
+
+	// Dispatch closures hold a reference, so the last one to let go is either the pipeline or the frame that
+	// recorded the final dispatch. Freeing from there puts it behind the fence of every frame that used it.
+	struct ComputePipelineObjects
+	{
+		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+
+		~ComputePipelineObjects()
+		{
+			Application::SubmitResourceFree([pipeline = Pipeline, pipelineLayout = PipelineLayout, descriptorSetLayout = DescriptorSetLayout]()
+			{
+				VkDevice device = Application::GetDevice();
+				vkDestroyPipeline(device, pipeline, Application::GetAllocator());
+				vkDestroyPipelineLayout(device, pipelineLayout, Application::GetAllocator());
+				vkDestroyDescriptorSetLayout(device, descriptorSetLayout, Application::GetAllocator());
+			});
+		}
+	};
+
+	namespace Utils {
+
+		static const uint32_t s_SpirvMagic = 0x07230203;
+
+		struct ComputeDescriptor
+		{
+			VkDescriptorType Type;
+			VkDescriptorImageInfo ImageInfo;
+			VkDescriptorBufferInfo BufferInfo;
+		};
+
+		static VkDescriptorType ComputeBindingTypeToVulkan(ComputeBindingType type)
+		{
+			switch (type)
+			{
+				case ComputeBindingType::StorageImage: return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				case ComputeBindingType::SampledImage: return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				case ComputeBindingType::StorageBuffer: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				case ComputeBindingType::UniformBuffer: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+			return (VkDescriptorType)0;
+		}
+
+		// Resolved when the dispatch is submitted, so the resources only need to outlive the frame, not the call
+		static bool GetDescriptors(const ComputePipelineSpecification& specification, std::initializer_list<ComputeResource> resources, std::vector<ComputeDescriptor>& outDescriptors)
+		{
+			if (resources.size() != specification.Bindings.size())
+			{
+				std::cerr << "[COMPUTE] " << specification.DebugName << " expects " << specification.Bindings.size() << " resources, got " << resources.size() << "\n";
+				return false;
+			}
+
+			outDescriptors.resize(resources.size());
+			uint32_t binding = 0;
+			for (const ComputeResource& resource : resources)
+			{
+				ComputeBindingType type = specification.Bindings[binding];
+				ComputeDescriptor& descriptor = outDescriptors[binding];
+				descriptor = {};
+				descriptor.Type = ComputeBindingTypeToVulkan(type);
+
+				bool valid = false;
+				if (type == ComputeBindingType::StorageImage || type == ComputeBindingType::SampledImage)
+				{
+					Image* image = resource.ImageResource;
+					valid = image && (type == ComputeBindingType::SampledImage || image->GetUsage() == ImageUsage::Storage);
+					if (valid)
+					{
+						descriptor.ImageInfo.sampler = type == ComputeBindingType::SampledImage ? image->GetSampler() : VK_NULL_HANDLE;
+						descriptor.ImageInfo.imageView = image->GetImageView();
+						descriptor.ImageInfo.imageLayout = image->GetLayout();
+					}
+				}
+				else
+				{
+					Buffer* buffer = resource.BufferResource;
+					valid = buffer && (buffer->GetUsage() & (type == ComputeBindingType::StorageBuffer ? BufferUsage::Storage : BufferUsage::Uniform));
+					if (valid)
+					{
+						descriptor.BufferInfo.buffer = buffer->GetVulkanBuffer();
+						descriptor.BufferInfo.range = VK_WHOLE_SIZE;
+					}
+				}
+
+				if (!valid)
+				{
+					std::cerr << "[COMPUTE] " << specification.DebugName << " binding " << binding << " has the wrong kind of resource\n";
+					return false;
+				}
+				binding++;
+			}
+			return true;
+		}
+
+		static void RecordDispatch(VkCommandBuffer commandBuffer, VkDescriptorSetLayout descriptorSetLayout, VkPipelineLayout pipelineLayout, VkPipeline pipeline,
+			const std::vector<ComputeDescriptor>& descriptors, const void* pushConstants, uint32_t pushConstantSize, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+		{
+			VkDevice device = Application::GetDevice();
+
+			VkResult err;
+
+			// A set per dispatch, freed once the frame is done with it
+			VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+			if (!descriptors.empty())
+			{
+				VkDescriptorSetAllocateInfo alloc_info = {};
+				alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				alloc_info.descriptorPool = Application::GetDescriptorPool();
+				alloc_info.descriptorSetCount = 1;
+				alloc_info.pSetLayouts = &descriptorSetLayout;
+				{
+					std::scoped_lock<std::mutex> lock(Application::GetDescriptorPoolMutex());
+					err = vkAllocateDescriptorSets(device, &alloc_info, &descriptor_set);
+				}
+				check_vk_result(err);
+
+				std::vector<VkWriteDescriptorSet> writes(descriptors.size());
+				for (uint32_t i = 0; i < (uint32_t)descriptors.size(); i++)
+				{
+					VkWriteDescriptorSet& write = writes[i];
+					write = {};
+					write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					write.dstSet = descriptor_set;
+					write.dstBinding = i;
+					write.descriptorCount = 1;
+					write.descriptorType = descriptors[i].Type;
+					write.pImageInfo = &descriptors[i].ImageInfo;
+					write.pBufferInfo = &descriptors[i].BufferInfo;
+				}
+				vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, NULL);
+
+				Application::SubmitResourceFree(ResourceType::DescriptorSet, (uint64_t)descriptor_set);
+			}
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+			if (descriptor_set)
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptor_set, 0, NULL);
+			if (pushConstantSize > 0 && pushConstants)
+				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+			vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+		}
+
+	}
+
+	ComputePipeline::ComputePipeline(const ComputePipelineSpecification& specification, const uint32_t* spirv, size_t size)
+		: m_Specification(specification)
+	{
+		if (!spirv || size < sizeof(uint32_t) || spirv[0] != Utils::s_SpirvMagic)
+		{
+			std::cerr << "[COMPUTE] " << m_Specification.DebugName << " is not a SPIR-V module\n";
+			return;
+		}
+
+		Create(spirv, size);
+	}
+
+	ComputePipeline::ComputePipeline(const ComputePipelineSpecification& specification, const std::string& path)
+		: m_Specification(specification)
+	{
+		std::ifstream stream(path, std::ios::binary | std::ios::ate);
+		if (!stream)
+		{
+			std::cerr << "[COMPUTE] Could not open " << path << "\n";
+			return;
+		}
+
+		size_t size = (size_t)stream.tellg();
+		std::vector<uint32_t> spirv(size / sizeof(uint32_t));
+		stream.seekg(0);
+		stream.read((char*)spirv.data(), spirv.size() * sizeof(uint32_t));
+		if (!stream || size % sizeof(uint32_t) != 0 || spirv.empty() || spirv[0] != Utils::s_SpirvMagic)
+		{
+			std::cerr << "[COMPUTE] " << path << " is not a SPIR-V module\n";
+			return;
+		}
+
+		Create(spirv.data(), size);
+	}
+
+	void ComputePipeline::Create(const uint32_t* spirv, size_t size)
+	{
+		WL_PROFILE_FUNCTION();
+
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		// Create the Descriptor Set Layout
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings(m_Specification.Bindings.size());
+			for (uint32_t i = 0; i < (uint32_t)bindings.size(); i++)
+			{
+				bindings[i] = {};
+				bindings[i].binding = i;
+				bindings[i].descriptorType = Utils::ComputeBindingTypeToVulkan(m_Specification.Bindings[i]);
+				bindings[i].descriptorCount = 1;
+				bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			}
+
+			VkDescriptorSetLayoutCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			info.bindingCount = (uint32_t)bindings.size();
+			info.pBindings = bindings.data();
+			err = vkCreateDescriptorSetLayout(device, &info, Application::GetAllocator(), &m_DescriptorSetLayout);
+			check_vk_result(err);
+		}
+
+		// Create the Pipeline Layout
+		{
+			VkPushConstantRange push_constants = {};
+			push_constants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			push_constants.size = m_Specification.PushConstantSize;
+
+			VkPipelineLayoutCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			info.setLayoutCount = 1;
+			info.pSetLayouts = &m_DescriptorSetLayout;
+			info.pushConstantRangeCount = m_Specification.PushConstantSize > 0 ? 1 : 0;
+			info.pPushConstantRanges = &push_constants;
+			err = vkCreatePipelineLayout(device, &info, Application::GetAllocator(), &m_PipelineLayout);
+			check_vk_result(err);
+		}
+
+		// Create the Pipeline
+		{
+			VkShaderModuleCreateInfo module_info = {};
+			module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			module_info.codeSize = size;
+			module_info.pCode = spirv;
+			VkShaderModule shader_module;
+			err = vkCreateShaderModule(device, &module_info, Application::GetAllocator(), &shader_module);
+			check_vk_result(err);
+
+			VkComputePipelineCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			info.stage.module = shader_module;
+			info.stage.pName = "main";
+			info.layout = m_PipelineLayout;
+			err = vkCreateComputePipelines(device, Application::GetPipelineCache(), 1, &info, Application::GetAllocator(), &m_Pipeline);
+			check_vk_result(err);
+
+			vkDestroyShaderModule(device, shader_module, Application::GetAllocator());
+		}
+
+		m_Objects = std::make_shared<ComputePipelineObjects>();
+		m_Objects->DescriptorSetLayout = m_DescriptorSetLayout;
+		m_Objects->PipelineLayout = m_PipelineLayout;
+		m_Objects->Pipeline = m_Pipeline;
+	}
+
+	void ComputePipeline::Dispatch(std::initializer_list<ComputeResource> resources, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, const void* pushConstants)
+	{
+		std::vector<Utils::ComputeDescriptor> descriptors;
+		if (!IsValid() || !Utils::GetDescriptors(m_Specification, resources, descriptors))
+			return;
+
+		std::vector<uint8_t> pushConstantData;
+		if (pushConstants)
+			pushConstantData.assign((const uint8_t*)pushConstants, (const uint8_t*)pushConstants + m_Specification.PushConstantSize);
+
+		// The descriptor set RecordDispatch allocates is freed from here too, in the slot of the frame that uses it
+		Application::SubmitFrameCommands([descriptors = std::move(descriptors), pushConstantData = std::move(pushConstantData), objects = m_Objects,
+			name = m_Specification.DebugName, groupCountX, groupCountY, groupCountZ](VkCommandBuffer commandBuffer)
+		{
+			ScopedGpuTimer gpuTimer(commandBuffer, name);
+
+			// Earlier dispatches, uploads and the previous frame's UI pass are done with the images
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+			Utils::RecordDispatch(commandBuffer, objects->DescriptorSetLayout, objects->PipelineLayout, objects->Pipeline, descriptors,
+				pushConstantData.data(), (uint32_t)pushConstantData.size(), groupCountX, groupCountY, groupCountZ);
+
+			// Make the writes visible to the UI pass (and to copies, draws and dispatches after it)
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+		});
+	}
+
+	void ComputePipeline::Record(VkCommandBuffer commandBuffer, std::initializer_list<ComputeResource> resources, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ, const void* pushConstants)
+	{
+		std::vector<Utils::ComputeDescriptor> descriptors;
+		if (!IsValid() || !Utils::GetDescriptors(m_Specification, resources, descriptors))
+			return;
+
+		Utils::RecordDispatch(commandBuffer, m_DescriptorSetLayout, m_PipelineLayout, m_Pipeline, descriptors,
+			pushConstants, pushConstants ? m_Specification.PushConstantSize : 0, groupCountX, groupCountY, groupCountZ);
+	}
+
+}
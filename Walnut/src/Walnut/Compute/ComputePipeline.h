@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <initializer_list>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	class Image;
+	class Buffer;
+	struct ComputePipelineObjects;
+
+	// Descriptor set 0, binding i of the shader is Bindings[i]
+	enum class ComputeBindingType : uint8_t
+	{
+		StorageImage = 0, // image2D, the Image has to be created with ImageUsage::Storage
+		SampledImage,     // sampler2D
+		StorageBuffer,    // buffer block, the Buffer has to have BufferUsage::Storage
+		UniformBuffer     // uniform block, the Buffer has to have BufferUsage::Uniform
+	};
+
+	struct ComputePipelineSpecification
+	{
+		std::vector<ComputeBindingType> Bindings;
+		uint32_t PushConstantSize = 0;
+		// GPU timer scope of each dispatch, has to be a string literal
+		const char* DebugName = "Compute";
+	};
+
+	// One resource of a dispatch, in binding order
+	struct ComputeResource
+	{
+		ComputeResource(Image* image) : ImageResource(image) {}
+		ComputeResource(Image& image) : ImageResource(&image) {}
+		ComputeResource(Buffer* buffer) : BufferResource(buffer) {}
+		ComputeResource(Buffer& buffer) : BufferResource(&buffer) {}
+
+		Image* ImageResource = nullptr;
+		Buffer* BufferResource = nullptr;
+	};
+
+	// A compute shader plus the layout it's dispatched with. Pipelines are created through the
+	// application's pipeline cache and destroyed through the deferred free queue once neither the
+	// pipeline nor a queued dispatch holds them anymore.
+	class ComputePipeline
+	{
+	public:
+		// SPIR-V words, e.g. the output of glslc -mfmt=c. The pipeline is invalid if they are not a SPIR-V module.
+		ComputePipeline(const ComputePipelineSpecification& specification, const uint32_t* spirv, size_t size);
+		// A .spv file, the pipeline is invalid if it can't be read
+		ComputePipeline(const ComputePipelineSpecification& specification, const std::string& path);
+
+		bool IsValid() const { return m_Pipeline != VK_NULL_HANDLE; }
+
+		// Recorded into the frame's command buffer ahead of the UI pass (Application::SubmitFrameCommands),
+		// so the result shows up in the same frame. Dispatches run in submission order and ImGui sees their writes.
+		// Push constants are copied.
+		void Dispatch(std::initializer_list<ComputeResource> resources, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ = 1, const void* pushConstants = nullptr);
+
+		// Records into a command buffer of your own. The images have to be in their GetLayout() layout,
+		// buffer uploads have to have landed and the barriers around the dispatch are up to the caller.
+		void Record(VkCommandBuffer commandBuffer, std::initializer_list<ComputeResource> resources, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ = 1, const void* pushConstants = nullptr);
+
+		VkPipeline GetPipeline() const { return m_Pipeline; }
+		VkPipelineLayout GetPipelineLayout() const { return m_PipelineLayout; }
+
+		static uint32_t GetGroupCount(uint32_t size, uint32_t localSize) { return (size + localSize - 1) / localSize; }
+	private:
+		void Create(const uint32_t* spirv, size_t size);
+	private:
+		ComputePipelineSpecification m_Specification;
+
+		VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_Pipeline = VK_NULL_HANDLE;
+		std::shared_ptr<ComputePipelineObjects> m_Objects; // Owns the handles above, shared with queued dispatches
+	};
+
+}
@@ -0,0 +1,46 @@
+#include "Tonemapper.h"
+
+#include "Walnut/Image.h"
+
+namespace Walnut {
+
+	// Generated at build time from Shaders/Tonemap.comp (glslc -mfmt=c). Without glslc the pipeline is invalid.
+#ifndef WL_NO_SHADERS
+	static const uint32_t s_TonemapShaderSPIRV[] =
+	#include "Tonemap.comp.inl"
+	;
+#else
+	static const uint32_t s_TonemapShaderSPIRV[] = { 0 };
+#endif
+
+	static const uint32_t s_TonemapLocalSize = 16;
+
+	struct TonemapPushConstants
+	{
+		float Exposure;
+		float Gamma;
+	};
+
+	static ComputePipelineSpecification GetTonemapSpecification()
+	{
+		ComputePipelineSpecification specification;
+		specification.Bindings = { ComputeBindingType::SampledImage, ComputeBindingType::StorageImage };
+		specification.PushConstantSize = sizeof(TonemapPushConstants);
+		specification.DebugName = "Tonemap";
+		return specification;
+	}
+
+	Tonemapper::Tonemapper()
+		: m_Pipeline(GetTonemapSpecification(), s_TonemapShaderSPIRV, sizeof(s_TonemapShaderSPIRV))
+	{
+	}
+
+	void Tonemapper::Dispatch(Image& input, Image& output, float exposure, float gamma)
+	{
+		TonemapPushConstants pushConstants = { exposure, gamma };
+		m_Pipeline.Dispatch({ input, output },
+			ComputePipeline::GetGroupCount(output.GetWidth(), s_TonemapLocalSize),
+			ComputePipeline::GetGroupCount(output.GetHeight(), s_TonemapLocalSize), 1, &pushConstants);
+	}
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ComputePipeline.h"
+
+namespace Walnut {
+
+	// Built-in example kernel: exposure, ACES filmic tonemapping and gamma from an HDR image
+	// (e.g. an RGBA32F accumulation buffer) into an RGBA storage image of the same size.
+	class Tonemapper
+	{
+	public:
+		Tonemapper();
+
+		// False if Walnut was built without glslc, Dispatch does nothing then
+		bool IsValid() const { return m_Pipeline.IsValid(); }
+
+		void Dispatch(Image& input, Image& output, float exposure = 1.0f, float gamma = 2.2f);
+	private:
+		ComputePipeline m_Pipeline;
+	};
+
+}
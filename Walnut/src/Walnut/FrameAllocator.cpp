@@ -0,0 +1,239 @@
+#include "FrameAllocator.h"
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace Walnut {
+
+	struct FrameArenaSlot
+	{
+		FrameArena Main;
+		std::vector<std::unique_ptr<FrameArena>> Threads; // Handed out to workers during this slot's frame
+		uint64_t Epoch = 0;
+
+		FrameArenaSlot(size_t arenaSize)
+			: Main(arenaSize) {}
+	};
+
+	struct FrameAllocatorData
+	{
+		std::vector<std::unique_ptr<FrameArenaSlot>> Slots;
+		std::vector<std::unique_ptr<FrameArena>> FreeThreadArenas;
+		size_t ArenaSize = 0;
+		std::thread::id MainThread;
+
+		uint32_t CurrentSlot = 0; // Written by BeginFrame on the main thread, read by workers under the mutex
+		std::atomic<uint64_t> CurrentEpoch = 0;
+		std::mutex Mutex;
+
+		// Updated by BeginFrame, when no worker can be using the arenas it reads
+		FrameAllocatorStats Stats;
+	};
+
+	static FrameAllocatorData* s_Data = nullptr;
+
+	// Never reused, so a thread's cached arena from an earlier frame or an earlier Init can't match
+	static std::atomic<uint64_t> s_NextEpoch = 1;
+
+	struct ThreadArenaCache
+	{
+		uint64_t Epoch = 0;
+		FrameArena* Arena = nullptr;
+	};
+
+	static thread_local ThreadArenaCache s_ThreadArena;
+
+	namespace Utils {
+
+		static uint8_t* AlignPointer(uint8_t* pointer, size_t alignment)
+		{
+			return (uint8_t*)(((uintptr_t)pointer + (alignment - 1)) & ~(uintptr_t)(alignment - 1));
+		}
+
+	}
+
+	FrameArena::FrameArena(size_t blockSize)
+		: m_BlockSize(blockSize > 0 ? blockSize : DefaultBlockSize)
+	{
+	}
+
+	void* FrameArena::Allocate(size_t size, size_t alignment)
+	{
+		uint8_t* start = Utils::AlignPointer(m_Current, alignment);
+		if (!m_Current || start > m_End || (size_t)(m_End - start) < size)
+		{
+			AddBlock(size + alignment);
+			start = Utils::AlignPointer(m_Current, alignment);
+		}
+
+		m_UsedBytes += (size_t)(start + size - m_Current);
+		m_Current = start + size;
+		if (m_UsedBytes > m_HighWaterMark)
+			m_HighWaterMark = m_UsedBytes;
+		return start;
+	}
+
+	const char* FrameArena::CopyString(const char* string, size_t length)
+	{
+		char* copy = (char*)Allocate(length + 1, 1);
+		memcpy(copy, string, length);
+		copy[length] = '\0';
+		return copy;
+	}
+
+	void FrameArena::AddBlock(size_t minimumSize)
+	{
+		if (!m_Blocks.empty())
+			m_OverflowCount++;
+
+		// The rest of the current block is skipped, which the used bytes have to account for
+		// or the merged block on the next reset would come out too small
+		if (m_Current)
+			m_UsedBytes += (size_t)(m_End - m_Current);
+
+		Block& block = m_Blocks.emplace_back();
+		block.Size = std::max(m_BlockSize, minimumSize);
+		block.Data = std::make_unique<uint8_t[]>(block.Size);
+		m_Capacity += block.Size;
+
+		m_Current = block.Data.get();
+		m_End = m_Current + block.Size;
+	}
+
+	void FrameArena::Reset()
+	{
+		if (m_Blocks.size() > 1)
+		{
+			// Replaced by one block that fits what this frame needed, allocated on first use
+			m_BlockSize = std::max(m_BlockSize, m_UsedBytes);
+			m_Blocks.clear();
+			m_Capacity = 0;
+			m_Current = nullptr;
+			m_End = nullptr;
+		}
+		else if (!m_Blocks.empty())
+		{
+			m_Current = m_Blocks[0].Data.get();
+		}
+
+		m_UsedBytes = 0;
+	}
+
+	void FrameAllocator::Init(uint32_t framesInFlight, size_t arenaSize)
+	{
+		s_Data = new FrameAllocatorData();
+		s_Data->ArenaSize = arenaSize;
+		s_Data->MainThread = std::this_thread::get_id();
+
+		s_Data->Slots.resize(std::max(framesInFlight, 1u));
+		for (auto& slot : s_Data->Slots)
+			slot = std::make_unique<FrameArenaSlot>(arenaSize);
+
+		s_Data->Slots[0]->Epoch = s_NextEpoch.fetch_add(1, std::memory_order_relaxed);
+		s_Data->CurrentEpoch.store(s_Data->Slots[0]->Epoch, std::memory_order_release);
+	}
+
+	void FrameAllocator::Shutdown()
+	{
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void FrameAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		if (!s_Data)
+			return;
+
+		static Gauge& s_UsedBytesGauge = MetricsRegistry::GetGauge("Walnut/FrameArenaBytes");
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+
+		uint32_t slotIndex = frameIndex % (uint32_t)s_Data->Slots.size();
+		FrameArenaSlot& slot = *s_Data->Slots[slotIndex];
+		FrameAllocatorStats& stats = s_Data->Stats;
+
+		stats.UsedBytes = slot.Main.GetUsedBytes();
+		stats.ThreadUsedBytes = 0;
+		stats.ThreadArenas = (uint32_t)slot.Threads.size();
+		for (auto& arena : slot.Threads)
+		{
+			stats.ThreadUsedBytes += arena->GetUsedBytes();
+			arena->Reset();
+			s_Data->FreeThreadArenas.push_back(std::move(arena));
+		}
+		slot.Threads.clear();
+		stats.ThreadHighWaterMark = std::max(stats.ThreadHighWaterMark, stats.ThreadUsedBytes);
+		slot.Main.Reset();
+
+		// Sub-arenas still handed out for other frames are left out until they come back
+		stats.HighWaterMark = 0;
+		stats.Capacity = 0;
+		stats.ThreadCapacity = 0;
+		stats.OverflowCount = 0;
+		for (auto& other : s_Data->Slots)
+		{
+			stats.HighWaterMark = std::max(stats.HighWaterMark, other->Main.GetHighWaterMark());
+			stats.Capacity += other->Main.GetCapacity();
+			stats.OverflowCount += other->Main.GetOverflowCount();
+		}
+		for (auto& arena : s_Data->FreeThreadArenas)
+		{
+			stats.ThreadCapacity += arena->GetCapacity();
+			stats.OverflowCount += arena->GetOverflowCount();
+		}
+
+		slot.Epoch = s_NextEpoch.fetch_add(1, std::memory_order_relaxed);
+		s_Data->CurrentSlot = slotIndex;
+		s_Data->CurrentEpoch.store(slot.Epoch, std::memory_order_release);
+
+		s_UsedBytesGauge.Set((double)(stats.UsedBytes + stats.ThreadUsedBytes));
+	}
+
+	FrameArena& FrameAllocator::Get()
+	{
+		if (!s_Data)
+		{
+			static thread_local FrameArena s_FallbackArena;
+			return s_FallbackArena;
+		}
+
+		if (std::this_thread::get_id() == s_Data->MainThread)
+			return s_Data->Slots[s_Data->CurrentSlot]->Main;
+
+		if (s_ThreadArena.Epoch == s_Data->CurrentEpoch.load(std::memory_order_acquire))
+			return *s_ThreadArena.Arena;
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+
+		std::unique_ptr<FrameArena> arena;
+		if (!s_Data->FreeThreadArenas.empty())
+		{
+			arena = std::move(s_Data->FreeThreadArenas.back());
+			s_Data->FreeThreadArenas.pop_back();
+		}
+		else
+		{
+			arena = std::make_unique<FrameArena>(s_Data->ArenaSize);
+		}
+
+		FrameArenaSlot& slot = *s_Data->Slots[s_Data->CurrentSlot];
+		s_ThreadArena.Epoch = slot.Epoch;
+		s_ThreadArena.Arena = slot.Threads.emplace_back(std::move(arena)).get();
+		return *s_ThreadArena.Arena;
+	}
+
+	FrameAllocatorStats FrameAllocator::GetStats()
+	{
+		if (!s_Data)
+			return {};
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		return s_Data->Stats;
+	}
+
+}
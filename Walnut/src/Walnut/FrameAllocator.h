@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace Walnut {
+
+	// Bump allocator for memory that only has to live for a frame. Allocations are never freed individually,
+	// Reset() releases all of them at once. When a block runs out another one is chained on; the next Reset()
+	// merges them into one block big enough for the whole frame, so a steady workload ends up with a single block.
+	// Not thread-safe, every thread gets its own arena (FrameAllocator::Get).
+	class FrameArena
+	{
+	public:
+		static const size_t DefaultBlockSize = 64 * 1024;
+	public:
+		FrameArena(size_t blockSize = DefaultBlockSize);
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// Destructors are never called, so only trivially destructible types
+		template<typename T>
+		T* AllocateArray(size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without calling destructors");
+			return (T*)Allocate(sizeof(T) * count, alignof(T));
+		}
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without calling destructors");
+			return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		// Null-terminated copy
+		const char* CopyString(const char* string, size_t length);
+		const char* CopyString(const std::string& string) { return CopyString(string.c_str(), string.size()); }
+
+		void Reset();
+
+		size_t GetUsedBytes() const { return m_UsedBytes; }
+		size_t GetCapacity() const { return m_Capacity; }
+		// Most bytes used between two resets since the arena was created
+		size_t GetHighWaterMark() const { return m_HighWaterMark; }
+		// Blocks chained on because the first one was too small, since the arena was created
+		uint64_t GetOverflowCount() const { return m_OverflowCount; }
+	private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> Data;
+			size_t Size = 0;
+		};
+
+		void AddBlock(size_t minimumSize);
+	private:
+		std::vector<Block> m_Blocks;
+		size_t m_BlockSize;
+		uint8_t* m_Current = nullptr;
+		uint8_t* m_End = nullptr;
+
+		size_t m_UsedBytes = 0;
+		size_t m_Capacity = 0;
+		size_t m_HighWaterMark = 0;
+		uint64_t m_OverflowCount = 0;
+	};
+
+	// Lets standard containers allocate from an arena: FrameVector<int> v(FrameAllocator::Get());
+	// deallocate is a no-op, the memory comes back when the arena is reset.
+	template<typename T>
+	class FrameAllocatorAdapter
+	{
+	public:
+		using value_type = T;
+
+		FrameAllocatorAdapter(FrameArena& arena) noexcept
+			: m_Arena(&arena) {}
+		template<typename U>
+		FrameAllocatorAdapter(const FrameAllocatorAdapter<U>& other) noexcept
+			: m_Arena(other.GetArena()) {}
+
+		T* allocate(size_t count) { return (T*)m_Arena->Allocate(sizeof(T) * count, alignof(T)); }
+		void deallocate(T*, size_t) noexcept {}
+
+		FrameArena* GetArena() const { return m_Arena; }
+
+		template<typename U>
+		bool operator==(const FrameAllocatorAdapter<U>& other) const { return m_Arena == other.GetArena(); }
+		template<typename U>
+		bool operator!=(const FrameAllocatorAdapter<U>& other) const { return m_Arena != other.GetArena(); }
+	private:
+		FrameArena* m_Arena;
+	};
+
+	template<typename T>
+	using FrameVector = std::vector<T, FrameAllocatorAdapter<T>>;
+	using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocatorAdapter<char>>;
+
+	struct FrameAllocatorStats
+	{
+		// Main thread
+		size_t UsedBytes = 0;       // By the last completed frame
+		size_t HighWaterMark = 0;   // Largest frame so far
+		size_t Capacity = 0;        // Over all frames in flight
+		// Worker sub-arenas, summed over the threads of a frame
+		size_t ThreadUsedBytes = 0;
+		size_t ThreadHighWaterMark = 0;
+		size_t ThreadCapacity = 0;
+		uint32_t ThreadArenas = 0;  // Sub-arenas handed out by the last completed frame
+
+		uint64_t OverflowCount = 0; // Blocks chained on mid-frame, raise FrameArenaSize if this keeps growing
+	};
+
+	// An arena per frame in flight, reset by Application once the frame's fence has signaled, so memory from
+	// Get() stays valid until the GPU is done with the frame that allocated it (it can back SubmitFrameCommands
+	// data or ImGui draw data). Worker threads get sub-arenas of the current frame that are reset with it; a worker
+	// has to be done with its allocations by the time that frame's slot comes around again.
+	// With a render thread (ApplicationSpecification::RenderThreadDepth) the main thread resets the next arena when it
+	// hands a frame off, with enough slots that the frame allocated from it has finished by then.
+	// Nothing is reset while the window is minimized, as no frames complete.
+	class FrameAllocator
+	{
+	public:
+		// Called by Application
+		static void Init(uint32_t framesInFlight, size_t arenaSize);
+		static void Shutdown();
+		static void BeginFrame(uint32_t frameIndex);
+
+		// The calling thread's arena for the current frame. Without an Application running this is a thread-local arena that is never reset.
+		static FrameArena& Get();
+
+		template<typename T>
+		static FrameVector<T> MakeVector() { return FrameVector<T>(FrameAllocatorAdapter<T>(Get())); }
+		static FrameString MakeString(const char* string = "") { return FrameString(string, FrameAllocatorAdapter<char>(Get())); }
+
+		static FrameAllocatorStats GetStats();
+	};
+
+}
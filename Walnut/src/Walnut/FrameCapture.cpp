@@ -0,0 +1,712 @@
+#include "FrameCapture.h"
+
+#include "Application.h"
+#include "GpuTimer.h"
+#include "Metrics.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Walnut {
+
+	enum class CaptureSlotState : uint8_t
+	{
+		Free = 0,
+		Copying, // Recorded into a frame that hasn't finished on the GPU
+		Encoding // Queued for or owned by the encoder thread
+	};
+
+	struct CaptureSlot
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		void* MappedData = nullptr;
+		uint64_t Size = 0;
+
+		CaptureSlotState State = CaptureSlotState::Free;
+		uint32_t Width = 0, Height = 0;
+		bool BGRA = false;
+		uint64_t FrameNumber = 0;
+	};
+
+	struct FrameCaptureData
+	{
+		FrameCaptureSpecification Specification;
+		std::atomic<bool> Capturing = false;
+		// Start was called while the previous capture was still encoding, it begins once that is done
+		std::atomic<bool> StartPending = false;
+		FrameCaptureSpecification PendingSpecification;
+		std::ofstream PendingY4M;
+		uint64_t PresentedFrames = 0;
+		uint64_t NextFrameNumber = 0;
+		bool FormatWarning = false;
+
+		std::vector<CaptureSlot> Slots;
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		std::deque<uint32_t> EncodeQueue;
+		uint32_t CopyingCount = 0;
+		bool Stopping = false;
+		bool EncoderFinished = false;
+		std::thread Encoder;
+
+		std::atomic<uint64_t> CapturedFrames = 0;
+		std::atomic<uint64_t> EncodedFrames = 0;
+		std::atomic<uint64_t> DroppedFrames = 0;
+		std::atomic<uint64_t> Stalls = 0;
+		Histogram CaptureTime;
+		Histogram EncodeTime;
+	};
+
+	static FrameCaptureData* s_Data = nullptr;
+
+	// RecordFrame runs on the render thread, Start and Stop wherever the application calls them
+	static std::mutex s_RecordMutex;
+
+	namespace Utils {
+
+		static uint32_t GetVulkanMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
+		{
+			VkPhysicalDeviceMemoryProperties prop;
+			vkGetPhysicalDeviceMemoryProperties(Application::GetPhysicalDevice(), &prop);
+			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
+			{
+				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
+					return i;
+			}
+
+			return 0xffffffff;
+		}
+
+		// Persistently mapped, cached memory is preferred since the encoder reads every byte
+		static void AllocateSlot(CaptureSlot& slot, uint64_t size)
+		{
+			VkDevice device = Application::GetDevice();
+
+			VkResult err;
+
+			VkBufferCreateInfo buffer_info = {};
+			buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_info.size = size;
+			buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			err = vkCreateBuffer(device, &buffer_info, Application::GetAllocator(), &slot.Buffer);
+			check_vk_result(err);
+
+			VkMemoryRequirements req;
+			vkGetBufferMemoryRequirements(device, slot.Buffer, &req);
+			uint32_t memoryType = GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, req.memoryTypeBits);
+			if (memoryType == 0xffffffff)
+				memoryType = GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = req.size;
+			alloc_info.memoryTypeIndex = memoryType;
+			err = MemoryTracker::AllocateDeviceMemory(device, alloc_info, DeviceMemoryCategory::Readback, &slot.Memory);
+			check_vk_result(err);
+			err = vkBindBufferMemory(device, slot.Buffer, slot.Memory, 0);
+			check_vk_result(err);
+			err = vkMapMemory(device, slot.Memory, 0, VK_WHOLE_SIZE, 0, &slot.MappedData);
+			check_vk_result(err);
+
+			slot.Size = size;
+		}
+
+		// The slot has to be free, so neither the GPU nor the encoder uses it
+		static void ReleaseSlot(CaptureSlot& slot)
+		{
+			VkDevice device = Application::GetDevice();
+			if (slot.Memory)
+			{
+				vkUnmapMemory(device, slot.Memory);
+				MemoryTracker::FreeDeviceMemory(device, slot.Memory);
+			}
+			if (slot.Buffer)
+				vkDestroyBuffer(device, slot.Buffer, Application::GetAllocator());
+			slot = {};
+		}
+
+		// Joins the encoder of a finished (or finishing) capture and frees its ring
+		static void JoinEncoder()
+		{
+			if (s_Data->Encoder.joinable())
+				s_Data->Encoder.join();
+
+			for (CaptureSlot& slot : s_Data->Slots)
+				ReleaseSlot(slot);
+			s_Data->Slots.clear();
+		}
+
+		static void RunEncoder(std::ofstream y4m);
+
+		// Starts the capture Start set up, the previous encoder has to be joined
+		static void BeginCapture()
+		{
+			s_Data->StartPending = false;
+			s_Data->Specification = s_Data->PendingSpecification;
+
+			s_Data->Capturing = true;
+			s_Data->PresentedFrames = 0;
+			s_Data->NextFrameNumber = 0;
+			s_Data->FormatWarning = false;
+			s_Data->Slots.resize(s_Data->Specification.RingSize);
+			s_Data->EncodeQueue.clear();
+			s_Data->CopyingCount = 0;
+			s_Data->Stopping = false;
+			s_Data->EncoderFinished = false;
+			s_Data->CapturedFrames = 0;
+			s_Data->EncodedFrames = 0;
+			s_Data->DroppedFrames = 0;
+			s_Data->Stalls = 0;
+			s_Data->CaptureTime.Reset();
+			s_Data->EncodeTime.Reset();
+
+			s_Data->Encoder = std::thread(RunEncoder, std::move(s_Data->PendingY4M));
+		}
+
+		static void StopCapture()
+		{
+			if (!s_Data || !s_Data->Capturing)
+				return;
+
+			s_Data->Capturing = false;
+			{
+				std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+				s_Data->Stopping = true;
+			}
+			s_Data->Condition.notify_all();
+		}
+
+		static void GetRGB(const uint8_t* pixel, bool bgra, uint32_t& r, uint32_t& g, uint32_t& b)
+		{
+			r = bgra ? pixel[2] : pixel[0];
+			g = pixel[1];
+			b = bgra ? pixel[0] : pixel[2];
+		}
+
+		static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+		{
+			static uint32_t s_Table[256] = {};
+			static bool s_TableBuilt = false;
+			if (!s_TableBuilt)
+			{
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t c = i;
+					for (int k = 0; k < 8; k++)
+						c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					s_Table[i] = c;
+				}
+				s_TableBuilt = true;
+			}
+
+			crc = ~crc;
+			for (size_t i = 0; i < size; i++)
+				crc = s_Table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+			return ~crc;
+		}
+
+		static void AppendUint32(std::vector<uint8_t>& out, uint32_t value)
+		{
+			out.push_back((uint8_t)(value >> 24));
+			out.push_back((uint8_t)(value >> 16));
+			out.push_back((uint8_t)(value >> 8));
+			out.push_back((uint8_t)value);
+		}
+
+		static void WritePNGChunk(std::ofstream& stream, const char* type, const std::vector<uint8_t>& data)
+		{
+			std::vector<uint8_t> header;
+			AppendUint32(header, (uint32_t)data.size());
+			header.insert(header.end(), type, type + 4);
+
+			uint32_t crc = Crc32(header.data() + 4, 4);
+			crc = Crc32(data.data(), data.size(), crc);
+			std::vector<uint8_t> footer;
+			AppendUint32(footer, crc);
+
+			stream.write((const char*)header.data(), header.size());
+			stream.write((const char*)data.data(), data.size());
+			stream.write((const char*)footer.data(), footer.size());
+		}
+
+		// 8-bit RGB with stored (uncompressed) deflate blocks. Files are large, but encoding is a copy,
+		// so the encoder keeps up with the frame loop. Recompress offline if size matters.
+		static bool WritePNG(const std::filesystem::path& path, const CaptureSlot& slot, std::vector<uint8_t>& scanlines, std::vector<uint8_t>& idat)
+		{
+			const uint8_t* pixels = (const uint8_t*)slot.MappedData;
+			size_t rowSize = 1 + (size_t)slot.Width * 3;
+
+			scanlines.resize(rowSize * slot.Height);
+			for (uint32_t y = 0; y < slot.Height; y++)
+			{
+				uint8_t* row = scanlines.data() + rowSize * y;
+				const uint8_t* source = pixels + (size_t)slot.Width * 4 * y;
+				row[0] = 0; // No filter
+				for (uint32_t x = 0; x < slot.Width; x++)
+				{
+					uint32_t r, g, b;
+					GetRGB(source + x * 4, slot.BGRA, r, g, b);
+					row[1 + x * 3 + 0] = (uint8_t)r;
+					row[1 + x * 3 + 1] = (uint8_t)g;
+					row[1 + x * 3 + 2] = (uint8_t)b;
+				}
+			}
+
+			idat.clear();
+			idat.push_back(0x78); // zlib header, 32K window, no compression
+			idat.push_back(0x01);
+			uint32_t adlerA = 1, adlerB = 0;
+			size_t offset = 0;
+			do
+			{
+				size_t blockSize = std::min<size_t>(scanlines.size() - offset, 65535);
+				bool last = offset + blockSize == scanlines.size();
+				idat.push_back(last ? 1 : 0);
+				idat.push_back((uint8_t)blockSize);
+				idat.push_back((uint8_t)(blockSize >> 8));
+				idat.push_back((uint8_t)~blockSize);
+				idat.push_back((uint8_t)(~blockSize >> 8));
+				idat.insert(idat.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+				for (size_t i = offset; i < offset + blockSize; i++)
+				{
+					adlerA = (adlerA + scanlines[i]) % 65521;
+					adlerB = (adlerB + adlerA) % 65521;
+				}
+				offset += blockSize;
+			} while (offset < scanlines.size());
+			AppendUint32(idat, (adlerB << 16) | adlerA);
+
+			std::ofstream stream(path, std::ios::binary);
+			if (!stream)
+				return false;
+
+			static const uint8_t s_Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+			stream.write((const char*)s_Signature, sizeof(s_Signature));
+
+			std::vector<uint8_t> ihdr;
+			AppendUint32(ihdr, slot.Width);
+			AppendUint32(ihdr, slot.Height);
+			ihdr.push_back(8); // Bit depth
+			ihdr.push_back(2); // RGB
+			ihdr.push_back(0);
+			ihdr.push_back(0);
+			ihdr.push_back(0);
+			WritePNGChunk(stream, "IHDR", ihdr);
+			WritePNGChunk(stream, "IDAT", idat);
+			WritePNGChunk(stream, "IEND", {});
+			return stream.good();
+		}
+
+		static uint8_t ClampByte(int32_t value)
+		{
+			return (uint8_t)std::clamp(value, 0, 255);
+		}
+
+		// BT.601 full range (C420jpeg), chroma is the average of each 2x2 block
+		static void WriteY4MFrame(std::ofstream& stream, const CaptureSlot& slot, std::vector<uint8_t>& planes)
+		{
+			const uint8_t* pixels = (const uint8_t*)slot.MappedData;
+			uint32_t width = slot.Width, height = slot.Height;
+			uint32_t chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+
+			planes.resize((size_t)width * height + (size_t)chromaWidth * chromaHeight * 2);
+			uint8_t* yPlane = planes.data();
+			uint8_t* uPlane = yPlane + (size_t)width * height;
+			uint8_t* vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+			for (uint32_t y = 0; y < height; y++)
+			{
+				for (uint32_t x = 0; x < width; x++)
+				{
+					uint32_t r, g, b;
+					GetRGB(pixels + ((size_t)y * width + x) * 4, slot.BGRA, r, g, b);
+					yPlane[(size_t)y * width + x] = ClampByte((int32_t)(77 * r + 150 * g + 29 * b + 128) >> 8);
+				}
+			}
+
+			for (uint32_t cy = 0; cy < chromaHeight; cy++)
+			{
+				for (uint32_t cx = 0; cx < chromaWidth; cx++)
+				{
+					int32_t r = 0, g = 0, b = 0, count = 0;
+					for (uint32_t y = cy * 2; y < std::min(cy * 2 + 2, height); y++)
+					{
+						for (uint32_t x = cx * 2; x < std::min(cx * 2 + 2, width); x++)
+						{
+							uint32_t pr, pg, pb;
+							GetRGB(pixels + ((size_t)y * width + x) * 4, slot.BGRA, pr, pg, pb);
+							r += pr;
+							g += pg;
+							b += pb;
+							count++;
+						}
+					}
+					r /= count;
+					g /= count;
+					b /= count;
+
+					size_t index = (size_t)cy * chromaWidth + cx;
+					uPlane[index] = ClampByte(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+					vPlane[index] = ClampByte(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+				}
+			}
+
+			stream << "FRAME\n";
+			stream.write((const char*)planes.data(), planes.size());
+		}
+
+		static void RunEncoder(std::ofstream y4m)
+		{
+			static Histogram& s_EncodeTime = MetricsRegistry::GetHistogram("Walnut/FrameCaptureEncode(us)");
+
+			const FrameCaptureSpecification& spec = s_Data->Specification;
+			uint32_t streamWidth = 0, streamHeight = 0;
+			std::vector<uint8_t> scratch, scratch2;
+
+			while (true)
+			{
+				uint32_t index;
+				{
+					std::unique_lock<std::mutex> lock(s_Data->Mutex);
+					s_Data->Condition.wait(lock, []() { return !s_Data->EncodeQueue.empty() || (s_Data->Stopping && s_Data->CopyingCount == 0); });
+					if (s_Data->EncodeQueue.empty())
+						break;
+					index = s_Data->EncodeQueue.front();
+					s_Data->EncodeQueue.pop_front();
+				}
+
+				CaptureSlot& slot = s_Data->Slots[index];
+				Timer timer;
+				if (spec.Format == FrameCaptureFormat::PNG)
+				{
+					char name[32];
+					snprintf(name, sizeof(name), "frame_%06llu.png", (unsigned long long)slot.FrameNumber);
+					if (WritePNG(std::filesystem::path(spec.Path) / name, slot, scratch, scratch2))
+						s_Data->EncodedFrames++;
+					else
+						s_Data->DroppedFrames++;
+				}
+				else
+				{
+					// Y4M streams have one size, frames captured after a resize are dropped
+					if (streamWidth == 0)
+					{
+						streamWidth = slot.Width;
+						streamHeight = slot.Height;
+						y4m << "YUV4MPEG2 W" << streamWidth << " H" << streamHeight << " F" << spec.FrameRate << ":1 Ip A1:1 C420jpeg\n";
+					}
+
+					if (slot.Width == streamWidth && slot.Height == streamHeight)
+					{
+						WriteY4MFrame(y4m, slot, scratch);
+						s_Data->EncodedFrames++;
+					}
+					else
+					{
+						s_Data->DroppedFrames++;
+					}
+				}
+				uint64_t micros = timer.ElapsedNanos() / 1000;
+				s_Data->EncodeTime.Record(micros);
+				s_EncodeTime.Record(micros);
+
+				{
+					std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+					slot.State = CaptureSlotState::Free;
+				}
+				s_Data->Condition.notify_all();
+			}
+
+			if (y4m.is_open())
+				y4m.close();
+
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			s_Data->EncoderFinished = true;
+		}
+
+	}
+
+	bool FrameCapture::Start(const FrameCaptureSpecification& specification)
+	{
+		std::scoped_lock<std::mutex> recordLock(s_RecordMutex);
+		if (!s_Data)
+			s_Data = new FrameCaptureData();
+		if (s_Data->Capturing || s_Data->StartPending)
+			return false;
+
+		std::ofstream y4m;
+		if (specification.Format == FrameCaptureFormat::PNG)
+		{
+			std::error_code error;
+			std::filesystem::create_directories(specification.Path, error);
+			if (error)
+			{
+				std::cerr << "[FrameCapture] Can't create " << specification.Path << ": " << error.message() << "\n";
+				return false;
+			}
+		}
+		else
+		{
+			y4m.open(specification.Path, std::ios::binary | std::ios::trunc);
+			if (!y4m)
+			{
+				std::cerr << "[FrameCapture] Can't open " << specification.Path << "\n";
+				return false;
+			}
+		}
+
+		s_Data->PendingSpecification = specification;
+		s_Data->PendingSpecification.Interval = std::max(specification.Interval, 1u);
+		// Slots of frames still in flight can't be waited on without deadlocking the frame loop
+		s_Data->PendingSpecification.RingSize = std::max(specification.RingSize, Application::GetFramesInFlight() + 1);
+		s_Data->PendingY4M = std::move(y4m);
+
+		// The previous encoder only finishes once the frame loop has handed it the frames still in flight, so it
+		// can't be waited on here. RecordFrame begins the capture after it.
+		bool encoderFinished;
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			encoderFinished = s_Data->EncoderFinished;
+		}
+		if (s_Data->Encoder.joinable() && !encoderFinished)
+		{
+			s_Data->StartPending = true;
+			return true;
+		}
+
+		Utils::JoinEncoder();
+		Utils::BeginCapture();
+		return true;
+	}
+
+	void FrameCapture::Stop()
+	{
+		std::scoped_lock<std::mutex> recordLock(s_RecordMutex);
+		if (s_Data && s_Data->StartPending)
+		{
+			s_Data->StartPending = false;
+			s_Data->PendingY4M = std::ofstream();
+			return;
+		}
+		Utils::StopCapture();
+	}
+
+	bool FrameCapture::IsCapturing()
+	{
+		return s_Data && (s_Data->Capturing || s_Data->StartPending);
+	}
+
+	FrameCaptureStats FrameCapture::GetStats()
+	{
+		FrameCaptureStats stats;
+		if (!s_Data)
+			return stats;
+
+		stats.CapturedFrames = s_Data->CapturedFrames;
+		stats.EncodedFrames = s_Data->EncodedFrames;
+		stats.DroppedFrames = s_Data->DroppedFrames;
+		stats.Stalls = s_Data->Stalls;
+		stats.CaptureMicroseconds = s_Data->CaptureTime.GetSummary().Mean;
+		stats.EncodeMicroseconds = s_Data->EncodeTime.GetSummary().Mean;
+		return stats;
+	}
+
+	void FrameCapture::RecordFrame(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height)
+	{
+		std::scoped_lock<std::mutex> recordLock(s_RecordMutex);
+		if (!s_Data)
+			return;
+
+		if (!s_Data->Capturing)
+		{
+			// Free the ring once the encoder of a stopped capture is done
+			if (s_Data->Encoder.joinable())
+			{
+				bool finished;
+				{
+					std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+					finished = s_Data->EncoderFinished;
+				}
+				if (finished)
+					Utils::JoinEncoder();
+			}
+
+			if (!s_Data->StartPending || s_Data->Encoder.joinable())
+				return;
+			Utils::BeginCapture();
+		}
+
+		if (s_Data->PresentedFrames++ % s_Data->Specification.Interval != 0)
+			return;
+
+		WL_PROFILE_FUNCTION();
+		static Histogram& s_CaptureTime = MetricsRegistry::GetHistogram("Walnut/FrameCapture(us)");
+		Timer timer;
+
+		if (!image)
+		{
+			std::cerr << "[FrameCapture] The swapchain doesn't support transfers, stopping the capture\n";
+			Utils::StopCapture();
+			return;
+		}
+
+		bool bgra;
+		switch (format)
+		{
+			case VK_FORMAT_B8G8R8A8_UNORM:
+			case VK_FORMAT_B8G8R8A8_SRGB: bgra = true; break;
+			case VK_FORMAT_R8G8B8A8_UNORM:
+			case VK_FORMAT_R8G8B8A8_SRGB: bgra = false; break;
+			default:
+				if (!s_Data->FormatWarning)
+					std::cerr << "[FrameCapture] Unsupported swapchain format " << (int)format << "\n";
+				s_Data->FormatWarning = true;
+				s_Data->DroppedFrames++;
+				return;
+		}
+
+		// Only blocks if every slot is queued for the encoder
+		uint32_t index = UINT32_MAX;
+		{
+			std::unique_lock<std::mutex> lock(s_Data->Mutex);
+			bool stalled = false;
+			while (true)
+			{
+				bool encoding = false;
+				for (uint32_t i = 0; i < (uint32_t)s_Data->Slots.size() && index == UINT32_MAX; i++)
+				{
+					if (s_Data->Slots[i].State == CaptureSlotState::Free)
+						index = i;
+					encoding |= s_Data->Slots[i].State == CaptureSlotState::Encoding;
+				}
+				if (index != UINT32_MAX)
+					break;
+
+				// Only frames in flight hold slots, waiting here would never end
+				if (!encoding)
+				{
+					s_Data->DroppedFrames++;
+					return;
+				}
+
+				if (!stalled)
+					s_Data->Stalls++;
+				stalled = true;
+				s_Data->Condition.wait(lock);
+			}
+
+			s_Data->Slots[index].State = CaptureSlotState::Copying;
+			s_Data->CopyingCount++;
+		}
+
+		CaptureSlot& slot = s_Data->Slots[index];
+		uint64_t size = (uint64_t)width * height * 4;
+		if (slot.Size < size)
+		{
+			Utils::ReleaseSlot(slot);
+			slot.State = CaptureSlotState::Copying;
+			Utils::AllocateSlot(slot, size);
+		}
+		slot.Width = width;
+		slot.Height = height;
+		slot.BGRA = bgra;
+		slot.FrameNumber = s_Data->NextFrameNumber++;
+
+		{
+			ScopedGpuTimer gpuTimer(commandBuffer, "Frame Capture");
+
+			// The render pass left the image ready to present
+			VkImageMemoryBarrier copy_barrier = {};
+			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			copy_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			copy_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			copy_barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			copy_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.image = image;
+			copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy_barrier.subresourceRange.levelCount = 1;
+			copy_barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &copy_barrier);
+
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent.width = width;
+			region.imageExtent.height = height;
+			region.imageExtent.depth = 1;
+			vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.Buffer, 1, &region);
+
+			VkImageMemoryBarrier present_barrier = copy_barrier;
+			present_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			present_barrier.dstAccessMask = 0;
+			present_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			present_barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &present_barrier);
+
+			VkMemoryBarrier host_barrier = {};
+			host_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &host_barrier, 0, NULL, 0, NULL);
+		}
+
+		// Runs once this frame's fence has signaled
+		Application::SubmitResourceFree([index]()
+		{
+			if (!s_Data)
+				return;
+
+			CaptureSlot& slot = s_Data->Slots[index];
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = slot.Memory;
+			range.size = VK_WHOLE_SIZE;
+			VkResult err = vkInvalidateMappedMemoryRanges(Application::GetDevice(), 1, &range);
+			check_vk_result(err);
+
+			{
+				std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+				slot.State = CaptureSlotState::Encoding;
+				s_Data->CopyingCount--;
+				s_Data->EncodeQueue.push_back(index);
+			}
+			s_Data->Condition.notify_all();
+		});
+
+		s_Data->CapturedFrames++;
+		uint64_t micros = timer.ElapsedNanos() / 1000;
+		s_Data->CaptureTime.Record(micros);
+		s_CaptureTime.Record(micros);
+	}
+
+	void FrameCapture::Shutdown()
+	{
+		if (!s_Data)
+			return;
+
+		// Frames in flight have been flushed by now, so the encoder only has the queue left
+		Stop();
+		Utils::JoinEncoder();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+}
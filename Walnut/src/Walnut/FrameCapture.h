@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	enum class FrameCaptureFormat : uint8_t
+	{
+		PNG = 0, // One file per frame, frame_000000.png, ... in the Path directory
+		Y4M      // Raw YUV 4:2:0 video in the Path file, for ffmpeg and friends
+	};
+
+	struct FrameCaptureSpecification
+	{
+		std::string Path;
+		FrameCaptureFormat Format = FrameCaptureFormat::PNG;
+
+		// Capture every Nth presented frame
+		uint32_t Interval = 1;
+		// Frames copied back but not encoded yet. The frame loop only blocks when all of them are taken.
+		// Raised to frames in flight + 1 if lower.
+		uint32_t RingSize = 8;
+		// Written to the Y4M header, doesn't affect what is captured
+		uint32_t FrameRate = 60;
+	};
+
+	struct FrameCaptureStats
+	{
+		uint64_t CapturedFrames = 0; // Copied on the GPU
+		uint64_t EncodedFrames = 0;  // Written to disk
+		uint64_t DroppedFrames = 0;  // Unsupported format, or a size change in a Y4M stream
+		uint64_t Stalls = 0;         // Frames that waited on the encoder for a free ring slot
+		// Render thread time per captured frame (recording the copy plus stalls) and encoder time per frame
+		double CaptureMicroseconds = 0.0;
+		double EncodeMicroseconds = 0.0;
+	};
+
+	// Copies presented swapchain images into a ring of host-visible buffers as part of the frame's command buffer.
+	// Once a frame's fence has signaled its copy is handed to an encoder thread, so capturing costs the frame
+	// loop a copy command unless the encoder falls behind by a whole ring.
+	// Per-frame costs also go to the Walnut/FrameCapture(us) and Walnut/FrameCaptureEncode(us) histograms.
+	class FrameCapture
+	{
+	public:
+		// Doesn't block. While a stopped capture is still being encoded, this one begins with the first frame after it.
+		// Returns false if a capture is already running (or pending) or the output can't be opened.
+		static bool Start(const FrameCaptureSpecification& specification);
+		// Doesn't block, frames still in flight are encoded and the output is closed in the background
+		static void Stop();
+		static bool IsCapturing();
+
+		static FrameCaptureStats GetStats();
+
+		// Called by Application after the UI pass. image is VK_NULL_HANDLE if the swapchain can't be copied from.
+		static void RecordFrame(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height);
+		static void Shutdown();
+	};
+
+}
@@ -0,0 +1,97 @@
+#include "FrameStats.h"
+
+namespace Walnut {
+
+	const FrameStatsSample& FrameStats::GetSample(uint32_t index) const
+	{
+		return m_Samples[(m_Next + HistorySize - m_Count + index) % HistorySize];
+	}
+
+	const FrameStatsSample& FrameStats::GetLatest() const
+	{
+		return m_Samples[(m_Next + HistorySize - 1) % HistorySize];
+	}
+
+	FrameStatsSample FrameStats::GetAverage() const
+	{
+		FrameStatsSample average;
+		if (m_Count == 0)
+			return average;
+
+		double frame = 0.0, update = 0.0, uiRender = 0.0, fenceWait = 0.0, present = 0.0, renderWait = 0.0, inputLatency = 0.0;
+		uint64_t drawCalls = 0, vertices = 0, indices = 0, uploadBytes = 0;
+		for (uint32_t i = 0; i < m_Count; i++)
+		{
+			const FrameStatsSample& sample = m_Samples[i];
+			frame += sample.FrameMillis;
+			update += sample.UpdateMillis;
+			uiRender += sample.UIRenderMillis;
+			fenceWait += sample.FenceWaitMillis;
+			present += sample.PresentMillis;
+			renderWait += sample.RenderWaitMillis;
+			inputLatency += sample.InputLatencyMillis;
+			drawCalls += sample.DrawCalls;
+			vertices += sample.Vertices;
+			indices += sample.Indices;
+			uploadBytes += sample.UploadBytes;
+		}
+
+		average.FrameMillis = (float)(frame / m_Count);
+		average.UpdateMillis = (float)(update / m_Count);
+		average.UIRenderMillis = (float)(uiRender / m_Count);
+		average.FenceWaitMillis = (float)(fenceWait / m_Count);
+		average.PresentMillis = (float)(present / m_Count);
+		average.RenderWaitMillis = (float)(renderWait / m_Count);
+		average.InputLatencyMillis = (float)(inputLatency / m_Count);
+		average.DrawCalls = (uint32_t)(drawCalls / m_Count);
+		average.Vertices = (uint32_t)(vertices / m_Count);
+		average.Indices = (uint32_t)(indices / m_Count);
+		average.UploadBytes = uploadBytes / m_Count;
+		return average;
+	}
+
+	void FrameStats::AddSample(const FrameStatsSample& sample)
+	{
+		m_Samples[m_Next] = sample;
+		m_Next = (m_Next + 1) % HistorySize;
+		if (m_Count < HistorySize)
+			m_Count++;
+	}
+
+	// Exponential moving average, per-layer plots would cost more than the layers being measured
+	static const float s_LayerSmoothing = 1.0f / 30.0f;
+
+	LayerFrameTiming& FrameStats::GetLayerTiming(uint32_t layerIndex)
+	{
+		// Layers pushed during the frame come after the count set at its start
+		if (layerIndex >= m_LayerTimings.size())
+			m_LayerTimings.resize(layerIndex + 1);
+		return m_LayerTimings[layerIndex];
+	}
+
+	void FrameStats::AddLayerUpdate(uint32_t layerIndex, float millis)
+	{
+		float& value = GetLayerTiming(layerIndex).UpdateMillis;
+		value += (millis - value) * s_LayerSmoothing;
+	}
+
+	void FrameStats::AddLayerUIRender(uint32_t layerIndex, float millis)
+	{
+		float& value = GetLayerTiming(layerIndex).UIRenderMillis;
+		value += (millis - value) * s_LayerSmoothing;
+	}
+
+	void FrameStats::SetLayerState(uint32_t layerIndex, uint32_t throttle, bool hidden)
+	{
+		LayerFrameTiming& timing = GetLayerTiming(layerIndex);
+		timing.Throttle = throttle;
+		timing.Hidden = hidden;
+	}
+
+	void FrameStats::RemoveLayer(uint32_t layerIndex)
+	{
+		if (layerIndex < m_LayerTimings.size())
+			m_LayerTimings.erase(m_LayerTimings.begin() + layerIndex);
+	}
+
+}
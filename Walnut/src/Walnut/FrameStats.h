@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <stdint.h>
+
+namespace Walnut {
+
+	struct FrameStatsSample
+	{
+		float FrameMillis = 0.0f;     // CPU time from the start of one frame to the next
+		float UpdateMillis = 0.0f;    // All layers
+		float UIRenderMillis = 0.0f;  // All layers
+		float FenceWaitMillis = 0.0f; // Blocked on the frame fence, i.e. waiting for the GPU
+		float PresentMillis = 0.0f;
+		float RenderWaitMillis = 0.0f;   // Blocked on a full render thread pipeline (ApplicationSpecification::RenderThreadDepth)
+		float InputLatencyMillis = 0.0f; // From polling input to presenting the frame built from it, for the last presented frame
+		uint32_t DrawCalls = 0;
+		uint32_t Vertices = 0;
+		uint32_t Indices = 0;
+		uint64_t UploadBytes = 0;
+	};
+
+	struct LayerFrameTiming
+	{
+		float UpdateMillis = 0.0f;   // Per frame, frames the layer's schedule skipped count as 0
+		float UIRenderMillis = 0.0f;
+		uint32_t Throttle = 1;       // See Application::GetLayerThrottle
+		bool Hidden = false;         // Its window is collapsed or behind another dock tab
+	};
+
+	// Rolling window of the last HistorySize frames, filled in by Application at the end of every frame
+	class FrameStats
+	{
+	public:
+		static const uint32_t HistorySize = 240;
+	public:
+		uint32_t GetSampleCount() const { return m_Count; }
+		// 0 is the oldest sample in the window
+		const FrameStatsSample& GetSample(uint32_t index) const;
+		const FrameStatsSample& GetLatest() const;
+		FrameStatsSample GetAverage() const;
+
+		// Smoothed over roughly the last 30 frames, in layer stack order
+		const std::vector<LayerFrameTiming>& GetLayerTimings() const { return m_LayerTimings; }
+
+		void AddSample(const FrameStatsSample& sample);
+		void AddLayerUpdate(uint32_t layerIndex, float millis);
+		void AddLayerUIRender(uint32_t layerIndex, float millis);
+		void SetLayerState(uint32_t layerIndex, uint32_t throttle, bool hidden);
+		void SetLayerCount(uint32_t count) { m_LayerTimings.resize(count); }
+		// Keeps the layers after it paired with their own timings
+		void RemoveLayer(uint32_t layerIndex);
+	private:
+		LayerFrameTiming& GetLayerTiming(uint32_t layerIndex);
+	private:
+		std::array<FrameStatsSample, HistorySize> m_Samples;
+		uint32_t m_Next = 0;
+		uint32_t m_Count = 0;
+
+		std::vector<LayerFrameTiming> m_LayerTimings;
+	};
+
+}
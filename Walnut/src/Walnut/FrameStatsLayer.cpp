@@ -0,0 +1,107 @@
+#include "FrameStatsLayer.h"
+
+#include "Application.h"
+
+namespace Walnut {
+
+	template<float FrameStatsSample::*Member>
+	static float GetSampleValue(void* data, int index)
+	{
+		return ((const FrameStats*)data)->GetSample((uint32_t)index).*Member;
+	}
+
+	static float GetDrawCalls(void* data, int index)
+	{
+		return (float)((const FrameStats*)data)->GetSample((uint32_t)index).DrawCalls;
+	}
+
+	static float GetUploadKilobytes(void* data, int index)
+	{
+		return (float)((const FrameStats*)data)->GetSample((uint32_t)index).UploadBytes / 1024.0f;
+	}
+
+	void FrameStatsLayer::OnUIRender()
+	{
+		if (m_ToggleKey != ImGuiKey_None && ImGui::IsKeyPressed(m_ToggleKey, false))
+			m_Visible = !m_Visible;
+
+		if (!m_Visible)
+			return;
+
+		const FrameStats& stats = Application::Get().GetFrameStats();
+		if (stats.GetSampleCount() == 0)
+			return;
+
+		const ImGuiViewport* viewport = ImGui::GetMainViewport();
+		ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - 10.0f, viewport->WorkPos.y + 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+		ImGui::SetNextWindowViewport(viewport->ID);
+		ImGui::SetNextWindowBgAlpha(0.8f);
+		ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_AlwaysAutoResize
+			| ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+		if (!ImGui::Begin("Frame Stats", nullptr, flags))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const FrameStatsSample& latest = stats.GetLatest();
+		FrameStatsSample average = stats.GetAverage();
+		int count = (int)stats.GetSampleCount();
+		void* data = (void*)&stats;
+		const ImVec2 plotSize(260.0f, 40.0f);
+
+		ImGui::Text("%.1f FPS (%.2f ms avg)", average.FrameMillis > 0.0f ? 1000.0f / average.FrameMillis : 0.0f, average.FrameMillis);
+		ImGui::PlotLines("Frame", GetSampleValue<&FrameStatsSample::FrameMillis>, data, count, 0, nullptr, 0.0f, FLT_MAX, plotSize);
+		ImGui::PlotLines("GPU Wait", GetSampleValue<&FrameStatsSample::FenceWaitMillis>, data, count, 0, nullptr, 0.0f, FLT_MAX, plotSize);
+
+		ImGui::Separator();
+		ImGui::Text("OnUpdate   %6.2f ms", average.UpdateMillis);
+		ImGui::Text("OnUIRender %6.2f ms", average.UIRenderMillis);
+		ImGui::Text("GPU Wait   %6.2f ms", average.FenceWaitMillis);
+		ImGui::Text("Present    %6.2f ms", average.PresentMillis);
+		if (average.RenderWaitMillis > 0.0f)
+			ImGui::Text("Render wait %5.2f ms", average.RenderWaitMillis);
+		ImGui::Text("Input latency %.2f ms", average.InputLatencyMillis);
+
+		const std::vector<LayerFrameTiming>& layers = stats.GetLayerTimings();
+		if (!layers.empty() && ImGui::TreeNode("Layers"))
+		{
+			for (size_t i = 0; i < layers.size(); i++)
+			{
+				ImGui::Text("Layer %zu: update %.2f ms, UI %.2f ms", i, layers[i].UpdateMillis, layers[i].UIRenderMillis);
+				if (layers[i].Hidden)
+				{
+					ImGui::SameLine();
+					ImGui::Text("(hidden)");
+				}
+				if (layers[i].Throttle > 1)
+				{
+					ImGui::SameLine();
+					ImGui::Text("(throttled 1/%u)", layers[i].Throttle);
+				}
+			}
+			ImGui::TreePop();
+		}
+
+		ImGui::Separator();
+		ImGui::Text("Draw calls %u, vertices %u, indices %u", latest.DrawCalls, latest.Vertices, latest.Indices);
+		ImGui::PlotLines("Draws", GetDrawCalls, data, count, 0, nullptr, 0.0f, FLT_MAX, plotSize);
+		ImGui::Text("Uploads %.1f KB/frame", (float)average.UploadBytes / 1024.0f);
+		ImGui::PlotLines("Upload KB", GetUploadKilobytes, data, count, 0, nullptr, 0.0f, FLT_MAX, plotSize);
+
+		FrameAllocatorStats arena = FrameAllocator::GetStats();
+		ImGui::Text("Frame arena %.1f KB (peak %.1f KB), workers %.1f KB in %u", arena.UsedBytes / 1024.0f, arena.HighWaterMark / 1024.0f,
+			arena.ThreadUsedBytes / 1024.0f, arena.ThreadArenas);
+
+		if (FrameCapture::IsCapturing())
+		{
+			FrameCaptureStats capture = FrameCapture::GetStats();
+			ImGui::Separator();
+			ImGui::Text("Capture %.2f ms/frame, encode %.2f ms/frame", capture.CaptureMicroseconds / 1000.0, capture.EncodeMicroseconds / 1000.0);
+			ImGui::Text("%llu captured, %llu encoded, %llu stalls", (unsigned long long)capture.CapturedFrames, (unsigned long long)capture.EncodedFrames, (unsigned long long)capture.Stalls);
+		}
+
+		ImGui::End();
+	}
+
+}
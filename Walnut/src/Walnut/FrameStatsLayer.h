@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Layer.h"
+
+#include "imgui.h"
+
+namespace Walnut {
+
+	// Overlay with plots of Application::GetFrameStats(). Application draws it after all other layers;
+	// the toggle key (ApplicationSpecification::FrameStatsToggleKey) shows and hides it.
+	class FrameStatsLayer : public Layer
+	{
+	public:
+		FrameStatsLayer(ImGuiKey toggleKey, bool visible)
+			: m_ToggleKey(toggleKey), m_Visible(visible) {}
+
+		virtual void OnUIRender() override;
+
+		void SetVisible(bool visible) { m_Visible = visible; }
+		bool IsVisible() const { return m_Visible; }
+	private:
+		ImGuiKey m_ToggleKey;
+		bool m_Visible;
+	};
+
+}
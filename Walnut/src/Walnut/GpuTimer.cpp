@@ -0,0 +1,164 @@
+#include "GpuTimer.h"
+
+#include "Application.h"
+
+#include <mutex>
+
+namespace Walnut {
+
+	static const uint32_t s_MaxScopesPerFrame = 128;
+
+	struct GpuTimerFrame
+	{
+		VkQueryPool QueryPool = VK_NULL_HANDLE;
+		const char* ScopeNames[s_MaxScopesPerFrame];
+		uint32_t ScopeCount = 0;
+	};
+
+	struct GpuTimerData
+	{
+		VkDevice Device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* Allocator = nullptr;
+		float TimestampPeriod = 1.0f; // Nanoseconds per tick
+		uint64_t TimestampMask = ~0ull;
+
+		std::vector<GpuTimerFrame> Frames;
+		uint32_t CurrentFrame = 0;
+		std::mutex Mutex;
+
+		std::vector<GpuTiming> Timings;
+		uint64_t QueryResults[s_MaxScopesPerFrame * 2][2]; // Value + availability
+	};
+
+	static GpuTimerData* s_Data = nullptr;
+
+	void GpuTimer::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, const VkAllocationCallbacks* allocator)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		uint32_t queueFamilyCount;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+		if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+			return;
+
+		s_Data = new GpuTimerData();
+		s_Data->Device = device;
+		s_Data->Allocator = allocator;
+		s_Data->TimestampPeriod = properties.limits.timestampPeriod;
+		s_Data->TimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+		s_Data->Frames.resize(framesInFlight);
+		for (GpuTimerFrame& frame : s_Data->Frames)
+		{
+			VkQueryPoolCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			info.queryCount = s_MaxScopesPerFrame * 2;
+			VkResult err = vkCreateQueryPool(device, &info, allocator, &frame.QueryPool);
+			check_vk_result(err);
+			vkResetQueryPool(device, frame.QueryPool, 0, s_MaxScopesPerFrame * 2);
+		}
+	}
+
+	void GpuTimer::Shutdown()
+	{
+		if (!s_Data)
+			return;
+
+		for (GpuTimerFrame& frame : s_Data->Frames)
+			vkDestroyQueryPool(s_Data->Device, frame.QueryPool, s_Data->Allocator);
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	bool GpuTimer::IsSupported()
+	{
+		return s_Data != nullptr;
+	}
+
+	void GpuTimer::BeginFrame(uint32_t frameIndex)
+	{
+		if (!s_Data)
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+
+		GpuTimerFrame& frame = s_Data->Frames[frameIndex];
+		s_Data->CurrentFrame = frameIndex;
+
+		if (frame.ScopeCount == 0)
+			return;
+
+		// The frame's fence has signaled, so this doesn't wait. Scopes that were never ended stay unavailable and are skipped.
+		VkResult err = vkGetQueryPoolResults(s_Data->Device, frame.QueryPool, 0, frame.ScopeCount * 2,
+			sizeof(s_Data->QueryResults), s_Data->QueryResults, sizeof(s_Data->QueryResults[0]),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (err != VK_SUCCESS && err != VK_NOT_READY)
+			check_vk_result(err);
+
+		s_Data->Timings.resize(frame.ScopeCount);
+		uint32_t timingCount = 0;
+		for (uint32_t i = 0; i < frame.ScopeCount; i++)
+		{
+			const uint64_t* begin = s_Data->QueryResults[i * 2 + 0];
+			const uint64_t* end = s_Data->QueryResults[i * 2 + 1];
+			if (!begin[1] || !end[1])
+				continue;
+
+			uint64_t ticks = ((end[0] & s_Data->TimestampMask) - (begin[0] & s_Data->TimestampMask)) & s_Data->TimestampMask;
+			GpuTiming& timing = s_Data->Timings[timingCount++];
+			timing.Name = frame.ScopeNames[i];
+			timing.Milliseconds = (float)((double)ticks * s_Data->TimestampPeriod * 1e-6);
+		}
+		s_Data->Timings.resize(timingCount);
+
+		vkResetQueryPool(s_Data->Device, frame.QueryPool, 0, frame.ScopeCount * 2);
+		frame.ScopeCount = 0;
+	}
+
+	uint32_t GpuTimer::BeginScope(VkCommandBuffer commandBuffer, const char* name)
+	{
+		// Commands recorded on other threads can still be pending when the frame's queries are reset
+		if (!s_Data || !Application::IsRenderThread())
+			return UINT32_MAX;
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		GpuTimerFrame& frame = s_Data->Frames[s_Data->CurrentFrame];
+		if (frame.ScopeCount == s_MaxScopesPerFrame)
+			return UINT32_MAX;
+
+		uint32_t scope = frame.ScopeCount++;
+		frame.ScopeNames[scope] = name;
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.QueryPool, scope * 2 + 0);
+
+		// Encode the frame so that EndScope writes into the same pool even if a frame boundary happens in between
+		return (s_Data->CurrentFrame << 16) | scope;
+	}
+
+	void GpuTimer::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (!s_Data || scope == UINT32_MAX)
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		GpuTimerFrame& frame = s_Data->Frames[scope >> 16];
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.QueryPool, (scope & 0xffff) * 2 + 1);
+	}
+
+	std::vector<GpuTiming> GpuTimer::GetTimings()
+	{
+		if (!s_Data)
+			return {};
+
+		// Copied, BeginFrame runs on the render thread
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		return s_Data->Timings;
+	}
+
+}
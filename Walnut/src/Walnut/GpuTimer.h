@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	struct GpuTiming
+	{
+		std::string Name;
+		float Milliseconds = 0.0f;
+	};
+
+	// Timestamp queries recorded into a query pool per frame in flight. Results are read back without
+	// waiting once the frame's fence has signaled, so GetTimings() lags a few frames behind the CPU.
+	// Needs timestamp support on the graphics queue and hostQueryReset (Vulkan 1.2), otherwise scopes are no-ops.
+	class GpuTimer
+	{
+	public:
+		static void Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, const VkAllocationCallbacks* allocator);
+		static void Shutdown();
+		static bool IsSupported();
+
+		// Called by Application once the fence of the frame has been waited on
+		static void BeginFrame(uint32_t frameIndex);
+
+		// Name has to stay valid until the results have been read back (string literals are fine).
+		// Scopes are only recorded on the thread that records the frames (Application::IsRenderThread), elsewhere they are no-ops.
+		static uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name);
+		static void EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		static std::vector<GpuTiming> GetTimings();
+	};
+
+	class ScopedGpuTimer
+	{
+	public:
+		ScopedGpuTimer(VkCommandBuffer commandBuffer, const char* name)
+			: m_CommandBuffer(commandBuffer), m_Scope(GpuTimer::BeginScope(commandBuffer, name)) {}
+		~ScopedGpuTimer()
+		{
+			End();
+		}
+
+		// Has to happen before the command buffer is ended
+		void End()
+		{
+			GpuTimer::EndScope(m_CommandBuffer, m_Scope);
+			m_Scope = UINT32_MAX;
+		}
+	private:
+		VkCommandBuffer m_CommandBuffer;
+		uint32_t m_Scope;
+	};
+
+}
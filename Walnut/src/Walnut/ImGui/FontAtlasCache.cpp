@@ -0,0 +1,386 @@
+#include "FontAtlasCache.h"
+
+#include "imgui.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace Walnut {
+
+	// File layout (native endianness, the key covers the struct layouts):
+	//   header: "WLFA", uint32 version, uint64 key, int32 width, height, uint8 bytes per pixel
+	//   atlas:  vec2 uv scale, uv white pixel, vec4 uv lines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1],
+	//           int32 mouse cursor rect, lines rect, uint32 custom rect count, CachedCustomRect[]
+	//   fonts:  uint32 count, per font float size, ascent, descent, int32 surface, uint32 glyph count, ImFontGlyph[]
+	//   pixels: width * height * bytes per pixel
+	static const char s_Magic[4] = { 'W', 'L', 'F', 'A' };
+	static const uint32_t s_Version = 1;
+
+	struct CachedCustomRect
+	{
+		uint16_t Width, Height, X, Y;
+		uint32_t GlyphID;
+		float GlyphAdvanceX;
+		ImVec2 GlyphOffset;
+		int32_t FontIndex; // -1 if the rect isn't a glyph
+	};
+
+	struct CachedFont
+	{
+		float FontSize = 0.0f;
+		float Ascent = 0.0f, Descent = 0.0f;
+		int32_t MetricsTotalSurface = 0;
+		std::vector<ImFontGlyph> Glyphs;
+	};
+
+	namespace Utils {
+
+		static const uint64_t FNVOffsetBasis = 14695981039346656037ull;
+		static const uint64_t FNVPrime = 1099511628211ull;
+
+		// FNV-1a over 64-bit words with an extra shift so high bits reach the low ones. Font files can be
+		// tens of megabytes (CJK), hashing them byte by byte would eat into what the cache saves.
+		static uint64_t Hash(uint64_t hash, const void* data, size_t size)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			size_t i = 0;
+			for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+			{
+				uint64_t word;
+				memcpy(&word, bytes + i, sizeof(uint64_t));
+				hash = (hash ^ word) * FNVPrime;
+				hash ^= hash >> 29;
+			}
+			for (; i < size; i++)
+				hash = (hash ^ bytes[i]) * FNVPrime;
+			return hash;
+		}
+
+		template<typename T>
+		static uint64_t Hash(uint64_t hash, const T& value)
+		{
+			return Hash(hash, &value, sizeof(T));
+		}
+
+		template<typename T>
+		static void Write(std::vector<uint8_t>& buffer, const T& value)
+		{
+			const uint8_t* bytes = (const uint8_t*)&value;
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		static void Write(std::vector<uint8_t>& buffer, const void* data, size_t size)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			buffer.insert(buffer.end(), bytes, bytes + size);
+		}
+
+		template<typename T>
+		static bool Read(const std::vector<uint8_t>& buffer, size_t& offset, T& value)
+		{
+			if (offset + sizeof(T) > buffer.size())
+				return false;
+			memcpy(&value, buffer.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+
+		static bool Read(const std::vector<uint8_t>& buffer, size_t& offset, void* data, size_t size)
+		{
+			if (size > buffer.size() - offset)
+				return false;
+			memcpy(data, buffer.data() + offset, size);
+			offset += size;
+			return true;
+		}
+
+		static std::filesystem::path GetPath(const std::string& directory, uint64_t key)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "FontAtlas-%016llx.bin", (unsigned long long)key);
+			return std::filesystem::path(directory) / name;
+		}
+
+		static int32_t GetFontIndex(const ImFontAtlas* atlas, const ImFont* font)
+		{
+			for (int i = 0; i < atlas->Fonts.Size; i++)
+			{
+				if (atlas->Fonts[i] == font)
+					return i;
+			}
+			return -1;
+		}
+
+	}
+
+	uint64_t FontAtlasCache::GetKey(ImFontAtlas* atlas)
+	{
+		uint64_t hash = Utils::FNVOffsetBasis;
+		hash = Utils::Hash(hash, (uint32_t)IMGUI_VERSION_NUM);
+		hash = Utils::Hash(hash, (uint32_t)sizeof(ImFontGlyph));
+		hash = Utils::Hash(hash, (uint32_t)IM_DRAWLIST_TEX_LINES_WIDTH_MAX);
+
+		hash = Utils::Hash(hash, atlas->Flags);
+		hash = Utils::Hash(hash, atlas->TexDesiredWidth);
+		hash = Utils::Hash(hash, atlas->TexGlyphPadding);
+		hash = Utils::Hash(hash, atlas->FontBuilderFlags);
+		hash = Utils::Hash(hash, atlas->FontBuilderIO != nullptr); // FreeType instead of stb_truetype
+
+		for (const ImFontConfig& config : atlas->ConfigData)
+		{
+			hash = Utils::Hash(hash, config.FontData, (size_t)config.FontDataSize);
+			hash = Utils::Hash(hash, config.FontNo);
+			hash = Utils::Hash(hash, config.SizePixels);
+			hash = Utils::Hash(hash, config.OversampleH);
+			hash = Utils::Hash(hash, config.OversampleV);
+			hash = Utils::Hash(hash, config.PixelSnapH);
+			hash = Utils::Hash(hash, config.GlyphExtraSpacing);
+			hash = Utils::Hash(hash, config.GlyphOffset);
+			hash = Utils::Hash(hash, config.GlyphMinAdvanceX);
+			hash = Utils::Hash(hash, config.GlyphMaxAdvanceX);
+			hash = Utils::Hash(hash, config.MergeMode);
+			hash = Utils::Hash(hash, config.FontBuilderFlags);
+			hash = Utils::Hash(hash, config.RasterizerMultiply);
+			hash = Utils::Hash(hash, config.EllipsisChar);
+
+			const ImWchar* ranges = config.GlyphRanges ? config.GlyphRanges : atlas->GetGlyphRangesDefault();
+			for (; ranges[0] && ranges[1]; ranges += 2)
+			{
+				hash = Utils::Hash(hash, ranges[0]);
+				hash = Utils::Hash(hash, ranges[1]);
+			}
+		}
+		return hash;
+	}
+
+	bool FontAtlasCache::Load(ImFontAtlas* atlas, const std::string& directory)
+	{
+		if (directory.empty() || atlas->Fonts.Size == 0)
+			return false;
+
+		uint64_t key = GetKey(atlas);
+		std::filesystem::path path = Utils::GetPath(directory, key);
+		std::ifstream input(path, std::ios::binary | std::ios::ate);
+		if (!input)
+			return false;
+
+		std::vector<uint8_t> buffer((size_t)input.tellg());
+		input.seekg(0);
+		if (!input.read((char*)buffer.data(), buffer.size()))
+			return false;
+
+		// Parse everything before touching the atlas, a bad entry leaves it ready for a regular Build
+		size_t offset = 0;
+		char magic[4];
+		uint32_t version = 0;
+		uint64_t fileKey = 0;
+		int32_t width = 0, height = 0;
+		uint8_t bytesPerPixel = 0;
+		ImVec2 uvScale, uvWhitePixel;
+		ImVec4 uvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+		int32_t packIdMouseCursor = 0, packIdLines = 0;
+		uint32_t customRectCount = 0;
+		bool valid = Utils::Read(buffer, offset, magic) && memcmp(magic, s_Magic, sizeof(s_Magic)) == 0
+			&& Utils::Read(buffer, offset, version) && version == s_Version
+			&& Utils::Read(buffer, offset, fileKey) && fileKey == key
+			&& Utils::Read(buffer, offset, width) && Utils::Read(buffer, offset, height) && width > 0 && height > 0
+			&& Utils::Read(buffer, offset, bytesPerPixel) && (bytesPerPixel == 1 || bytesPerPixel == 4)
+			&& Utils::Read(buffer, offset, uvScale) && Utils::Read(buffer, offset, uvWhitePixel) && Utils::Read(buffer, offset, uvLines)
+			&& Utils::Read(buffer, offset, packIdMouseCursor) && Utils::Read(buffer, offset, packIdLines)
+			&& Utils::Read(buffer, offset, customRectCount);
+
+		std::vector<CachedCustomRect> customRects;
+		if (valid && customRectCount <= (buffer.size() - offset) / sizeof(CachedCustomRect))
+		{
+			customRects.resize(customRectCount);
+			valid = Utils::Read(buffer, offset, customRects.data(), customRects.size() * sizeof(CachedCustomRect));
+		}
+		else
+			valid = false;
+
+		uint32_t fontCount = 0;
+		valid = valid && Utils::Read(buffer, offset, fontCount) && fontCount == (uint32_t)atlas->Fonts.Size;
+
+		std::vector<CachedFont> fonts(valid ? fontCount : 0);
+		for (CachedFont& font : fonts)
+		{
+			uint32_t glyphCount = 0;
+			valid = valid && Utils::Read(buffer, offset, font.FontSize) && Utils::Read(buffer, offset, font.Ascent)
+				&& Utils::Read(buffer, offset, font.Descent) && Utils::Read(buffer, offset, font.MetricsTotalSurface)
+				&& Utils::Read(buffer, offset, glyphCount) && glyphCount <= (buffer.size() - offset) / sizeof(ImFontGlyph);
+			if (!valid)
+				break;
+			font.Glyphs.resize(glyphCount);
+			Utils::Read(buffer, offset, font.Glyphs.data(), font.Glyphs.size() * sizeof(ImFontGlyph));
+		}
+
+		for (const CachedCustomRect& rect : customRects)
+			valid = valid && rect.FontIndex < (int32_t)fontCount;
+
+		size_t pixelBytes = (size_t)width * (size_t)height * bytesPerPixel;
+		if (!valid || buffer.size() - offset != pixelBytes)
+		{
+			std::cerr << "[FONT CACHE] Ignoring invalid entry " << path.string() << "\n";
+			return false;
+		}
+
+		atlas->ClearTexData();
+		atlas->TexWidth = width;
+		atlas->TexHeight = height;
+		atlas->TexUvScale = uvScale;
+		atlas->TexUvWhitePixel = uvWhitePixel;
+		memcpy(atlas->TexUvLines, uvLines, sizeof(uvLines));
+		if (bytesPerPixel == 1)
+		{
+			atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(pixelBytes);
+			memcpy(atlas->TexPixelsAlpha8, buffer.data() + offset, pixelBytes);
+		}
+		else
+		{
+			atlas->TexPixelsRGBA32 = (unsigned int*)IM_ALLOC(pixelBytes);
+			memcpy(atlas->TexPixelsRGBA32, buffer.data() + offset, pixelBytes);
+			atlas->TexPixelsUseColors = true;
+		}
+
+		// What ImFontAtlasBuildSetupFont does, merged configs follow the config of their font
+		for (ImFont* font : atlas->Fonts)
+			font->ClearOutputData();
+		for (ImFontConfig& config : atlas->ConfigData)
+		{
+			ImFont* font = config.DstFont;
+			if (!config.MergeMode)
+			{
+				font->ConfigData = &config;
+				font->ConfigDataCount = 0;
+				font->ContainerAtlas = atlas;
+			}
+			font->ConfigDataCount++;
+		}
+
+		for (uint32_t i = 0; i < fontCount; i++)
+		{
+			ImFont* font = atlas->Fonts[i];
+			const CachedFont& cached = fonts[i];
+			font->FontSize = cached.FontSize;
+			font->Ascent = cached.Ascent;
+			font->Descent = cached.Descent;
+			font->MetricsTotalSurface = cached.MetricsTotalSurface;
+			font->Glyphs.resize((int)cached.Glyphs.size());
+			if (!cached.Glyphs.empty())
+				memcpy(font->Glyphs.Data, cached.Glyphs.data(), cached.Glyphs.size() * sizeof(ImFontGlyph));
+		}
+
+		atlas->CustomRects.resize((int)customRects.size());
+		for (size_t i = 0; i < customRects.size(); i++)
+		{
+			const CachedCustomRect& cached = customRects[i];
+			ImFontAtlasCustomRect& rect = atlas->CustomRects[(int)i];
+			rect.Width = cached.Width;
+			rect.Height = cached.Height;
+			rect.X = cached.X;
+			rect.Y = cached.Y;
+			rect.GlyphID = cached.GlyphID;
+			rect.GlyphAdvanceX = cached.GlyphAdvanceX;
+			rect.GlyphOffset = cached.GlyphOffset;
+			rect.Font = cached.FontIndex >= 0 ? atlas->Fonts[cached.FontIndex] : nullptr;
+		}
+		atlas->PackIdMouseCursor = packIdMouseCursor;
+		atlas->PackIdLines = packIdLines;
+
+		for (ImFont* font : atlas->Fonts)
+			font->BuildLookupTable();
+		atlas->TexReady = true;
+		return true;
+	}
+
+	bool FontAtlasCache::Store(ImFontAtlas* atlas, const std::string& directory)
+	{
+		if (directory.empty() || !atlas->IsBuilt())
+			return false;
+
+		uint8_t bytesPerPixel = atlas->TexPixelsAlpha8 ? 1 : 4;
+		const void* pixels = atlas->TexPixelsAlpha8 ? (const void*)atlas->TexPixelsAlpha8 : (const void*)atlas->TexPixelsRGBA32;
+		if (!pixels)
+			return false;
+
+		uint64_t key = GetKey(atlas);
+		std::vector<uint8_t> buffer;
+		Utils::Write(buffer, s_Magic);
+		Utils::Write(buffer, s_Version);
+		Utils::Write(buffer, key);
+		Utils::Write(buffer, (int32_t)atlas->TexWidth);
+		Utils::Write(buffer, (int32_t)atlas->TexHeight);
+		Utils::Write(buffer, bytesPerPixel);
+		Utils::Write(buffer, atlas->TexUvScale);
+		Utils::Write(buffer, atlas->TexUvWhitePixel);
+		Utils::Write(buffer, atlas->TexUvLines);
+		Utils::Write(buffer, (int32_t)atlas->PackIdMouseCursor);
+		Utils::Write(buffer, (int32_t)atlas->PackIdLines);
+
+		Utils::Write(buffer, (uint32_t)atlas->CustomRects.Size);
+		for (const ImFontAtlasCustomRect& rect : atlas->CustomRects)
+		{
+			CachedCustomRect cached = {};
+			cached.Width = rect.Width;
+			cached.Height = rect.Height;
+			cached.X = rect.X;
+			cached.Y = rect.Y;
+			cached.GlyphID = rect.GlyphID;
+			cached.GlyphAdvanceX = rect.GlyphAdvanceX;
+			cached.GlyphOffset = rect.GlyphOffset;
+			cached.FontIndex = rect.Font ? Utils::GetFontIndex(atlas, rect.Font) : -1;
+			Utils::Write(buffer, cached);
+		}
+
+		Utils::Write(buffer, (uint32_t)atlas->Fonts.Size);
+		for (const ImFont* font : atlas->Fonts)
+		{
+			Utils::Write(buffer, font->FontSize);
+			Utils::Write(buffer, font->Ascent);
+			Utils::Write(buffer, font->Descent);
+			Utils::Write(buffer, (int32_t)font->MetricsTotalSurface);
+			Utils::Write(buffer, (uint32_t)font->Glyphs.Size);
+			Utils::Write(buffer, font->Glyphs.Data, font->Glyphs.Size * sizeof(ImFontGlyph));
+		}
+
+		Utils::Write(buffer, pixels, (size_t)atlas->TexWidth * (size_t)atlas->TexHeight * bytesPerPixel);
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+
+		// Written under a temporary name and renamed, so another instance never reads a partial entry
+		std::filesystem::path path = Utils::GetPath(directory, key);
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream output(temporaryPath, std::ios::binary);
+			if (!output || !output.write((const char*)buffer.data(), buffer.size()))
+			{
+				std::cerr << "[FONT CACHE] Could not write " << temporaryPath.string() << "\n";
+				return false;
+			}
+		}
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool FontAtlasCache::Build(ImFontAtlas* atlas, const std::string& directory)
+	{
+		if (Load(atlas, directory))
+			return true;
+
+		atlas->Build();
+		Store(atlas, directory);
+		return false;
+	}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+struct ImFontAtlas;
+
+namespace Walnut {
+
+	// Rasterized ImGui font atlases on disk, so that only the first launch pays for stb_truetype.
+	// Entries hold the alpha texture and the glyph metrics of every font, and are keyed by the font data,
+	// sizes, glyph ranges and rasterizer settings of the atlas plus the ImGui version.
+	// Like ImFontAtlas::Build, these can only run on a worker thread while no other thread uses the atlas or ImGui,
+	// since every allocation bumps the current context's allocation counter.
+	class FontAtlasCache
+	{
+	public:
+		static uint64_t GetKey(ImFontAtlas* atlas);
+
+		// Fills an atlas whose fonts have been added but not built. Returns false if there is no valid entry.
+		static bool Load(ImFontAtlas* atlas, const std::string& directory);
+		static bool Store(ImFontAtlas* atlas, const std::string& directory);
+
+		// Load, or Build and Store on a miss. An empty directory disables the cache.
+		// Returns true if the atlas came from the cache.
+		static bool Build(ImFontAtlas* atlas, const std::string& directory);
+	};
+
+}
@@ -0,0 +1,665 @@
+#include "ImGuiBindlessRenderer.h"
+
+#include "Walnut/Application.h"
+#include "Walnut/MemoryTracker.h"
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+
+namespace Walnut {
+
+	// Generated at build time from Shaders/ImGuiBindless.{vert,frag} (glslc -mfmt=c)
+#ifndef WL_NO_SHADERS
+	static const uint32_t s_VertexShaderSPIRV[] =
+	#include "ImGuiBindless.vert.inl"
+	;
+	static const uint32_t s_FragmentShaderSPIRV[] =
+	#include "ImGuiBindless.frag.inl"
+	;
+#else
+	// Built without glslc, QuerySupport fails so these are never used
+	static const uint32_t s_VertexShaderSPIRV[] = { 0 };
+	static const uint32_t s_FragmentShaderSPIRV[] = { 0 };
+#endif
+
+	struct BindlessPushConstants
+	{
+		float Scale[2];
+		float Translate[2];
+		uint32_t TextureIndex;
+	};
+
+	struct BindlessFrameBuffers
+	{
+		VkBuffer VertexBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory VertexMemory = VK_NULL_HANDLE;
+		VkDeviceSize VertexSize = 0;
+		VkBuffer IndexBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory IndexMemory = VK_NULL_HANDLE;
+		VkDeviceSize IndexSize = 0;
+	};
+
+	struct BindlessData
+	{
+		ImGuiBindlessRenderer::InitInfo Info;
+		VkDescriptorSetLayout SetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool DescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+
+		std::vector<BindlessFrameBuffers> Frames;
+
+		std::mutex SlotMutex;
+		std::vector<uint32_t> FreeSlots;
+		uint32_t NextSlot = 0;
+		uint32_t UsedSlots = 0;
+		bool OverflowLogged = false;
+
+		// 1x1 white texture in slot 0, handed out when the slots run out
+		VkImage PlaceholderImage = VK_NULL_HANDLE;
+		VkDeviceMemory PlaceholderMemory = VK_NULL_HANDLE;
+		VkImageView PlaceholderView = VK_NULL_HANDLE;
+		VkSampler PlaceholderSampler = VK_NULL_HANDLE;
+	};
+
+	static BindlessData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static uint32_t GetVulkanMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
+		{
+			VkPhysicalDeviceMemoryProperties prop;
+			vkGetPhysicalDeviceMemoryProperties(s_Data->Info.PhysicalDevice, &prop);
+			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
+			{
+				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
+					return i;
+			}
+
+			return 0xffffffff;
+		}
+
+		static void CreateOrResizeBuffer(VkBuffer& buffer, VkDeviceMemory& memory, VkDeviceSize& bufferSize, VkDeviceSize newSize, VkBufferUsageFlagBits usage)
+		{
+			VkDevice device = s_Data->Info.Device;
+
+			// The old buffer may still be read by a frame in flight
+			Application::SubmitResourceFree(ResourceType::Buffer, (uint64_t)buffer);
+			Application::SubmitResourceFree(ResourceType::DeviceMemory, (uint64_t)memory);
+
+			VkBufferCreateInfo buffer_info = {};
+			buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			buffer_info.size = newSize;
+			buffer_info.usage = usage;
+			buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			VkResult err = vkCreateBuffer(device, &buffer_info, s_Data->Info.Allocator, &buffer);
+			check_vk_result(err);
+
+			VkMemoryRequirements req;
+			vkGetBufferMemoryRequirements(device, buffer, &req);
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = req.size;
+			alloc_info.memoryTypeIndex = GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, req.memoryTypeBits);
+			err = MemoryTracker::AllocateDeviceMemory(device, alloc_info, DeviceMemoryCategory::ImGui, &memory);
+			check_vk_result(err);
+			err = vkBindBufferMemory(device, buffer, memory, 0);
+			check_vk_result(err);
+			bufferSize = req.size;
+		}
+
+		static void WriteTextureSlot(uint32_t index, VkSampler sampler, VkImageView imageView, VkImageLayout imageLayout)
+		{
+			VkDescriptorImageInfo image_info = {};
+			image_info.sampler = sampler;
+			image_info.imageView = imageView;
+			image_info.imageLayout = imageLayout;
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = s_Data->DescriptorSet;
+			write.dstBinding = 0;
+			write.dstArrayElement = index;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.pImageInfo = &image_info;
+			vkUpdateDescriptorSets(s_Data->Info.Device, 1, &write, 0, nullptr);
+		}
+
+		static void CreatePlaceholderTexture()
+		{
+			VkDevice device = s_Data->Info.Device;
+			const VkAllocationCallbacks* allocator = s_Data->Info.Allocator;
+			VkResult err;
+
+			VkImageCreateInfo image_info = {};
+			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_info.imageType = VK_IMAGE_TYPE_2D;
+			image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+			image_info.extent = { 1, 1, 1 };
+			image_info.mipLevels = 1;
+			image_info.arrayLayers = 1;
+			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			err = vkCreateImage(device, &image_info, allocator, &s_Data->PlaceholderImage);
+			check_vk_result(err);
+
+			VkMemoryRequirements req;
+			vkGetImageMemoryRequirements(device, s_Data->PlaceholderImage, &req);
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = req.size;
+			alloc_info.memoryTypeIndex = GetVulkanMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
+			err = MemoryTracker::AllocateDeviceMemory(device, alloc_info, DeviceMemoryCategory::ImGui, &s_Data->PlaceholderMemory);
+			check_vk_result(err);
+			err = vkBindImageMemory(device, s_Data->PlaceholderImage, s_Data->PlaceholderMemory, 0);
+			check_vk_result(err);
+
+			VkImageViewCreateInfo view_info = {};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = s_Data->PlaceholderImage;
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			view_info.subresourceRange.levelCount = 1;
+			view_info.subresourceRange.layerCount = 1;
+			err = vkCreateImageView(device, &view_info, allocator, &s_Data->PlaceholderView);
+			check_vk_result(err);
+
+			VkSamplerCreateInfo sampler_info = {};
+			sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			sampler_info.magFilter = VK_FILTER_NEAREST;
+			sampler_info.minFilter = VK_FILTER_NEAREST;
+			sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			sampler_info.maxAnisotropy = 1.0f;
+			err = vkCreateSampler(device, &sampler_info, allocator, &s_Data->PlaceholderSampler);
+			check_vk_result(err);
+
+			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = s_Data->PlaceholderImage;
+			barrier.subresourceRange = view_info.subresourceRange;
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+			VkClearColorValue white = { { 1.0f, 1.0f, 1.0f, 1.0f } };
+			vkCmdClearColorImage(command_buffer, s_Data->PlaceholderImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &white, 1, &view_info.subresourceRange);
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+			Application::FlushCommandBuffer(command_buffer);
+
+			WriteTextureSlot(0, s_Data->PlaceholderSampler, s_Data->PlaceholderView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			s_Data->NextSlot = 1;
+		}
+
+	}
+
+	bool ImGuiBindlessRenderer::QuerySupport(VkPhysicalDevice physicalDevice, VkPhysicalDeviceDescriptorIndexingFeatures& outFeatures)
+	{
+#ifdef WL_NO_SHADERS
+		return false;
+#else
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_2)
+			return false;
+
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &indexingFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+		if (!indexingFeatures.runtimeDescriptorArray
+			|| !indexingFeatures.descriptorBindingPartiallyBound
+			|| !indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+			|| !indexingFeatures.descriptorBindingUpdateUnusedWhilePending)
+			return false;
+
+		outFeatures = {};
+		outFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		outFeatures.runtimeDescriptorArray = VK_TRUE;
+		outFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		outFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		outFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		return true;
+#endif
+	}
+
+	void ImGuiBindlessRenderer::Init(const InitInfo& info)
+	{
+		IM_ASSERT(!s_Data);
+		s_Data = new BindlessData();
+		s_Data->Info = info;
+
+		VkDevice device = info.Device;
+		VkResult err;
+
+		// Clamp the array to what the device allows for update-after-bind samplers
+		{
+			VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+			indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+			VkPhysicalDeviceProperties2 properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties.pNext = &indexingProperties;
+			vkGetPhysicalDeviceProperties2(info.PhysicalDevice, &properties);
+
+			uint32_t& maxTextures = s_Data->Info.MaxTextures;
+			maxTextures = std::min(maxTextures, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+			maxTextures = std::min(maxTextures, indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers);
+			maxTextures = std::min(maxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages);
+		}
+
+		// Descriptor set with one big combined image sampler array
+		{
+			VkDescriptorSetLayoutBinding binding = {};
+			binding.binding = 0;
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			binding.descriptorCount = s_Data->Info.MaxTextures;
+			binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+			VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+				| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+				| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+			VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			bindingFlagsInfo.bindingCount = 1;
+			bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+			VkDescriptorSetLayoutCreateInfo layout_info = {};
+			layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layout_info.pNext = &bindingFlagsInfo;
+			layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+			layout_info.bindingCount = 1;
+			layout_info.pBindings = &binding;
+			err = vkCreateDescriptorSetLayout(device, &layout_info, info.Allocator, &s_Data->SetLayout);
+			check_vk_result(err);
+
+			VkDescriptorPoolSize pool_size = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, s_Data->Info.MaxTextures };
+			VkDescriptorPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+			pool_info.maxSets = 1;
+			pool_info.poolSizeCount = 1;
+			pool_info.pPoolSizes = &pool_size;
+			err = vkCreateDescriptorPool(device, &pool_info, info.Allocator, &s_Data->DescriptorPool);
+			check_vk_result(err);
+
+			VkDescriptorSetAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			alloc_info.descriptorPool = s_Data->DescriptorPool;
+			alloc_info.descriptorSetCount = 1;
+			alloc_info.pSetLayouts = &s_Data->SetLayout;
+			err = vkAllocateDescriptorSets(device, &alloc_info, &s_Data->DescriptorSet);
+			check_vk_result(err);
+		}
+
+		// Pipeline, same state as the stock ImGui Vulkan backend
+		{
+			VkPushConstantRange push_constant = {};
+			push_constant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+			push_constant.offset = 0;
+			push_constant.size = sizeof(BindlessPushConstants);
+			VkPipelineLayoutCreateInfo layout_info = {};
+			layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layout_info.setLayoutCount = 1;
+			layout_info.pSetLayouts = &s_Data->SetLayout;
+			layout_info.pushConstantRangeCount = 1;
+			layout_info.pPushConstantRanges = &push_constant;
+			err = vkCreatePipelineLayout(device, &layout_info, info.Allocator, &s_Data->PipelineLayout);
+			check_vk_result(err);
+
+			VkShaderModule vertexModule, fragmentModule;
+			VkShaderModuleCreateInfo module_info = {};
+			module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			module_info.codeSize = sizeof(s_VertexShaderSPIRV);
+			module_info.pCode = s_VertexShaderSPIRV;
+			err = vkCreateShaderModule(device, &module_info, info.Allocator, &vertexModule);
+			check_vk_result(err);
+			module_info.codeSize = sizeof(s_FragmentShaderSPIRV);
+			module_info.pCode = s_FragmentShaderSPIRV;
+			err = vkCreateShaderModule(device, &module_info, info.Allocator, &fragmentModule);
+			check_vk_result(err);
+
+			VkPipelineShaderStageCreateInfo stages[2] = {};
+			stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+			stages[0].module = vertexModule;
+			stages[0].pName = "main";
+			stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+			stages[1].module = fragmentModule;
+			stages[1].pName = "main";
+
+			VkVertexInputBindingDescription binding_desc[1] = {};
+			binding_desc[0].stride = sizeof(ImDrawVert);
+			binding_desc[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			VkVertexInputAttributeDescription attribute_desc[3] = {};
+			attribute_desc[0].location = 0;
+			attribute_desc[0].format = VK_FORMAT_R32G32_SFLOAT;
+			attribute_desc[0].offset = IM_OFFSETOF(ImDrawVert, pos);
+			attribute_desc[1].location = 1;
+			attribute_desc[1].format = VK_FORMAT_R32G32_SFLOAT;
+			attribute_desc[1].offset = IM_OFFSETOF(ImDrawVert, uv);
+			attribute_desc[2].location = 2;
+			attribute_desc[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attribute_desc[2].offset = IM_OFFSETOF(ImDrawVert, col);
+
+			VkPipelineVertexInputStateCreateInfo vertex_info = {};
+			vertex_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertex_info.vertexBindingDescriptionCount = 1;
+			vertex_info.pVertexBindingDescriptions = binding_desc;
+			vertex_info.vertexAttributeDescriptionCount = 3;
+			vertex_info.pVertexAttributeDescriptions = attribute_desc;
+
+			VkPipelineInputAssemblyStateCreateInfo ia_info = {};
+			ia_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			ia_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+			VkPipelineViewportStateCreateInfo viewport_info = {};
+			viewport_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewport_info.viewportCount = 1;
+			viewport_info.scissorCount = 1;
+
+			VkPipelineRasterizationStateCreateInfo raster_info = {};
+			raster_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			raster_info.polygonMode = VK_POLYGON_MODE_FILL;
+			raster_info.cullMode = VK_CULL_MODE_NONE;
+			raster_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			raster_info.lineWidth = 1.0f;
+
+			VkPipelineMultisampleStateCreateInfo ms_info = {};
+			ms_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			ms_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+			VkPipelineColorBlendAttachmentState color_attachment[1] = {};
+			color_attachment[0].blendEnable = VK_TRUE;
+			color_attachment[0].srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+			color_attachment[0].dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			color_attachment[0].colorBlendOp = VK_BLEND_OP_ADD;
+			color_attachment[0].srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			color_attachment[0].dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			color_attachment[0].alphaBlendOp = VK_BLEND_OP_ADD;
+			color_attachment[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+			VkPipelineDepthStencilStateCreateInfo depth_info = {};
+			depth_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+			VkPipelineColorBlendStateCreateInfo blend_info = {};
+			blend_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			blend_info.attachmentCount = 1;
+			blend_info.pAttachments = color_attachment;
+
+			VkDynamicState dynamic_states[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+			VkPipelineDynamicStateCreateInfo dynamic_state = {};
+			dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamic_state.dynamicStateCount = (uint32_t)IM_ARRAYSIZE(dynamic_states);
+			dynamic_state.pDynamicStates = dynamic_states;
+
+			VkGraphicsPipelineCreateInfo pipeline_info = {};
+			pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipeline_info.stageCount = 2;
+			pipeline_info.pStages = stages;
+			pipeline_info.pVertexInputState = &vertex_info;
+			pipeline_info.pInputAssemblyState = &ia_info;
+			pipeline_info.pViewportState = &viewport_info;
+			pipeline_info.pRasterizationState = &raster_info;
+			pipeline_info.pMultisampleState = &ms_info;
+			pipeline_info.pDepthStencilState = &depth_info;
+			pipeline_info.pColorBlendState = &blend_info;
+			pipeline_info.pDynamicState = &dynamic_state;
+			pipeline_info.layout = s_Data->PipelineLayout;
+			pipeline_info.renderPass = info.RenderPass;
+			pipeline_info.subpass = 0;
+			err = vkCreateGraphicsPipelines(device, info.PipelineCache, 1, &pipeline_info, info.Allocator, &s_Data->Pipeline);
+			check_vk_result(err);
+
+			vkDestroyShaderModule(device, vertexModule, info.Allocator);
+			vkDestroyShaderModule(device, fragmentModule, info.Allocator);
+		}
+
+		Utils::CreatePlaceholderTexture();
+	}
+
+	void ImGuiBindlessRenderer::Shutdown()
+	{
+		if (!s_Data)
+			return;
+
+		VkDevice device = s_Data->Info.Device;
+		const VkAllocationCallbacks* allocator = s_Data->Info.Allocator;
+
+		for (BindlessFrameBuffers& frame : s_Data->Frames)
+		{
+			vkDestroyBuffer(device, frame.VertexBuffer, allocator);
+			MemoryTracker::FreeDeviceMemory(device, frame.VertexMemory);
+			vkDestroyBuffer(device, frame.IndexBuffer, allocator);
+			MemoryTracker::FreeDeviceMemory(device, frame.IndexMemory);
+		}
+
+		vkDestroySampler(device, s_Data->PlaceholderSampler, allocator);
+		vkDestroyImageView(device, s_Data->PlaceholderView, allocator);
+		vkDestroyImage(device, s_Data->PlaceholderImage, allocator);
+		MemoryTracker::FreeDeviceMemory(device, s_Data->PlaceholderMemory);
+
+		vkDestroyPipeline(device, s_Data->Pipeline, allocator);
+		vkDestroyPipelineLayout(device, s_Data->PipelineLayout, allocator);
+		vkDestroyDescriptorPool(device, s_Data->DescriptorPool, allocator);
+		vkDestroyDescriptorSetLayout(device, s_Data->SetLayout, allocator);
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	bool ImGuiBindlessRenderer::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+	uint32_t ImGuiBindlessRenderer::AddTexture(VkSampler sampler, VkImageView imageView, VkImageLayout imageLayout)
+	{
+		std::scoped_lock<std::mutex> lock(s_Data->SlotMutex);
+
+		uint32_t index;
+		if (!s_Data->FreeSlots.empty())
+		{
+			index = s_Data->FreeSlots.back();
+			s_Data->FreeSlots.pop_back();
+		}
+		else if (s_Data->NextSlot < s_Data->Info.MaxTextures)
+		{
+			index = s_Data->NextSlot++;
+		}
+		else
+		{
+			// The placeholder is drawn instead, it lives as long as the renderer
+			if (!s_Data->OverflowLogged)
+			{
+				std::cerr << "[ImGuiBindless] Out of bindless texture slots (" << s_Data->Info.MaxTextures << "), raise ApplicationSpecification::MaxBindlessTextures\n";
+				s_Data->OverflowLogged = true;
+			}
+			return 0;
+		}
+		s_Data->UsedSlots++;
+
+		Utils::WriteTextureSlot(index, sampler, imageView, imageLayout);
+		return index;
+	}
+
+	void ImGuiBindlessRenderer::RemoveTexture(uint32_t index)
+	{
+		// The descriptor is left as is, partially bound slots are fine as long as nothing draws with them
+		std::scoped_lock<std::mutex> lock(s_Data->SlotMutex);
+		if (index == 0)
+			return;
+		s_Data->FreeSlots.push_back(index);
+		s_Data->UsedSlots--;
+	}
+
+	uint32_t ImGuiBindlessRenderer::GetTextureCount()
+	{
+		std::scoped_lock<std::mutex> lock(s_Data->SlotMutex);
+		return s_Data->UsedSlots;
+	}
+
+	uint32_t ImGuiBindlessRenderer::GetMaxTextures()
+	{
+		return s_Data->Info.MaxTextures;
+	}
+
+	static void SetupRenderState(ImDrawData* drawData, VkCommandBuffer commandBuffer, const BindlessFrameBuffers& frame, int fbWidth, int fbHeight)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, s_Data->Pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, s_Data->PipelineLayout, 0, 1, &s_Data->DescriptorSet, 0, nullptr);
+
+		if (drawData->TotalVtxCount > 0)
+		{
+			VkBuffer vertex_buffers[1] = { frame.VertexBuffer };
+			VkDeviceSize vertex_offset[1] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertex_buffers, vertex_offset);
+			vkCmdBindIndexBuffer(commandBuffer, frame.IndexBuffer, 0, sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+		}
+
+		VkViewport viewport;
+		viewport.x = 0;
+		viewport.y = 0;
+		viewport.width = (float)fbWidth;
+		viewport.height = (float)fbHeight;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		float scale[2];
+		scale[0] = 2.0f / drawData->DisplaySize.x;
+		scale[1] = 2.0f / drawData->DisplaySize.y;
+		float translate[2];
+		translate[0] = -1.0f - drawData->DisplayPos.x * scale[0];
+		translate[1] = -1.0f - drawData->DisplayPos.y * scale[1];
+		vkCmdPushConstants(commandBuffer, s_Data->PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, IM_OFFSETOF(BindlessPushConstants, Scale), sizeof(scale), scale);
+		vkCmdPushConstants(commandBuffer, s_Data->PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, IM_OFFSETOF(BindlessPushConstants, Translate), sizeof(translate), translate);
+	}
+
+	void ImGuiBindlessRenderer::RenderDrawData(ImDrawData* drawData, VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		int fbWidth = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+		int fbHeight = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+		if (fbWidth <= 0 || fbHeight <= 0)
+			return;
+
+		VkDevice device = s_Data->Info.Device;
+
+		if (frameIndex >= s_Data->Frames.size())
+			s_Data->Frames.resize(frameIndex + 1);
+		BindlessFrameBuffers& frame = s_Data->Frames[frameIndex];
+
+		if (drawData->TotalVtxCount > 0)
+		{
+			VkDeviceSize vertexSize = drawData->TotalVtxCount * sizeof(ImDrawVert);
+			VkDeviceSize indexSize = drawData->TotalIdxCount * sizeof(ImDrawIdx);
+			if (frame.VertexBuffer == VK_NULL_HANDLE || frame.VertexSize < vertexSize)
+				Utils::CreateOrResizeBuffer(frame.VertexBuffer, frame.VertexMemory, frame.VertexSize, vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+			if (frame.IndexBuffer == VK_NULL_HANDLE || frame.IndexSize < indexSize)
+				Utils::CreateOrResizeBuffer(frame.IndexBuffer, frame.IndexMemory, frame.IndexSize, indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+			ImDrawVert* vtxDst = nullptr;
+			ImDrawIdx* idxDst = nullptr;
+			VkResult err = vkMapMemory(device, frame.VertexMemory, 0, vertexSize, 0, (void**)(&vtxDst));
+			check_vk_result(err);
+			err = vkMapMemory(device, frame.IndexMemory, 0, indexSize, 0, (void**)(&idxDst));
+			check_vk_result(err);
+			for (int n = 0; n < drawData->CmdListsCount; n++)
+			{
+				const ImDrawList* cmdList = drawData->CmdLists[n];
+				memcpy(vtxDst, cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size * sizeof(ImDrawVert));
+				memcpy(idxDst, cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size * sizeof(ImDrawIdx));
+				vtxDst += cmdList->VtxBuffer.Size;
+				idxDst += cmdList->IdxBuffer.Size;
+			}
+			vkUnmapMemory(device, frame.VertexMemory);
+			vkUnmapMemory(device, frame.IndexMemory);
+		}
+
+		SetupRenderState(drawData, commandBuffer, frame, fbWidth, fbHeight);
+
+		ImVec2 clipOffset = drawData->DisplayPos;
+		ImVec2 clipScale = drawData->FramebufferScale;
+
+		// The descriptor set stays bound for the whole frame, only the texture index changes
+		uint32_t boundTextureIndex = UINT32_MAX;
+		int globalVtxOffset = 0;
+		int globalIdxOffset = 0;
+		for (int n = 0; n < drawData->CmdListsCount; n++)
+		{
+			const ImDrawList* cmdList = drawData->CmdLists[n];
+			for (int cmd_i = 0; cmd_i < cmdList->CmdBuffer.Size; cmd_i++)
+			{
+				const ImDrawCmd* pcmd = &cmdList->CmdBuffer[cmd_i];
+				if (pcmd->UserCallback != nullptr)
+				{
+					if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+					{
+						SetupRenderState(drawData, commandBuffer, frame, fbWidth, fbHeight);
+						boundTextureIndex = UINT32_MAX;
+					}
+					else
+					{
+						pcmd->UserCallback(cmdList, pcmd);
+					}
+					continue;
+				}
+
+				ImVec2 clipMin((pcmd->ClipRect.x - clipOffset.x) * clipScale.x, (pcmd->ClipRect.y - clipOffset.y) * clipScale.y);
+				ImVec2 clipMax((pcmd->ClipRect.z - clipOffset.x) * clipScale.x, (pcmd->ClipRect.w - clipOffset.y) * clipScale.y);
+				if (clipMin.x < 0.0f) { clipMin.x = 0.0f; }
+				if (clipMin.y < 0.0f) { clipMin.y = 0.0f; }
+				if (clipMax.x > fbWidth) { clipMax.x = (float)fbWidth; }
+				if (clipMax.y > fbHeight) { clipMax.y = (float)fbHeight; }
+				if (clipMax.x <= clipMin.x || clipMax.y <= clipMin.y)
+					continue;
+
+				VkRect2D scissor;
+				scissor.offset.x = (int32_t)(clipMin.x);
+				scissor.offset.y = (int32_t)(clipMin.y);
+				scissor.extent.width = (uint32_t)(clipMax.x - clipMin.x);
+				scissor.extent.height = (uint32_t)(clipMax.y - clipMin.y);
+				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+				uint32_t textureIndex = GetTextureIndex(pcmd->GetTexID());
+				if (textureIndex != boundTextureIndex)
+				{
+					vkCmdPushConstants(commandBuffer, s_Data->PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+						IM_OFFSETOF(BindlessPushConstants, TextureIndex), sizeof(uint32_t), &textureIndex);
+					boundTextureIndex = textureIndex;
+				}
+
+				vkCmdDrawIndexed(commandBuffer, pcmd->ElemCount, 1, pcmd->IdxOffset + globalIdxOffset, pcmd->VtxOffset + globalVtxOffset, 0);
+			}
+			globalIdxOffset += cmdList->IdxBuffer.Size;
+			globalVtxOffset += cmdList->VtxBuffer.Size;
+		}
+
+		VkRect2D scissor = { { 0, 0 }, { (uint32_t)fbWidth, (uint32_t)fbHeight } };
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+}
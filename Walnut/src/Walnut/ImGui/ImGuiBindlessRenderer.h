@@ -0,0 +1,48 @@
+#pragma once
+
+#include "imgui.h"
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	// Optional replacement for ImGui_ImplVulkan_RenderDrawData that samples every texture from one
+	// descriptor array (VK_EXT_descriptor_indexing / Vulkan 1.2). The set is bound once per frame and
+	// draw commands only push the texture index, so switching between many images costs no rebinds.
+	//
+	// While enabled, every ImTextureID drawn by the main viewport is a bindless index (see GetTextureID),
+	// so textures have to be registered here (Walnut::Image does this automatically).
+	class ImGuiBindlessRenderer
+	{
+	public:
+		struct InitInfo
+		{
+			VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
+			VkDevice Device = VK_NULL_HANDLE;
+			VkPipelineCache PipelineCache = VK_NULL_HANDLE;
+			VkRenderPass RenderPass = VK_NULL_HANDLE;
+			const VkAllocationCallbacks* Allocator = nullptr;
+			uint32_t MaxTextures = 4096;
+		};
+
+		// Fills in the features the device has to be created with, returns false if they are not supported
+		static bool QuerySupport(VkPhysicalDevice physicalDevice, VkPhysicalDeviceDescriptorIndexingFeatures& outFeatures);
+
+		static void Init(const InitInfo& info);
+		static void Shutdown();
+		static bool IsInitialized();
+
+		// Slot 0 is a white placeholder owned by the renderer. It is returned once all MaxTextures slots are taken,
+		// logging it the first time, and removing it does nothing.
+		static uint32_t AddTexture(VkSampler sampler, VkImageView imageView, VkImageLayout imageLayout);
+		static void RemoveTexture(uint32_t index);
+
+		static ImTextureID GetTextureID(uint32_t index) { return (ImTextureID)(uintptr_t)(index + 1); }
+		static uint32_t GetTextureIndex(ImTextureID textureID) { return (uint32_t)((uintptr_t)textureID - 1); }
+
+		static uint32_t GetTextureCount();
+		static uint32_t GetMaxTextures();
+
+		static void RenderDrawData(ImDrawData* drawData, VkCommandBuffer commandBuffer, uint32_t frameIndex);
+	};
+
+}
@@ -0,0 +1,21 @@
+#version 450 core
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) out vec4 fColor;
+
+// One array for every texture ImGui draws with, indexed per draw command from the push constant
+layout(set = 0, binding = 0) uniform sampler2D sTextures[];
+
+layout(push_constant) uniform uPushConstant
+{
+	vec2 uScale;
+	vec2 uTranslate;
+	uint uTextureIndex;
+} pc;
+
+layout(location = 0) in struct { vec4 Color; vec2 UV; } In;
+
+void main()
+{
+	fColor = In.Color * texture(sTextures[pc.uTextureIndex], In.UV.st);
+}
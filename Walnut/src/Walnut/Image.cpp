@@ -4,6 +4,10 @@
 #include "backends/imgui_impl_vulkan.h"
 
 #include "Application.h"
+#include "Profiler.h"
+#include "Metrics.h"
+#include "MemoryTracker.h"
+#include "ImGui/ImGuiBindlessRenderer.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -67,14 +71,16 @@ namespace Walnut {
 		m_Width = width;
 		m_Height = height;
 		
+		MemoryTracker::RegisterImage(this);
 		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
 		SetData(data);
 		stbi_image_free(data);
 	}
 
-	Image::Image(uint32_t width, uint32_t height, ImageFormat format, const void* data)
-		: m_Width(width), m_Height(height), m_Format(format)
+	Image::Image(uint32_t width, uint32_t height, ImageFormat format, const void* data, ImageUsage usage)
+		: m_Width(width), m_Height(height), m_Format(format), m_Usage(usage)
 	{
+		MemoryTracker::RegisterImage(this);
 		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
 		if (data)
 			SetData(data);
@@ -82,6 +88,7 @@ namespace Walnut {
 
 	Image::~Image()
 	{
+		MemoryTracker::UnregisterImage(this);
 		Release();
 	}
 
@@ -107,9 +114,11 @@ namespace Walnut {
 			info.samples = VK_SAMPLE_COUNT_1_BIT;
 			info.tiling = VK_IMAGE_TILING_OPTIMAL;
 			info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			if (m_Usage == ImageUsage::Storage)
+				info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			err = vkCreateImage(device, &info, nullptr, &m_Image);
+			err = vkCreateImage(device, &info, Application::GetAllocator(), &m_Image);
 			check_vk_result(err);
 			VkMemoryRequirements req;
 			vkGetImageMemoryRequirements(device, m_Image, &req);
@@ -117,8 +126,9 @@ namespace Walnut {
 			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 			alloc_info.allocationSize = req.size;
 			alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
-			err = vkAllocateMemory(device, &alloc_info, nullptr, &m_Memory);
+			err = MemoryTracker::AllocateDeviceMemory(device, alloc_info, DeviceMemoryCategory::Image, &m_Memory);
 			check_vk_result(err);
+			m_MemorySize = req.size;
 			err = vkBindImageMemory(device, m_Image, m_Memory, 0);
 			check_vk_result(err);
 		}
@@ -133,7 +143,7 @@ namespace Walnut {
 			info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			info.subresourceRange.levelCount = 1;
 			info.subresourceRange.layerCount = 1;
-			err = vkCreateImageView(device, &info, nullptr, &m_ImageView);
+			err = vkCreateImageView(device, &info, Application::GetAllocator(), &m_ImageView);
 			check_vk_result(err);
 		}
 
@@ -150,28 +160,56 @@ namespace Walnut {
 			info.minLod = -1000;
 			info.maxLod = 1000;
 			info.maxAnisotropy = 1.0f;
-			VkResult err = vkCreateSampler(device, &info, nullptr, &m_Sampler);
+			VkResult err = vkCreateSampler(device, &info, Application::GetAllocator(), &m_Sampler);
 			check_vk_result(err);
 		}
 
-		// Create the Descriptor Set:
-		m_DescriptorSet = (VkDescriptorSet)ImGui_ImplVulkan_AddTexture(m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// Storage images are moved to GENERAL once, so compute shaders can write them without knowing their history
+		if (m_Usage == ImageUsage::Storage)
+		{
+			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = m_Image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+			Application::FlushCommandBuffer(command_buffer);
+		}
+
+		// Create the Descriptor Set (or take a slot in the bindless array, in which case the "set" is the ImTextureID):
+		if (Application::IsBindlessEnabled())
+		{
+			m_BindlessIndex = ImGuiBindlessRenderer::AddTexture(m_Sampler, m_ImageView, GetLayout());
+			m_DescriptorSet = (VkDescriptorSet)ImGuiBindlessRenderer::GetTextureID(m_BindlessIndex);
+		}
+		else
+		{
+			std::scoped_lock<std::mutex> lock(Application::GetDescriptorPoolMutex());
+			m_DescriptorSet = (VkDescriptorSet)ImGui_ImplVulkan_AddTexture(m_Sampler, m_ImageView, GetLayout());
+		}
 	}
 
 	void Image::Release()
 	{
-		Application::SubmitResourceFree([sampler = m_Sampler, imageView = m_ImageView, image = m_Image,
-			memory = m_Memory, stagingBuffer = m_StagingBuffer, stagingBufferMemory = m_StagingBufferMemory]()
-		{
-			VkDevice device = Application::GetDevice();
-
-			vkDestroySampler(device, sampler, nullptr);
-			vkDestroyImageView(device, imageView, nullptr);
-			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, memory, nullptr);
-			vkDestroyBuffer(device, stagingBuffer, nullptr);
-			vkFreeMemory(device, stagingBufferMemory, nullptr);
-		});
+		if (m_BindlessIndex != UINT32_MAX)
+			Application::SubmitResourceFree(ResourceType::BindlessTexture, (uint64_t)m_DescriptorSet);
+		else
+			Application::SubmitResourceFree(ResourceType::DescriptorSet, (uint64_t)m_DescriptorSet);
+		Application::SubmitResourceFree(ResourceType::Sampler, (uint64_t)m_Sampler);
+		Application::SubmitResourceFree(ResourceType::ImageView, (uint64_t)m_ImageView);
+		Application::SubmitResourceFree(ResourceType::Image, (uint64_t)m_Image);
+		Application::SubmitResourceFree(ResourceType::DeviceMemory, (uint64_t)m_Memory);
+		Application::SubmitResourceFree(ResourceType::Buffer, (uint64_t)m_StagingBuffer);
+		Application::SubmitResourceFree(ResourceType::DeviceMemory, (uint64_t)m_StagingBufferMemory);
 
 		m_Sampler = nullptr;
 		m_ImageView = nullptr;
@@ -179,13 +217,23 @@ namespace Walnut {
 		m_Memory = nullptr;
 		m_StagingBuffer = nullptr;
 		m_StagingBufferMemory = nullptr;
+		m_MemorySize = 0;
+		m_AlignedSize = 0;
+		m_DescriptorSet = nullptr;
+		m_BindlessIndex = UINT32_MAX;
 	}
 
 	void Image::SetData(const void* data)
 	{
+		WL_PROFILE_FUNCTION();
+		static Histogram& s_UploadLatency = MetricsRegistry::GetHistogram("Walnut/ImageUpload(us)");
+		static Counter& s_UploadBytes = MetricsRegistry::GetCounter("Walnut/ImageUploadBytes");
+		ScopedHistogramTimer uploadTimer(s_UploadLatency);
+
 		VkDevice device = Application::GetDevice();
 
 		size_t upload_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+		s_UploadBytes.Increment((int64_t)upload_size);
 
 		VkResult err;
 
@@ -198,7 +246,7 @@ namespace Walnut {
 				buffer_info.size = upload_size;
 				buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 				buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-				err = vkCreateBuffer(device, &buffer_info, nullptr, &m_StagingBuffer);
+				err = vkCreateBuffer(device, &buffer_info, Application::GetAllocator(), &m_StagingBuffer);
 				check_vk_result(err);
 				VkMemoryRequirements req;
 				vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
@@ -207,7 +255,7 @@ namespace Walnut {
 				alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 				alloc_info.allocationSize = req.size;
 				alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-				err = vkAllocateMemory(device, &alloc_info, nullptr, &m_StagingBufferMemory);
+				err = MemoryTracker::AllocateDeviceMemory(device, alloc_info, DeviceMemoryCategory::Staging, &m_StagingBufferMemory);
 				check_vk_result(err);
 				err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory, 0);
 				check_vk_result(err);
@@ -234,6 +282,7 @@ namespace Walnut {
 		// Copy to Image
 		{
 			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+			ScopedGpuTimer gpuTimer(command_buffer, "Image Upload");
 
 			VkImageMemoryBarrier copy_barrier = {};
 			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -261,15 +310,16 @@ namespace Walnut {
 			use_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 			use_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 			use_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			use_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			use_barrier.newLayout = GetLayout();
 			use_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			use_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			use_barrier.image = m_Image;
 			use_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			use_barrier.subresourceRange.levelCount = 1;
 			use_barrier.subresourceRange.layerCount = 1;
-			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &use_barrier);
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &use_barrier);
 
+			gpuTimer.End();
 			Application::FlushCommandBuffer(command_buffer);
 		}
 	}
@@ -13,21 +13,44 @@ namespace Walnut {
 		RGBA32F
 	};
 
+	enum class ImageUsage : uint8_t
+	{
+		Texture = 0,
+		// Can also be written by compute shaders (image2D). Storage images always stay in VK_IMAGE_LAYOUT_GENERAL.
+		Storage
+	};
+
 	class Image
 	{
 	public:
 		Image(std::string_view path);
-		Image(uint32_t width, uint32_t height, ImageFormat format, const void* data = nullptr);
+		Image(uint32_t width, uint32_t height, ImageFormat format, const void* data = nullptr, ImageUsage usage = ImageUsage::Texture);
 		~Image();
 
 		void SetData(const void* data);
 
+		// In bindless mode this is not a real descriptor set but the ImTextureID of the bindless slot
 		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+		uint32_t GetBindlessIndex() const { return m_BindlessIndex; }
 
 		void Resize(uint32_t width, uint32_t height);
 
 		uint32_t GetWidth() const { return m_Width; }
 		uint32_t GetHeight() const { return m_Height; }
+		ImageFormat GetFormat() const { return m_Format; }
+		ImageUsage GetUsage() const { return m_Usage; }
+
+		VkImage GetVulkanImage() const { return m_Image; }
+		VkImageView GetImageView() const { return m_ImageView; }
+		VkSampler GetSampler() const { return m_Sampler; }
+		// The layout the image is in whenever it's not being uploaded to
+		VkImageLayout GetLayout() const { return m_Usage == ImageUsage::Storage ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; }
+
+		// Device memory of the image and of its upload buffer, which is kept after the first SetData
+		uint64_t GetMemorySize() const { return m_MemorySize; }
+		uint64_t GetStagingMemorySize() const { return m_AlignedSize; }
+		// Empty for images created from memory
+		const std::string& GetFilepath() const { return m_Filepath; }
 	private:
 		void AllocateMemory(uint64_t size);
 		void Release();
@@ -37,9 +60,11 @@ namespace Walnut {
 		VkImage m_Image = nullptr;
 		VkImageView m_ImageView = nullptr;
 		VkDeviceMemory m_Memory = nullptr;
+		uint64_t m_MemorySize = 0;
 		VkSampler m_Sampler = nullptr;
 
 		ImageFormat m_Format = ImageFormat::None;
+		ImageUsage m_Usage = ImageUsage::Texture;
 
 		VkBuffer m_StagingBuffer = nullptr;
 		VkDeviceMemory m_StagingBufferMemory = nullptr;
@@ -47,6 +72,7 @@ namespace Walnut {
 		size_t m_AlignedSize = 0;
 
 		VkDescriptorSet m_DescriptorSet = nullptr;
+		uint32_t m_BindlessIndex = UINT32_MAX;
 
 		std::string m_Filepath;
 	};
@@ -4,29 +4,150 @@
 
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
 namespace Walnut {
 
+	static_assert(std::is_trivially_copyable<InputSnapshot>::value && sizeof(InputSnapshot) % sizeof(uint64_t) == 0);
+	static const uint32_t s_SnapshotWords = sizeof(InputSnapshot) / sizeof(uint64_t);
+
+	// Accumulated by the GLFW callbacks on the main thread between two CaptureFrame calls
+	static InputSnapshot s_Pending;
+
+	// Seqlock: odd while Publish is writing. The words are atomics so that readers never race the writer.
+	static std::atomic<uint64_t> s_Sequence = 0;
+	static std::atomic<uint64_t> s_Published[s_SnapshotWords];
+
+	struct ThreadSnapshot
+	{
+		uint64_t Sequence = UINT64_MAX;
+		InputSnapshot Snapshot;
+	};
+
+	static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+	{
+		if (key < 0 || key >= (int)InputSnapshot::KeyCount || action == GLFW_REPEAT)
+			return;
+
+		bool down = action == GLFW_PRESS;
+		InputSnapshot::SetKey(s_Pending.Keys, key, down);
+		if (down)
+			InputSnapshot::SetKey(s_Pending.KeysPressed, key, true);
+		else
+			InputSnapshot::SetKey(s_Pending.KeysReleased, key, true);
+	}
+
+	static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+	{
+		if (button < 0 || button > GLFW_MOUSE_BUTTON_LAST)
+			return;
+
+		uint8_t bit = (uint8_t)(1 << button);
+		if (action == GLFW_PRESS)
+		{
+			s_Pending.MouseButtons |= bit;
+			s_Pending.MouseButtonsPressed |= bit;
+		}
+		else
+		{
+			s_Pending.MouseButtons &= ~bit;
+			s_Pending.MouseButtonsReleased |= bit;
+		}
+	}
+
+	static void CursorPosCallback(GLFWwindow* window, double x, double y)
+	{
+		s_Pending.MouseX = (float)x;
+		s_Pending.MouseY = (float)y;
+	}
+
+	static void ScrollCallback(GLFWwindow* window, double x, double y)
+	{
+		s_Pending.ScrollX += (float)x;
+		s_Pending.ScrollY += (float)y;
+	}
+
+	static InputSnapshot ReadPublished(uint64_t& sequence)
+	{
+		uint64_t words[s_SnapshotWords];
+		while (true)
+		{
+			uint64_t begin = s_Sequence.load(std::memory_order_acquire);
+			if (begin & 1)
+				continue;
+
+			for (uint32_t i = 0; i < s_SnapshotWords; i++)
+				words[i] = s_Published[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (s_Sequence.load(std::memory_order_relaxed) == begin)
+			{
+				sequence = begin;
+				break;
+			}
+		}
+
+		InputSnapshot snapshot;
+		memcpy(&snapshot, words, sizeof(snapshot));
+		return snapshot;
+	}
+
+	// One acquire load per query while the frame hasn't changed
+	static const InputSnapshot& GetThreadSnapshot()
+	{
+		thread_local ThreadSnapshot cache;
+		if (s_Sequence.load(std::memory_order_acquire) != cache.Sequence)
+			cache.Snapshot = ReadPublished(cache.Sequence);
+		return cache.Snapshot;
+	}
+
 	bool Input::IsKeyDown(KeyCode keycode)
 	{
-		GLFWwindow* windowHandle = Application::Get().GetWindowHandle();
-		int state = glfwGetKey(windowHandle, (int)keycode);
-		return state == GLFW_PRESS || state == GLFW_REPEAT;
+		return GetThreadSnapshot().IsKeyDown(keycode);
+	}
+
+	bool Input::IsKeyPressed(KeyCode keycode)
+	{
+		return GetThreadSnapshot().IsKeyPressed(keycode);
+	}
+
+	bool Input::IsKeyReleased(KeyCode keycode)
+	{
+		return GetThreadSnapshot().IsKeyReleased(keycode);
 	}
 
 	bool Input::IsMouseButtonDown(MouseButton button)
 	{
-		GLFWwindow* windowHandle = Application::Get().GetWindowHandle();
-		int state = glfwGetMouseButton(windowHandle, (int)button);
-		return state == GLFW_PRESS;
+		return GetThreadSnapshot().IsMouseButtonDown(button);
+	}
+
+	bool Input::IsMouseButtonPressed(MouseButton button)
+	{
+		return GetThreadSnapshot().IsMouseButtonPressed(button);
+	}
+
+	bool Input::IsMouseButtonReleased(MouseButton button)
+	{
+		return GetThreadSnapshot().IsMouseButtonReleased(button);
 	}
 
 	glm::vec2 Input::GetMousePosition()
 	{
-		GLFWwindow* windowHandle = Application::Get().GetWindowHandle();
+		const InputSnapshot& snapshot = GetThreadSnapshot();
+		return { snapshot.MouseX, snapshot.MouseY };
+	}
 
-		double x, y;
-		glfwGetCursorPos(windowHandle, &x, &y);
-		return { (float)x, (float)y };
+	glm::vec2 Input::GetScrollDelta()
+	{
+		const InputSnapshot& snapshot = GetThreadSnapshot();
+		return { snapshot.ScrollX, snapshot.ScrollY };
+	}
+
+	InputSnapshot Input::GetSnapshot()
+	{
+		return GetThreadSnapshot();
 	}
 
 	void Input::SetCursorMode(CursorMode mode)
@@ -35,4 +156,48 @@ namespace Walnut {
 		glfwSetInputMode(windowHandle, GLFW_CURSOR, GLFW_CURSOR_NORMAL + (int)mode);
 	}
 
-}
\ No newline at end of file
+	void Input::Init(GLFWwindow* window)
+	{
+		s_Pending = {};
+		double x, y;
+		glfwGetCursorPos(window, &x, &y);
+		s_Pending.MouseX = (float)x;
+		s_Pending.MouseY = (float)y;
+
+		glfwSetKeyCallback(window, KeyCallback);
+		glfwSetMouseButtonCallback(window, MouseButtonCallback);
+		glfwSetCursorPosCallback(window, CursorPosCallback);
+		glfwSetScrollCallback(window, ScrollCallback);
+
+		Publish(s_Pending);
+	}
+
+	InputSnapshot Input::CaptureFrame()
+	{
+		InputSnapshot snapshot = s_Pending;
+		snapshot.Frame++;
+
+		s_Pending.Frame = snapshot.Frame;
+		memset(s_Pending.KeysPressed, 0, sizeof(s_Pending.KeysPressed));
+		memset(s_Pending.KeysReleased, 0, sizeof(s_Pending.KeysReleased));
+		s_Pending.MouseButtonsPressed = 0;
+		s_Pending.MouseButtonsReleased = 0;
+		s_Pending.ScrollX = 0.0f;
+		s_Pending.ScrollY = 0.0f;
+		return snapshot;
+	}
+
+	void Input::Publish(const InputSnapshot& snapshot)
+	{
+		uint64_t words[s_SnapshotWords];
+		memcpy(words, &snapshot, sizeof(snapshot));
+
+		uint64_t sequence = s_Sequence.load(std::memory_order_relaxed);
+		s_Sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (uint32_t i = 0; i < s_SnapshotWords; i++)
+			s_Published[i].store(words[i], std::memory_order_relaxed);
+		s_Sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+}
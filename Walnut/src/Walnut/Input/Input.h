@@ -1,20 +1,40 @@
 #pragma once
 
 #include "KeyCodes.h"
+#include "InputSnapshot.h"
 
 #include <glm/glm.hpp>
 
+struct GLFWwindow;
+
 namespace Walnut {
 
+	// Reads the input snapshot Application takes once per frame. Safe to call from any thread: every
+	// thread sees a consistent copy of the latest frame, refreshed on its first query after a new frame.
 	class Input
 	{
 	public:
 		static bool IsKeyDown(KeyCode keycode);
+		static bool IsKeyPressed(KeyCode keycode);
+		static bool IsKeyReleased(KeyCode keycode);
+
 		static bool IsMouseButtonDown(MouseButton button);
+		static bool IsMouseButtonPressed(MouseButton button);
+		static bool IsMouseButtonReleased(MouseButton button);
 
 		static glm::vec2 GetMousePosition();
+		static glm::vec2 GetScrollDelta();
 
+		static InputSnapshot GetSnapshot();
+
+		// Main thread only
 		static void SetCursorMode(CursorMode mode);
+
+		// Called by Application: Init before the ImGui backend installs its callbacks (they chain to ours),
+		// then CaptureFrame after polling events and Publish once the frame's state is final
+		static void Init(GLFWwindow* window);
+		static InputSnapshot CaptureFrame();
+		static void Publish(const InputSnapshot& snapshot);
 	};
 
 }
@@ -0,0 +1,440 @@
+#include "InputRecorder.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace Walnut {
+
+	// File layout (little endian):
+	//   header: "WLIR", uint32 version, float time step
+	//   frame:  uint8 flags, [uint64 keys[KeyWords]], [uint8 mouse buttons], [float x, y],
+	//           [uint64 pressed[KeyWords], released[KeyWords], uint8 buttons pressed, released], [float scroll x, y],
+	//           uint16 event count, events (uint8 type + payload)
+	// Held state is only written when it changed, edges and scroll only when there are any.
+	static const char s_Magic[4] = { 'W', 'L', 'I', 'R' };
+	static const uint32_t s_Version = 2;
+
+	enum InputFrameFlags : uint8_t
+	{
+		InputFrameFlags_Keys = 1 << 0,
+		InputFrameFlags_MouseButtons = 1 << 1,
+		InputFrameFlags_Cursor = 1 << 2,
+		InputFrameFlags_Edges = 1 << 3,
+		InputFrameFlags_Scroll = 1 << 4
+	};
+
+	struct InputRecorderData
+	{
+		// Recording
+		std::ofstream Output;
+		std::vector<uint8_t> FrameBuffer;
+		InputSnapshot LastRecorded;
+		float RecordTimeStep = 0.0f;
+
+		// Replay
+		std::vector<uint8_t> Replay;
+		size_t ReplayOffset = 0;
+		size_t EventsOffset = 0;
+		uint16_t EventCount = 0;
+		float ReplayTimeStep = 0.0f;
+		uint32_t ReplayFrame = 0;
+		InputSnapshot ReplaySnapshot; // Held state carries over between frames
+	};
+
+	static InputRecorderData* s_Data = nullptr;
+
+	namespace Utils {
+
+		template<typename T>
+		static void Write(std::vector<uint8_t>& buffer, const T& value)
+		{
+			const uint8_t* bytes = (const uint8_t*)&value;
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		template<typename T>
+		static bool Read(const std::vector<uint8_t>& buffer, size_t& offset, T& value)
+		{
+			if (offset + sizeof(T) > buffer.size())
+				return false;
+			memcpy(&value, buffer.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+
+		static size_t GetEventPayloadSize(uint8_t type)
+		{
+			switch (type)
+			{
+				case ImGuiInputEventType_MousePos:    return sizeof(float) * 2;
+				case ImGuiInputEventType_MouseWheel:  return sizeof(float) * 2;
+				case ImGuiInputEventType_MouseButton: return sizeof(uint8_t) * 2;
+				case ImGuiInputEventType_Key:         return sizeof(uint16_t) + sizeof(uint8_t) + sizeof(float);
+				case ImGuiInputEventType_Text:        return sizeof(uint32_t);
+				case ImGuiInputEventType_Focus:       return sizeof(uint8_t);
+			}
+			return 0;
+		}
+
+	}
+
+	bool InputRecorder::BeginRecording(const std::string& path, float timeStep)
+	{
+		EndRecording();
+		EndReplay();
+
+		std::ofstream output(path, std::ios::binary);
+		if (!output)
+		{
+			std::cerr << "[INPUT] Could not open " << path << "\n";
+			return false;
+		}
+
+		s_Data = new InputRecorderData();
+		s_Data->Output = std::move(output);
+		s_Data->RecordTimeStep = timeStep;
+		s_Data->FrameBuffer.reserve(1024);
+
+		// Forces the first frame to store the full state
+		memset(s_Data->LastRecorded.Keys, 0xff, sizeof(s_Data->LastRecorded.Keys));
+		s_Data->LastRecorded.MouseButtons = 0xff;
+		s_Data->LastRecorded.MouseX = -1.0f;
+
+		s_Data->Output.write(s_Magic, sizeof(s_Magic));
+		s_Data->Output.write((const char*)&s_Version, sizeof(s_Version));
+		s_Data->Output.write((const char*)&timeStep, sizeof(timeStep));
+		return true;
+	}
+
+	void InputRecorder::EndRecording()
+	{
+		if (!IsRecording())
+			return;
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	bool InputRecorder::IsRecording()
+	{
+		return s_Data && s_Data->Output.is_open();
+	}
+
+	bool InputRecorder::BeginReplay(const std::string& path)
+	{
+		EndRecording();
+		EndReplay();
+
+		std::ifstream input(path, std::ios::binary | std::ios::ate);
+		if (!input)
+		{
+			std::cerr << "[INPUT] Could not open " << path << "\n";
+			return false;
+		}
+
+		std::vector<uint8_t> replay((size_t)input.tellg());
+		input.seekg(0);
+		input.read((char*)replay.data(), replay.size());
+
+		size_t offset = 0;
+		char magic[4];
+		uint32_t version;
+		float timeStep;
+		if (!Utils::Read(replay, offset, magic) || memcmp(magic, s_Magic, sizeof(s_Magic)) != 0
+			|| !Utils::Read(replay, offset, version) || !Utils::Read(replay, offset, timeStep))
+		{
+			std::cerr << "[INPUT] " << path << " is not an input recording\n";
+			return false;
+		}
+		if (version != s_Version)
+		{
+			std::cerr << "[INPUT] " << path << " is a version " << version << " recording, only version " << s_Version << " can be replayed\n";
+			return false;
+		}
+
+		s_Data = new InputRecorderData();
+		s_Data->Replay = std::move(replay);
+		s_Data->ReplayOffset = offset;
+		s_Data->ReplayTimeStep = timeStep;
+		return true;
+	}
+
+	void InputRecorder::EndReplay()
+	{
+		if (!IsReplaying())
+			return;
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	bool InputRecorder::IsReplaying()
+	{
+		return s_Data && !s_Data->Replay.empty();
+	}
+
+	float InputRecorder::GetReplayTimeStep()
+	{
+		return IsReplaying() ? s_Data->ReplayTimeStep : 0.0f;
+	}
+
+	uint32_t InputRecorder::GetReplayFrame()
+	{
+		return IsReplaying() ? s_Data->ReplayFrame : 0;
+	}
+
+	static bool HasEdges(const InputSnapshot& snapshot)
+	{
+		for (uint32_t i = 0; i < InputSnapshot::KeyWords; i++)
+		{
+			if (snapshot.KeysPressed[i] || snapshot.KeysReleased[i])
+				return true;
+		}
+		return snapshot.MouseButtonsPressed || snapshot.MouseButtonsReleased;
+	}
+
+	bool InputRecorder::BeginFrame(InputSnapshot& snapshot)
+	{
+		if (IsRecording())
+		{
+			InputSnapshot& last = s_Data->LastRecorded;
+			uint8_t flags = 0;
+			if (memcmp(snapshot.Keys, last.Keys, sizeof(snapshot.Keys)) != 0)
+				flags |= InputFrameFlags_Keys;
+			if (snapshot.MouseButtons != last.MouseButtons)
+				flags |= InputFrameFlags_MouseButtons;
+			if (snapshot.MouseX != last.MouseX || snapshot.MouseY != last.MouseY)
+				flags |= InputFrameFlags_Cursor;
+			if (HasEdges(snapshot))
+				flags |= InputFrameFlags_Edges;
+			if (snapshot.ScrollX != 0.0f || snapshot.ScrollY != 0.0f)
+				flags |= InputFrameFlags_Scroll;
+
+			std::vector<uint8_t>& buffer = s_Data->FrameBuffer;
+			buffer.clear();
+			Utils::Write(buffer, flags);
+			if (flags & InputFrameFlags_Keys)
+				Utils::Write(buffer, snapshot.Keys);
+			if (flags & InputFrameFlags_MouseButtons)
+				Utils::Write(buffer, snapshot.MouseButtons);
+			if (flags & InputFrameFlags_Cursor)
+			{
+				Utils::Write(buffer, snapshot.MouseX);
+				Utils::Write(buffer, snapshot.MouseY);
+			}
+			if (flags & InputFrameFlags_Edges)
+			{
+				Utils::Write(buffer, snapshot.KeysPressed);
+				Utils::Write(buffer, snapshot.KeysReleased);
+				Utils::Write(buffer, snapshot.MouseButtonsPressed);
+				Utils::Write(buffer, snapshot.MouseButtonsReleased);
+			}
+			if (flags & InputFrameFlags_Scroll)
+			{
+				Utils::Write(buffer, snapshot.ScrollX);
+				Utils::Write(buffer, snapshot.ScrollY);
+			}
+			last = snapshot;
+			return true;
+		}
+
+		if (!IsReplaying())
+			return true;
+
+		const std::vector<uint8_t>& replay = s_Data->Replay;
+		size_t& offset = s_Data->ReplayOffset;
+		InputSnapshot& recorded = s_Data->ReplaySnapshot;
+
+		uint8_t flags;
+		if (!Utils::Read(replay, offset, flags))
+			return false;
+
+		memset(recorded.KeysPressed, 0, sizeof(recorded.KeysPressed));
+		memset(recorded.KeysReleased, 0, sizeof(recorded.KeysReleased));
+		recorded.MouseButtonsPressed = 0;
+		recorded.MouseButtonsReleased = 0;
+		recorded.ScrollX = 0.0f;
+		recorded.ScrollY = 0.0f;
+
+		bool valid = true;
+		if (flags & InputFrameFlags_Keys)
+			valid &= Utils::Read(replay, offset, recorded.Keys);
+		if (flags & InputFrameFlags_MouseButtons)
+			valid &= Utils::Read(replay, offset, recorded.MouseButtons);
+		if (flags & InputFrameFlags_Cursor)
+			valid &= Utils::Read(replay, offset, recorded.MouseX) && Utils::Read(replay, offset, recorded.MouseY);
+		if (flags & InputFrameFlags_Edges)
+		{
+			valid &= Utils::Read(replay, offset, recorded.KeysPressed) && Utils::Read(replay, offset, recorded.KeysReleased)
+				&& Utils::Read(replay, offset, recorded.MouseButtonsPressed) && Utils::Read(replay, offset, recorded.MouseButtonsReleased);
+		}
+		if (flags & InputFrameFlags_Scroll)
+			valid &= Utils::Read(replay, offset, recorded.ScrollX) && Utils::Read(replay, offset, recorded.ScrollY);
+		valid &= Utils::Read(replay, offset, s_Data->EventCount);
+		if (!valid)
+		{
+			std::cerr << "[INPUT] Recording is truncated in frame " << s_Data->ReplayFrame << ", stopping the replay\n";
+			return false;
+		}
+
+		// Events are applied in ProcessImGuiEvents, skip over them for now. An unknown type leaves the rest of
+		// the file undecodable, so the replay stops rather than reading events at the wrong offset.
+		s_Data->EventsOffset = offset;
+		for (uint16_t i = 0; i < s_Data->EventCount; i++)
+		{
+			uint8_t type;
+			if (!Utils::Read(replay, offset, type))
+			{
+				std::cerr << "[INPUT] Recording is truncated in frame " << s_Data->ReplayFrame << ", stopping the replay\n";
+				return false;
+			}
+			size_t payloadSize = Utils::GetEventPayloadSize(type);
+			if (payloadSize == 0)
+			{
+				std::cerr << "[INPUT] Unknown event type " << (uint32_t)type << " in frame " << s_Data->ReplayFrame << ", stopping the replay\n";
+				return false;
+			}
+			offset += payloadSize;
+		}
+		if (offset > replay.size())
+		{
+			std::cerr << "[INPUT] Recording is truncated in frame " << s_Data->ReplayFrame << ", stopping the replay\n";
+			return false;
+		}
+
+		uint64_t frame = snapshot.Frame;
+		snapshot = recorded;
+		snapshot.Frame = frame;
+		s_Data->ReplayFrame++;
+		return true;
+	}
+
+	void InputRecorder::ProcessImGuiEvents()
+	{
+		ImGuiContext& g = *ImGui::GetCurrentContext();
+		ImGuiIO& io = ImGui::GetIO();
+
+		if (IsRecording())
+		{
+			std::vector<uint8_t>& buffer = s_Data->FrameBuffer;
+			size_t countOffset = buffer.size();
+			uint16_t count = 0;
+			Utils::Write(buffer, count);
+
+			for (const ImGuiInputEvent& event : g.InputEventsQueue)
+			{
+				// Viewport IDs only mean something within one session
+				if (event.Type == ImGuiInputEventType_MouseViewport || Utils::GetEventPayloadSize((uint8_t)event.Type) == 0)
+					continue;
+
+				Utils::Write(buffer, (uint8_t)event.Type);
+				switch (event.Type)
+				{
+					case ImGuiInputEventType_MousePos:
+						Utils::Write(buffer, event.MousePos.PosX);
+						Utils::Write(buffer, event.MousePos.PosY);
+						break;
+					case ImGuiInputEventType_MouseWheel:
+						Utils::Write(buffer, event.MouseWheel.WheelX);
+						Utils::Write(buffer, event.MouseWheel.WheelY);
+						break;
+					case ImGuiInputEventType_MouseButton:
+						Utils::Write(buffer, (uint8_t)event.MouseButton.Button);
+						Utils::Write(buffer, (uint8_t)event.MouseButton.Down);
+						break;
+					case ImGuiInputEventType_Key:
+						Utils::Write(buffer, (uint16_t)event.Key.Key);
+						Utils::Write(buffer, (uint8_t)event.Key.Down);
+						Utils::Write(buffer, event.Key.AnalogValue);
+						break;
+					case ImGuiInputEventType_Text:
+						Utils::Write(buffer, (uint32_t)event.Text.Char);
+						break;
+					case ImGuiInputEventType_Focus:
+						Utils::Write(buffer, (uint8_t)event.AppFocused.Focused);
+						break;
+					default:
+						break;
+				}
+				count++;
+			}
+
+			memcpy(buffer.data() + countOffset, &count, sizeof(count));
+			s_Data->Output.write((const char*)buffer.data(), buffer.size());
+			return;
+		}
+
+		if (!IsReplaying())
+			return;
+
+		// Drop whatever the platform backend queued this frame and feed the recorded events instead
+		g.InputEventsQueue.resize(0);
+		io.DeltaTime = s_Data->ReplayTimeStep;
+
+		const std::vector<uint8_t>& replay = s_Data->Replay;
+		size_t offset = s_Data->EventsOffset;
+		for (uint16_t i = 0; i < s_Data->EventCount; i++)
+		{
+			uint8_t type;
+			Utils::Read(replay, offset, type);
+			switch (type)
+			{
+				case ImGuiInputEventType_MousePos:
+				{
+					float x, y;
+					Utils::Read(replay, offset, x);
+					Utils::Read(replay, offset, y);
+					io.AddMousePosEvent(x, y);
+					break;
+				}
+				case ImGuiInputEventType_MouseWheel:
+				{
+					float x, y;
+					Utils::Read(replay, offset, x);
+					Utils::Read(replay, offset, y);
+					io.AddMouseWheelEvent(x, y);
+					break;
+				}
+				case ImGuiInputEventType_MouseButton:
+				{
+					uint8_t button, down;
+					Utils::Read(replay, offset, button);
+					Utils::Read(replay, offset, down);
+					io.AddMouseButtonEvent(button, down != 0);
+					break;
+				}
+				case ImGuiInputEventType_Key:
+				{
+					uint16_t key;
+					uint8_t down;
+					float analogValue;
+					Utils::Read(replay, offset, key);
+					Utils::Read(replay, offset, down);
+					Utils::Read(replay, offset, analogValue);
+					io.AddKeyAnalogEvent((ImGuiKey)key, down != 0, analogValue);
+					break;
+				}
+				case ImGuiInputEventType_Text:
+				{
+					uint32_t c;
+					Utils::Read(replay, offset, c);
+					io.AddInputCharacter(c);
+					break;
+				}
+				case ImGuiInputEventType_Focus:
+				{
+					uint8_t focused;
+					Utils::Read(replay, offset, focused);
+					io.AddFocusEvent(focused != 0);
+					break;
+				}
+			}
+		}
+	}
+
+}
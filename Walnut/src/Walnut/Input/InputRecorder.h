@@ -0,0 +1,33 @@
+#pragma once
+
+#include "InputSnapshot.h"
+
+#include <string>
+
+namespace Walnut {
+
+	// Records the per-frame input snapshot and the ImGui input events into a compact binary file, and plays
+	// them back with a fixed timestep. While replaying, live input is ignored, so two replays of the same
+	// file drive the application through exactly the same frames.
+	class InputRecorder
+	{
+	public:
+		// timeStep is stored in the file and used for every frame of the replay
+		static bool BeginRecording(const std::string& path, float timeStep = 1.0f / 60.0f);
+		static void EndRecording();
+		static bool IsRecording();
+
+		static bool BeginReplay(const std::string& path);
+		static void EndReplay();
+		static bool IsReplaying();
+		static float GetReplayTimeStep();
+		static uint32_t GetReplayFrame();
+
+		// Called by Application with the frame's live snapshot, which is recorded or replaced by the
+		// recorded one. Returns false once the replay has run out of frames or hits a frame it cannot decode.
+		static bool BeginFrame(InputSnapshot& snapshot);
+		// Called by Application between the platform backend's NewFrame and ImGui::NewFrame
+		static void ProcessImGuiEvents();
+	};
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "KeyCodes.h"
+
+#include <stdint.h>
+
+namespace Walnut {
+
+	// Keyboard, mouse and cursor state of one frame, packed as bitsets. Pressed/released edges and
+	// the scroll delta cover everything that happened since the previous frame, so short taps aren't lost.
+	struct InputSnapshot
+	{
+		static const uint32_t KeyCount = 349; // GLFW_KEY_LAST + 1
+		static const uint32_t KeyWords = (KeyCount + 63) / 64;
+
+		uint64_t Keys[KeyWords] = {};
+		uint64_t KeysPressed[KeyWords] = {};
+		uint64_t KeysReleased[KeyWords] = {};
+		float MouseX = 0.0f, MouseY = 0.0f;
+		float ScrollX = 0.0f, ScrollY = 0.0f;
+		uint64_t Frame = 0;
+		uint8_t MouseButtons = 0;
+		uint8_t MouseButtonsPressed = 0;
+		uint8_t MouseButtonsReleased = 0;
+
+		bool IsKeyDown(KeyCode keycode) const { return TestKey(Keys, keycode); }
+		bool IsKeyPressed(KeyCode keycode) const { return TestKey(KeysPressed, keycode); }
+		bool IsKeyReleased(KeyCode keycode) const { return TestKey(KeysReleased, keycode); }
+
+		bool IsMouseButtonDown(MouseButton button) const { return (MouseButtons >> (uint32_t)button) & 1; }
+		bool IsMouseButtonPressed(MouseButton button) const { return (MouseButtonsPressed >> (uint32_t)button) & 1; }
+		bool IsMouseButtonReleased(MouseButton button) const { return (MouseButtonsReleased >> (uint32_t)button) & 1; }
+
+		static bool TestKey(const uint64_t* bits, KeyCode keycode)
+		{
+			uint32_t key = (uint32_t)keycode;
+			return key < KeyCount && (bits[key / 64] >> (key % 64)) & 1;
+		}
+
+		static void SetKey(uint64_t* bits, uint32_t key, bool value)
+		{
+			if (value)
+				bits[key / 64] |= 1ull << (key % 64);
+			else
+				bits[key / 64] &= ~(1ull << (key % 64));
+		}
+	};
+
+}
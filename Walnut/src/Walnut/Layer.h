@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <stdint.h>
+
 namespace Walnut {
 
 	class Layer
@@ -10,8 +13,30 @@ namespace Walnut {
 		virtual void OnAttach() {}
 		virtual void OnDetach() {}
 
+		// ts is the time since the layer's last OnUpdate, which is more than a frame when its schedule skips frames
 		virtual void OnUpdate(float ts) {}
 		virtual void OnUIRender() {}
 	};
 
-}
\ No newline at end of file
+	// How Application runs a layer (Application::PushLayer, SetLayerSchedule)
+	struct LayerSchedule
+	{
+		// Disabled layers get neither OnUpdate nor OnUIRender, but stay attached
+		bool Enabled = true;
+
+		// OnUpdate every UpdateDivider-th frame, or at UpdateRate Hz when that is set
+		uint32_t UpdateDivider = 1;
+		float UpdateRate = 0.0f;
+
+		// The ImGui window the layer draws. While it is collapsed or an inactive dock tab, Application submits
+		// the empty window in place of OnUIRender (which keeps the tab) and skips OnUpdate unless UpdateWhenHidden.
+		std::string WindowName;
+		bool UpdateWhenHidden = true;
+
+		// OnUpdate milliseconds per frame. A layer that takes longer is updated less often, with a larger ts,
+		// until its average fits. AllowThrottle lets ApplicationSpecification::LayerBudgetMillis do the same.
+		float BudgetMillis = 0.0f;
+		bool AllowThrottle = false;
+	};
+
+}
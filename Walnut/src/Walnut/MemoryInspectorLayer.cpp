@@ -0,0 +1,148 @@
+#include "MemoryInspectorLayer.h"
+
+#include "MemoryTracker.h"
+
+#include <cstdio>
+
+namespace Walnut {
+
+	namespace Utils {
+
+		static const char* FormatBytes(uint64_t bytes, char* buffer, size_t size)
+		{
+			if (bytes >= 1024ull * 1024 * 1024)
+				snprintf(buffer, size, "%.2f GB", (double)bytes / (1024.0 * 1024.0 * 1024.0));
+			else if (bytes >= 1024 * 1024)
+				snprintf(buffer, size, "%.2f MB", (double)bytes / (1024.0 * 1024.0));
+			else if (bytes >= 1024)
+				snprintf(buffer, size, "%.1f KB", (double)bytes / 1024.0);
+			else
+				snprintf(buffer, size, "%llu B", (unsigned long long)bytes);
+			return buffer;
+		}
+
+		static void UsageRow(const char* name, const MemoryUsage& usage)
+		{
+			char buffer[32];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(name);
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(FormatBytes(usage.Bytes, buffer, sizeof(buffer)));
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(FormatBytes(usage.PeakBytes, buffer, sizeof(buffer)));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)usage.Allocations);
+		}
+
+		static bool BeginUsageTable(const char* id)
+		{
+			if (!ImGui::BeginTable(id, 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+				return false;
+
+			ImGui::TableSetupColumn("");
+			ImGui::TableSetupColumn("Live");
+			ImGui::TableSetupColumn("Peak");
+			ImGui::TableSetupColumn("Allocations");
+			ImGui::TableHeadersRow();
+			return true;
+		}
+
+	}
+
+	void MemoryInspectorLayer::OnUIRender()
+	{
+		if (m_ToggleKey != ImGuiKey_None && ImGui::IsKeyPressed(m_ToggleKey, false))
+			m_Visible = !m_Visible;
+
+		if (!m_Visible)
+			return;
+
+		ImGui::SetNextWindowSize(ImVec2(520.0f, 600.0f), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin("Memory", &m_Visible))
+		{
+			ImGui::End();
+			return;
+		}
+
+		MemoryStats stats = MemoryTracker::GetStats();
+		char buffer[32], buffer2[32];
+
+		if (ImGui::CollapsingHeader("Device Heaps", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			if (!stats.BudgetSupported)
+				ImGui::TextDisabled("VK_EXT_memory_budget unavailable, only Walnut's own allocations are known");
+
+			for (size_t i = 0; i < stats.Heaps.size(); i++)
+			{
+				const MemoryHeapBudget& heap = stats.Heaps[i];
+				uint64_t used = stats.BudgetSupported ? heap.Usage : heap.WalnutBytes;
+				uint64_t budget = stats.BudgetSupported && heap.Budget > 0 ? heap.Budget : heap.Size;
+
+				ImGui::Text("Heap %zu (%s), Walnut %s", i, heap.DeviceLocal ? "device local" : "host", Utils::FormatBytes(heap.WalnutBytes, buffer, sizeof(buffer)));
+				char overlay[64];
+				snprintf(overlay, sizeof(overlay), "%s / %s", Utils::FormatBytes(used, buffer, sizeof(buffer)), Utils::FormatBytes(budget, buffer2, sizeof(buffer2)));
+				ImGui::ProgressBar(budget > 0 ? (float)((double)used / (double)budget) : 0.0f, ImVec2(-1.0f, 0.0f), overlay);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Device Memory", ImGuiTreeNodeFlags_DefaultOpen) && Utils::BeginUsageTable("Device"))
+		{
+			for (size_t i = 0; i < (size_t)DeviceMemoryCategory::Count; i++)
+				Utils::UsageRow(GetDeviceMemoryCategoryName((DeviceMemoryCategory)i), stats.Device[i]);
+			ImGui::EndTable();
+		}
+
+		if (ImGui::CollapsingHeader("Host Memory (Vulkan)") && Utils::BeginUsageTable("Host"))
+		{
+			static const char* s_ScopeNames[] = { "Command", "Object", "Cache", "Device", "Instance" };
+			for (int i = 0; i < IM_ARRAYSIZE(s_ScopeNames); i++)
+				Utils::UsageRow(s_ScopeNames[i], stats.Host[i]);
+			Utils::UsageRow("Driver internal", stats.HostInternal);
+			ImGui::EndTable();
+		}
+
+		std::vector<LiveImage> images = MemoryTracker::GetLiveImages();
+		snprintf(buffer2, sizeof(buffer2), "Images (%zu)###Images", images.size());
+		if (ImGui::CollapsingHeader(buffer2, ImGuiTreeNodeFlags_DefaultOpen)
+			&& ImGui::BeginTable("Images", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp, ImVec2(0.0f, 300.0f)))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Image");
+			ImGui::TableSetupColumn("Size");
+			ImGui::TableSetupColumn("Memory");
+			ImGui::TableSetupColumn("Staging");
+			ImGui::TableHeadersRow();
+
+			ImGuiListClipper clipper;
+			clipper.Begin((int)images.size());
+			while (clipper.Step())
+			{
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+				{
+					const LiveImage& image = images[i];
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(image.Name.empty() ? "(memory)" : image.Name.c_str());
+					if (ImGui::IsItemHovered() && image.DescriptorSet)
+					{
+						float scale = 128.0f / (float)(image.Width > image.Height ? image.Width : image.Height);
+						ImGui::BeginTooltip();
+						ImGui::Image(image.DescriptorSet, ImVec2(image.Width * scale, image.Height * scale));
+						ImGui::EndTooltip();
+					}
+					ImGui::TableNextColumn();
+					ImGui::Text("%ux%u", image.Width, image.Height);
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(Utils::FormatBytes(image.Bytes, buffer, sizeof(buffer)));
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(Utils::FormatBytes(image.StagingBytes, buffer, sizeof(buffer)));
+				}
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Layer.h"
+
+#include "imgui.h"
+
+namespace Walnut {
+
+	// Window with MemoryTracker's host, device and heap budget numbers plus every live Image, largest first.
+	// Application draws it after all other layers; the toggle key (ApplicationSpecification::MemoryInspectorToggleKey) shows and hides it.
+	class MemoryInspectorLayer : public Layer
+	{
+	public:
+		MemoryInspectorLayer(ImGuiKey toggleKey, bool visible)
+			: m_ToggleKey(toggleKey), m_Visible(visible) {}
+
+		virtual void OnUIRender() override;
+
+		void SetVisible(bool visible) { m_Visible = visible; }
+		bool IsVisible() const { return m_Visible; }
+	private:
+		ImGuiKey m_ToggleKey;
+		bool m_Visible;
+	};
+
+}
@@ -0,0 +1,333 @@
+#include "MemoryTracker.h"
+
+#include "Image.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Walnut {
+
+	struct AtomicMemoryUsage
+	{
+		std::atomic<uint64_t> Bytes = 0;
+		std::atomic<uint64_t> PeakBytes = 0;
+		std::atomic<uint64_t> Allocations = 0;
+
+		void Add(uint64_t bytes)
+		{
+			UpdatePeak(Bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+			Allocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void Remove(uint64_t bytes)
+		{
+			Bytes.fetch_sub(bytes, std::memory_order_relaxed);
+			Allocations.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void Set(uint64_t bytes, uint64_t allocations)
+		{
+			Bytes.store(bytes, std::memory_order_relaxed);
+			Allocations.store(allocations, std::memory_order_relaxed);
+			UpdatePeak(bytes);
+		}
+
+		void UpdatePeak(uint64_t current)
+		{
+			uint64_t peak = PeakBytes.load(std::memory_order_relaxed);
+			while (current > peak && !PeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+		}
+
+		MemoryUsage Get() const
+		{
+			return { Bytes.load(std::memory_order_relaxed), PeakBytes.load(std::memory_order_relaxed), Allocations.load(std::memory_order_relaxed) };
+		}
+	};
+
+	struct DeviceAllocation
+	{
+		DeviceMemoryCategory Category;
+		uint32_t Heap;
+		uint64_t Size;
+	};
+
+	// Lives for the whole process, the allocation callbacks can outlive any Application
+	struct MemoryTrackerData
+	{
+		AtomicMemoryUsage Host[VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1];
+		AtomicMemoryUsage HostInternal;
+		AtomicMemoryUsage Device[(size_t)DeviceMemoryCategory::Count];
+
+		VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties MemoryProperties = {};
+		bool MemoryBudget = false;
+
+		std::mutex Mutex;
+		std::unordered_map<VkDeviceMemory, DeviceAllocation> DeviceAllocations;
+		uint64_t HeapBytes[VK_MAX_MEMORY_HEAPS] = {};
+		std::unordered_set<const Image*> Images;
+	};
+
+	static MemoryTrackerData s_Data;
+
+	namespace Utils {
+
+		// In front of every allocation, so free and realloc know the size and scope
+		struct HostAllocationHeader
+		{
+			uint64_t Size;
+			uint32_t Offset; // From the start of the underlying allocation
+			uint32_t Scope;
+		};
+
+		static const size_t s_HeaderSize = 16;
+		static_assert(sizeof(HostAllocationHeader) <= s_HeaderSize, "Header doesn't fit");
+
+		static HostAllocationHeader* GetHeader(void* memory)
+		{
+			return (HostAllocationHeader*)((uint8_t*)memory - s_HeaderSize);
+		}
+
+		static void* VKAPI_PTR HostAllocate(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			if (size == 0)
+				return nullptr;
+
+			// Alignment is a power of two, so the header slot keeps the user pointer aligned
+			size_t offset = std::max(alignment, s_HeaderSize);
+#ifdef _MSC_VER
+			uint8_t* base = (uint8_t*)_aligned_malloc(offset + size, offset);
+#else
+			uint8_t* base = (uint8_t*)std::aligned_alloc(offset, (offset + size + offset - 1) & ~(offset - 1));
+#endif
+			if (!base)
+				return nullptr;
+
+			uint8_t* memory = base + offset;
+			HostAllocationHeader* header = GetHeader(memory);
+			header->Size = size;
+			header->Offset = (uint32_t)offset;
+			header->Scope = (uint32_t)scope;
+
+			s_Data.Host[scope].Add(size);
+			return memory;
+		}
+
+		static void VKAPI_PTR HostFree(void* userData, void* memory)
+		{
+			if (!memory)
+				return;
+
+			HostAllocationHeader* header = GetHeader(memory);
+			s_Data.Host[header->Scope].Remove(header->Size);
+#ifdef _MSC_VER
+			_aligned_free((uint8_t*)memory - header->Offset);
+#else
+			std::free((uint8_t*)memory - header->Offset);
+#endif
+		}
+
+		static void* VKAPI_PTR HostReallocate(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			if (!original)
+				return HostAllocate(userData, size, alignment, scope);
+			if (size == 0)
+			{
+				HostFree(userData, original);
+				return nullptr;
+			}
+
+			void* memory = HostAllocate(userData, size, alignment, scope);
+			if (!memory)
+				return nullptr;
+			memcpy(memory, original, std::min<size_t>(size, GetHeader(original)->Size));
+			HostFree(userData, original);
+			return memory;
+		}
+
+		static void VKAPI_PTR HostInternalAllocation(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+		{
+			s_Data.HostInternal.Add(size);
+		}
+
+		static void VKAPI_PTR HostInternalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+		{
+			s_Data.HostInternal.Remove(size);
+		}
+
+		static const VkAllocationCallbacks s_AllocationCallbacks =
+		{
+			nullptr,
+			HostAllocate,
+			HostReallocate,
+			HostFree,
+			HostInternalAllocation,
+			HostInternalFree
+		};
+
+		static void UpdateDeviceGauge()
+		{
+			static Gauge& s_DeviceBytes = MetricsRegistry::GetGauge("Walnut/DeviceMemoryBytes");
+
+			uint64_t bytes = 0;
+			for (const AtomicMemoryUsage& usage : s_Data.Device)
+				bytes += usage.Bytes.load(std::memory_order_relaxed);
+			s_DeviceBytes.Set((double)bytes);
+		}
+
+	}
+
+	const char* GetDeviceMemoryCategoryName(DeviceMemoryCategory category)
+	{
+		switch (category)
+		{
+			case DeviceMemoryCategory::Image:     return "Images";
+			case DeviceMemoryCategory::Staging:   return "Staging";
+			case DeviceMemoryCategory::Buffer:    return "Buffers";
+			case DeviceMemoryCategory::Readback:  return "Readback";
+			case DeviceMemoryCategory::Swapchain: return "Swapchain";
+			case DeviceMemoryCategory::ImGui:     return "ImGui";
+		}
+		return "Unknown";
+	}
+
+	void MemoryTracker::Init(VkPhysicalDevice physicalDevice, bool memoryBudget)
+	{
+		std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+		s_Data.PhysicalDevice = physicalDevice;
+		s_Data.MemoryBudget = memoryBudget;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &s_Data.MemoryProperties);
+	}
+
+	const VkAllocationCallbacks* MemoryTracker::GetAllocationCallbacks()
+	{
+		return &Utils::s_AllocationCallbacks;
+	}
+
+	VkResult MemoryTracker::AllocateDeviceMemory(VkDevice device, const VkMemoryAllocateInfo& info, DeviceMemoryCategory category, VkDeviceMemory* outMemory)
+	{
+		VkResult err = vkAllocateMemory(device, &info, GetAllocationCallbacks(), outMemory);
+		if (err != VK_SUCCESS)
+			return err;
+
+		{
+			std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+			uint32_t heap = info.memoryTypeIndex < s_Data.MemoryProperties.memoryTypeCount ? s_Data.MemoryProperties.memoryTypes[info.memoryTypeIndex].heapIndex : 0;
+			s_Data.DeviceAllocations[*outMemory] = { category, heap, info.allocationSize };
+			s_Data.HeapBytes[heap] += info.allocationSize;
+		}
+		s_Data.Device[(size_t)category].Add(info.allocationSize);
+		Utils::UpdateDeviceGauge();
+		return err;
+	}
+
+	void MemoryTracker::FreeDeviceMemory(VkDevice device, VkDeviceMemory memory)
+	{
+		if (!memory)
+			return;
+
+		// Forgotten before it's freed, another thread may get the same handle right after
+		bool tracked = false;
+		DeviceAllocation allocation;
+		{
+			std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+			auto it = s_Data.DeviceAllocations.find(memory);
+			if (it != s_Data.DeviceAllocations.end())
+			{
+				tracked = true;
+				allocation = it->second;
+				s_Data.DeviceAllocations.erase(it);
+				s_Data.HeapBytes[allocation.Heap] -= allocation.Size;
+			}
+		}
+
+		vkFreeMemory(device, memory, GetAllocationCallbacks());
+
+		if (tracked)
+		{
+			s_Data.Device[(size_t)allocation.Category].Remove(allocation.Size);
+			Utils::UpdateDeviceGauge();
+		}
+	}
+
+	void MemoryTracker::SetSwapchainMemory(uint64_t bytes, uint32_t imageCount)
+	{
+		s_Data.Device[(size_t)DeviceMemoryCategory::Swapchain].Set(bytes, imageCount);
+		Utils::UpdateDeviceGauge();
+	}
+
+	void MemoryTracker::RegisterImage(const Image* image)
+	{
+		std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+		s_Data.Images.insert(image);
+	}
+
+	void MemoryTracker::UnregisterImage(const Image* image)
+	{
+		std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+		s_Data.Images.erase(image);
+	}
+
+	MemoryStats MemoryTracker::GetStats()
+	{
+		MemoryStats stats;
+		for (uint32_t i = 0; i <= VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE; i++)
+			stats.Host[i] = s_Data.Host[i].Get();
+		stats.HostInternal = s_Data.HostInternal.Get();
+		for (size_t i = 0; i < (size_t)DeviceMemoryCategory::Count; i++)
+			stats.Device[i] = s_Data.Device[i].Get();
+
+		std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+		if (!s_Data.PhysicalDevice)
+			return stats;
+
+		const VkPhysicalDeviceMemoryProperties& properties = s_Data.MemoryProperties;
+		stats.Heaps.resize(properties.memoryHeapCount);
+		for (uint32_t i = 0; i < properties.memoryHeapCount; i++)
+		{
+			stats.Heaps[i].Size = properties.memoryHeaps[i].size;
+			stats.Heaps[i].DeviceLocal = (properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			stats.Heaps[i].WalnutBytes = s_Data.HeapBytes[i];
+		}
+
+		if (s_Data.MemoryBudget)
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+			budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+			VkPhysicalDeviceMemoryProperties2 properties2 = {};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties2.pNext = &budget;
+			vkGetPhysicalDeviceMemoryProperties2(s_Data.PhysicalDevice, &properties2);
+
+			for (uint32_t i = 0; i < properties.memoryHeapCount; i++)
+			{
+				stats.Heaps[i].Usage = budget.heapUsage[i];
+				stats.Heaps[i].Budget = budget.heapBudget[i];
+			}
+			stats.BudgetSupported = true;
+		}
+
+		return stats;
+	}
+
+	std::vector<LiveImage> MemoryTracker::GetLiveImages()
+	{
+		std::vector<LiveImage> images;
+		{
+			std::scoped_lock<std::mutex> lock(s_Data.Mutex);
+			images.reserve(s_Data.Images.size());
+			for (const Image* image : s_Data.Images)
+				images.push_back({ image, image->GetFilepath(), image->GetWidth(), image->GetHeight(), image->GetMemorySize(), image->GetStagingMemorySize(), image->GetDescriptorSet() });
+		}
+
+		std::sort(images.begin(), images.end(), [](const LiveImage& a, const LiveImage& b) { return a.Bytes > b.Bytes; });
+		return images;
+	}
+
+}
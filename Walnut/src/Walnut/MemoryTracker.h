@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	class Image;
+
+	// What Walnut allocated a VkDeviceMemory for
+	enum class DeviceMemoryCategory : uint8_t
+	{
+		Image = 0,
+		Staging,   // Image and Buffer uploads
+		Buffer,
+		Readback,  // Buffer::ReadData, FrameCapture
+		Swapchain, // Estimated, the presentation engine owns the memory
+		ImGui,     // Vertex and index buffers and the placeholder texture of the bindless renderer
+		Count
+	};
+
+	const char* GetDeviceMemoryCategoryName(DeviceMemoryCategory category);
+
+	struct MemoryUsage
+	{
+		uint64_t Bytes = 0;
+		uint64_t PeakBytes = 0;
+		uint64_t Allocations = 0; // Live ones
+	};
+
+	struct MemoryHeapBudget
+	{
+		uint64_t Size = 0;
+		bool DeviceLocal = false;
+		uint64_t WalnutBytes = 0; // Allocated through MemoryTracker
+		// From VK_EXT_memory_budget, the whole process as the driver sees it. 0 without the extension.
+		uint64_t Usage = 0;
+		uint64_t Budget = 0;
+	};
+
+	struct MemoryStats
+	{
+		// Host allocations made by the driver through the allocation callbacks, by VkSystemAllocationScope
+		MemoryUsage Host[VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1];
+		// Driver-internal allocations it only reported (executable memory)
+		MemoryUsage HostInternal;
+		MemoryUsage Device[(size_t)DeviceMemoryCategory::Count];
+
+		std::vector<MemoryHeapBudget> Heaps;
+		bool BudgetSupported = false;
+	};
+
+	struct LiveImage
+	{
+		const Image* Handle = nullptr;
+		std::string Name; // File path, empty for images created from memory
+		uint32_t Width = 0, Height = 0;
+		uint64_t Bytes = 0;
+		uint64_t StagingBytes = 0;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE; // Valid for the current frame
+	};
+
+	// Host memory the driver allocates through Walnut's VkAllocationCallbacks, device memory Walnut allocates
+	// (by category and heap) and the live images. Everything is counted as it happens, GetStats() only copies.
+	class MemoryTracker
+	{
+	public:
+		// Called by Application once the device exists
+		static void Init(VkPhysicalDevice physicalDevice, bool memoryBudget);
+
+		// Pass these wherever Vulkan takes a pAllocator, objects have to be destroyed with the callbacks they were created with
+		static const VkAllocationCallbacks* GetAllocationCallbacks();
+
+		// vkAllocateMemory/vkFreeMemory with accounting. Freeing memory that wasn't tracked just frees it.
+		static VkResult AllocateDeviceMemory(VkDevice device, const VkMemoryAllocateInfo& info, DeviceMemoryCategory category, VkDeviceMemory* outMemory);
+		static void FreeDeviceMemory(VkDevice device, VkDeviceMemory memory);
+		// Replaces the previous estimate
+		static void SetSwapchainMemory(uint64_t bytes, uint32_t imageCount);
+
+		static void RegisterImage(const Image* image);
+		static void UnregisterImage(const Image* image);
+
+		// Queries the budget if VK_EXT_memory_budget is enabled
+		static MemoryStats GetStats();
+		// Largest first
+		static std::vector<LiveImage> GetLiveImages();
+	};
+
+}
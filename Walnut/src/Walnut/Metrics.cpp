@@ -0,0 +1,347 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Walnut {
+
+	namespace Utils {
+
+		static uint32_t MostSignificantBit(uint64_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return (uint32_t)index;
+#else
+			return 63 - (uint32_t)__builtin_clzll(value);
+#endif
+		}
+
+		static void AtomicMin(std::atomic<uint64_t>& target, uint64_t value)
+		{
+			uint64_t current = target.load(std::memory_order_relaxed);
+			while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+		}
+
+		static void AtomicMax(std::atomic<uint64_t>& target, uint64_t value)
+		{
+			uint64_t current = target.load(std::memory_order_relaxed);
+			while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+		}
+
+		static uint64_t PercentileFromBuckets(const uint64_t* buckets, uint64_t count, double percentile)
+		{
+			if (count == 0)
+				return 0;
+
+			uint64_t rank = (uint64_t)(percentile / 100.0 * (double)count + 0.5);
+			if (rank < 1)
+				rank = 1;
+			if (rank > count)
+				rank = count;
+
+			uint64_t seen = 0;
+			for (uint32_t i = 0; i < Histogram::BucketCount; i++)
+			{
+				seen += buckets[i];
+				if (seen >= rank)
+					return Histogram::BucketUpperBound(i);
+			}
+			return Histogram::BucketUpperBound(Histogram::BucketCount - 1);
+		}
+
+		static Histogram::Summary Summarize(const uint64_t* buckets, uint64_t count, uint64_t sum, uint64_t min, uint64_t max)
+		{
+			Histogram::Summary summary;
+			summary.Count = count;
+			if (count == 0)
+				return summary;
+
+			summary.Min = min;
+			summary.Max = max;
+			summary.Mean = (double)sum / (double)count;
+			// Clamp to the exact extremes, the bucket bounds can overshoot them
+			summary.P50 = std::min(PercentileFromBuckets(buckets, count, 50.0), max);
+			summary.P90 = std::min(PercentileFromBuckets(buckets, count, 90.0), max);
+			summary.P95 = std::min(PercentileFromBuckets(buckets, count, 95.0), max);
+			summary.P99 = std::min(PercentileFromBuckets(buckets, count, 99.0), max);
+			summary.P999 = std::min(PercentileFromBuckets(buckets, count, 99.9), max);
+			return summary;
+		}
+
+	}
+
+	uint32_t Histogram::BucketIndex(uint64_t value)
+	{
+		if (value < SubBucketCount)
+			return (uint32_t)value;
+
+		uint32_t exponent = Utils::MostSignificantBit(value) - SubBucketBits + 1;
+		uint32_t mantissa = (uint32_t)(value >> (exponent - 1)); // In [SubBucketCount, 2 * SubBucketCount)
+		return exponent * SubBucketCount + (mantissa - SubBucketCount);
+	}
+
+	uint64_t Histogram::BucketUpperBound(uint32_t index)
+	{
+		if (index < SubBucketCount)
+			return index;
+
+		uint32_t exponent = index / SubBucketCount;
+		uint64_t mantissa = (index % SubBucketCount) + SubBucketCount;
+		return ((mantissa + 1) << (exponent - 1)) - 1;
+	}
+
+	void Histogram::Record(uint64_t value)
+	{
+		m_Buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		m_Sum.fetch_add(value, std::memory_order_relaxed);
+		Utils::AtomicMin(m_Min, value);
+		Utils::AtomicMax(m_Max, value);
+	}
+
+	uint64_t Histogram::Percentile(double percentile) const
+	{
+		uint64_t buckets[BucketCount];
+		uint64_t count = 0;
+		for (uint32_t i = 0; i < BucketCount; i++)
+		{
+			buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+			count += buckets[i];
+		}
+		return Utils::PercentileFromBuckets(buckets, count, percentile);
+	}
+
+	Histogram::Summary Histogram::GetSummary() const
+	{
+		uint64_t buckets[BucketCount];
+		uint64_t count = 0;
+		for (uint32_t i = 0; i < BucketCount; i++)
+		{
+			buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+			count += buckets[i];
+		}
+		return Utils::Summarize(buckets, count, m_Sum.load(std::memory_order_relaxed),
+			m_Min.load(std::memory_order_relaxed), m_Max.load(std::memory_order_relaxed));
+	}
+
+	Histogram::Summary Histogram::Drain()
+	{
+		uint64_t buckets[BucketCount];
+		uint64_t count = 0;
+		for (uint32_t i = 0; i < BucketCount; i++)
+		{
+			buckets[i] = m_Buckets[i].exchange(0, std::memory_order_relaxed);
+			count += buckets[i];
+		}
+		uint64_t sum = m_Sum.exchange(0, std::memory_order_relaxed);
+		uint64_t min = m_Min.exchange(UINT64_MAX, std::memory_order_relaxed);
+		uint64_t max = m_Max.exchange(0, std::memory_order_relaxed);
+		return Utils::Summarize(buckets, count, sum, min, max);
+	}
+
+	void Histogram::Reset()
+	{
+		for (uint32_t i = 0; i < BucketCount; i++)
+			m_Buckets[i].store(0, std::memory_order_relaxed);
+		m_Sum.store(0, std::memory_order_relaxed);
+		m_Min.store(UINT64_MAX, std::memory_order_relaxed);
+		m_Max.store(0, std::memory_order_relaxed);
+	}
+
+	struct MetricsRegistryData
+	{
+		std::mutex Mutex;
+		std::map<std::string, std::unique_ptr<Counter>> Counters;
+		std::map<std::string, std::unique_ptr<Gauge>> Gauges;
+		std::map<std::string, std::unique_ptr<Histogram>> Histograms;
+
+		Timer Clock;
+
+		float SnapshotInterval = 0.0f;
+		std::string SnapshotPath;
+		Timer SnapshotTimer;
+		bool SnapshotHeaderWritten = false;
+	};
+
+	static MetricsRegistryData& GetData()
+	{
+		static MetricsRegistryData data;
+		return data;
+	}
+
+	template<typename T>
+	static T& GetOrCreate(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name)
+	{
+		std::scoped_lock<std::mutex> lock(GetData().Mutex);
+		std::unique_ptr<T>& metric = metrics[name];
+		if (!metric)
+			metric = std::make_unique<T>();
+		return *metric;
+	}
+
+	Counter& MetricsRegistry::GetCounter(const std::string& name)
+	{
+		return GetOrCreate(GetData().Counters, name);
+	}
+
+	Gauge& MetricsRegistry::GetGauge(const std::string& name)
+	{
+		return GetOrCreate(GetData().Gauges, name);
+	}
+
+	Histogram& MetricsRegistry::GetHistogram(const std::string& name)
+	{
+		return GetOrCreate(GetData().Histograms, name);
+	}
+
+	MetricsSnapshot MetricsRegistry::Snapshot(bool resetHistograms)
+	{
+		MetricsRegistryData& data = GetData();
+		std::scoped_lock<std::mutex> lock(data.Mutex);
+
+		MetricsSnapshot snapshot;
+		snapshot.Time = data.Clock.Elapsed();
+		snapshot.Metrics.reserve(data.Counters.size() + data.Gauges.size() + data.Histograms.size());
+
+		for (auto& [name, counter] : data.Counters)
+		{
+			MetricSnapshot& metric = snapshot.Metrics.emplace_back();
+			metric.Name = name;
+			metric.Type = MetricType::Counter;
+			metric.Value = (double)counter->Get();
+		}
+
+		for (auto& [name, gauge] : data.Gauges)
+		{
+			MetricSnapshot& metric = snapshot.Metrics.emplace_back();
+			metric.Name = name;
+			metric.Type = MetricType::Gauge;
+			metric.Value = gauge->Get();
+		}
+
+		for (auto& [name, histogram] : data.Histograms)
+		{
+			MetricSnapshot& metric = snapshot.Metrics.emplace_back();
+			metric.Name = name;
+			metric.Type = MetricType::Histogram;
+			metric.Summary = resetHistograms ? histogram->Drain() : histogram->GetSummary();
+			metric.Value = metric.Summary.Mean;
+		}
+
+		return snapshot;
+	}
+
+	static const char* MetricTypeToString(MetricType type)
+	{
+		switch (type)
+		{
+			case MetricType::Counter:   return "counter";
+			case MetricType::Gauge:     return "gauge";
+			case MetricType::Histogram: return "histogram";
+		}
+		return "";
+	}
+
+	static void WriteCSVHeader(std::ofstream& stream)
+	{
+		stream << "time,name,type,value,count,min,max,mean,p50,p90,p95,p99,p999\n";
+	}
+
+	static void WriteCSVRows(std::ofstream& stream, const MetricsSnapshot& snapshot)
+	{
+		for (const MetricSnapshot& metric : snapshot.Metrics)
+		{
+			const Histogram::Summary& s = metric.Summary;
+			stream << snapshot.Time << ",\"" << metric.Name << "\"," << MetricTypeToString(metric.Type) << ',' << metric.Value << ','
+				<< s.Count << ',' << s.Min << ',' << s.Max << ',' << s.Mean << ','
+				<< s.P50 << ',' << s.P90 << ',' << s.P95 << ',' << s.P99 << ',' << s.P999 << '\n';
+		}
+	}
+
+	bool MetricsRegistry::ExportCSV(const std::string& path, const MetricsSnapshot& snapshot, bool append)
+	{
+		std::ofstream stream(path, append ? std::ios::app : std::ios::trunc);
+		if (!stream)
+		{
+			std::cerr << "[METRICS] Could not open " << path << "\n";
+			return false;
+		}
+
+		stream << std::fixed << std::setprecision(3);
+		if (!append)
+			WriteCSVHeader(stream);
+		WriteCSVRows(stream, snapshot);
+		return true;
+	}
+
+	bool MetricsRegistry::ExportJSON(const std::string& path, const MetricsSnapshot& snapshot)
+	{
+		std::ofstream stream(path);
+		if (!stream)
+		{
+			std::cerr << "[METRICS] Could not open " << path << "\n";
+			return false;
+		}
+
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\n  \"time\": " << snapshot.Time << ",\n  \"metrics\": [";
+		for (size_t i = 0; i < snapshot.Metrics.size(); i++)
+		{
+			const MetricSnapshot& metric = snapshot.Metrics[i];
+			stream << (i ? ",\n" : "\n") << "    { \"name\": \"" << metric.Name << "\", \"type\": \"" << MetricTypeToString(metric.Type) << "\"";
+			if (metric.Type == MetricType::Histogram)
+			{
+				const Histogram::Summary& s = metric.Summary;
+				stream << ", \"count\": " << s.Count << ", \"min\": " << s.Min << ", \"max\": " << s.Max << ", \"mean\": " << s.Mean
+					<< ", \"p50\": " << s.P50 << ", \"p90\": " << s.P90 << ", \"p95\": " << s.P95 << ", \"p99\": " << s.P99 << ", \"p999\": " << s.P999;
+			}
+			else
+			{
+				stream << ", \"value\": " << metric.Value;
+			}
+			stream << " }";
+		}
+		stream << "\n  ]\n}\n";
+		return true;
+	}
+
+	void MetricsRegistry::SetPeriodicSnapshot(float intervalSeconds, const std::string& csvPath)
+	{
+		MetricsRegistryData& data = GetData();
+		std::scoped_lock<std::mutex> lock(data.Mutex);
+		data.SnapshotInterval = intervalSeconds;
+		data.SnapshotPath = csvPath;
+		data.SnapshotHeaderWritten = false;
+		data.SnapshotTimer.Reset();
+	}
+
+	void MetricsRegistry::Update()
+	{
+		MetricsRegistryData& data = GetData();
+		bool append;
+		std::string path;
+		{
+			std::scoped_lock<std::mutex> lock(data.Mutex);
+			if (data.SnapshotInterval <= 0.0f || data.SnapshotTimer.Elapsed() < data.SnapshotInterval)
+				return;
+
+			data.SnapshotTimer.Reset();
+			append = data.SnapshotHeaderWritten;
+			data.SnapshotHeaderWritten = true;
+			path = data.SnapshotPath;
+		}
+
+		ExportCSV(path, Snapshot(true), append);
+	}
+
+}
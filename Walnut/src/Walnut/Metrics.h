@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Timer.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Walnut {
+
+	// All metric types can be updated from any thread without locking
+
+	class Counter
+	{
+	public:
+		void Increment(int64_t amount = 1) { m_Value.fetch_add(amount, std::memory_order_relaxed); }
+		int64_t Get() const { return m_Value.load(std::memory_order_relaxed); }
+	private:
+		std::atomic<int64_t> m_Value = 0;
+	};
+
+	class Gauge
+	{
+	public:
+		void Set(double value) { m_Value.store(value, std::memory_order_relaxed); }
+		double Get() const { return m_Value.load(std::memory_order_relaxed); }
+	private:
+		std::atomic<double> m_Value = 0.0;
+	};
+
+	// Log-linear histogram with fixed memory: every power of two is split into 2^SubBucketBits linear
+	// buckets, so percentiles are accurate to ~3% of the value across the whole uint64_t range.
+	class Histogram
+	{
+	public:
+		static const uint32_t SubBucketBits = 5;
+		static const uint32_t SubBucketCount = 1 << SubBucketBits;
+		static const uint32_t BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+		struct Summary
+		{
+			uint64_t Count = 0;
+			uint64_t Min = 0, Max = 0;
+			double Mean = 0.0;
+			uint64_t P50 = 0, P90 = 0, P95 = 0, P99 = 0, P999 = 0;
+		};
+	public:
+		Histogram() { Reset(); }
+
+		void Record(uint64_t value);
+
+		// Percentile in [0, 100], returns the upper bound of the bucket holding it
+		uint64_t Percentile(double percentile) const;
+		Summary GetSummary() const;
+
+		// Summarizes and clears in one pass, samples recorded concurrently end up in either this or the next interval
+		Summary Drain();
+		void Reset();
+
+		static uint32_t BucketIndex(uint64_t value);
+		static uint64_t BucketUpperBound(uint32_t index);
+	private:
+		std::atomic<uint64_t> m_Buckets[BucketCount];
+		std::atomic<uint64_t> m_Sum;
+		std::atomic<uint64_t> m_Min;
+		std::atomic<uint64_t> m_Max;
+	};
+
+	// Records the lifetime of the scope into a histogram, in microseconds
+	class ScopedHistogramTimer
+	{
+	public:
+		ScopedHistogramTimer(Histogram& histogram)
+			: m_Histogram(histogram) {}
+		~ScopedHistogramTimer()
+		{
+			m_Histogram.Record(m_Timer.ElapsedNanos() / 1000);
+		}
+	private:
+		Histogram& m_Histogram;
+		Timer m_Timer;
+	};
+
+	enum class MetricType
+	{
+		Counter = 0,
+		Gauge,
+		Histogram
+	};
+
+	struct MetricSnapshot
+	{
+		std::string Name;
+		MetricType Type = MetricType::Counter;
+		double Value = 0.0; // Counter and gauge value
+		Histogram::Summary Summary;
+	};
+
+	struct MetricsSnapshot
+	{
+		double Time = 0.0; // Seconds since the registry was created
+		std::vector<MetricSnapshot> Metrics;
+	};
+
+	// Metrics are created on first lookup and live until the process exits. Lookups take a lock,
+	// so keep the returned reference around (e.g. in a static) instead of looking up on hot paths.
+	class MetricsRegistry
+	{
+	public:
+		static Counter& GetCounter(const std::string& name);
+		static Gauge& GetGauge(const std::string& name);
+		static Histogram& GetHistogram(const std::string& name);
+
+		// With resetHistograms each snapshot only covers the samples since the previous one
+		static MetricsSnapshot Snapshot(bool resetHistograms = false);
+
+		static bool ExportJSON(const std::string& path, const MetricsSnapshot& snapshot);
+		static bool ExportCSV(const std::string& path, const MetricsSnapshot& snapshot, bool append = false);
+
+		// Appends an interval snapshot to csvPath every intervalSeconds, pass 0 to turn it off
+		static void SetPeriodicSnapshot(float intervalSeconds, const std::string& csvPath = "WalnutMetrics.csv");
+		// Called by Application once per frame
+		static void Update();
+	};
+
+}
@@ -0,0 +1,193 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Walnut {
+
+	// Power of two, per thread. Older events are overwritten if a capture produces more than this.
+	static const uint32_t s_EventsPerThread = 1 << 16;
+
+	struct ProfileEvent
+	{
+		const char* Name;
+		uint64_t Begin;
+		uint64_t End;
+	};
+
+	// Single producer (the owning thread), read by the exporter once the capture has stopped
+	struct ProfileThreadBuffer
+	{
+		std::unique_ptr<ProfileEvent[]> Events = std::make_unique<ProfileEvent[]>(s_EventsPerThread);
+		std::atomic<uint64_t> WriteIndex = 0;
+		uint64_t CaptureStart = 0;
+		uint32_t ThreadID = 0;
+		std::string Name;
+	};
+
+	struct ProfilerData
+	{
+		std::mutex Mutex; // Guards the thread list and capture settings, never taken while writing events
+		std::vector<std::unique_ptr<ProfileThreadBuffer>> Threads;
+
+		uint32_t FramesRemaining = 0;
+		uint64_t CaptureBegin = 0;
+		std::string OutputPath;
+	};
+
+	std::atomic<bool> Profiler::s_Capturing = false;
+
+	static ProfilerData& GetData()
+	{
+		static ProfilerData data;
+		return data;
+	}
+
+	static ProfileThreadBuffer& GetThreadBuffer()
+	{
+		// Buffers are owned by the profiler so that events of threads that have exited can still be exported
+		thread_local ProfileThreadBuffer* buffer = nullptr;
+		if (!buffer)
+		{
+			ProfilerData& data = GetData();
+			std::scoped_lock<std::mutex> lock(data.Mutex);
+			auto& newBuffer = data.Threads.emplace_back(std::make_unique<ProfileThreadBuffer>());
+			newBuffer->ThreadID = (uint32_t)data.Threads.size();
+			newBuffer->Name = "Thread " + std::to_string(newBuffer->ThreadID);
+			buffer = newBuffer.get();
+		}
+		return *buffer;
+	}
+
+	uint64_t Profiler::Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Profiler::WriteScope(const char* name, uint64_t begin, uint64_t end)
+	{
+		ProfileThreadBuffer& buffer = GetThreadBuffer();
+		uint64_t index = buffer.WriteIndex.load(std::memory_order_relaxed);
+		buffer.Events[index & (s_EventsPerThread - 1)] = { name, begin, end };
+		buffer.WriteIndex.store(index + 1, std::memory_order_release);
+	}
+
+	void Profiler::SetThreadName(const char* name)
+	{
+		ProfileThreadBuffer& buffer = GetThreadBuffer();
+		std::scoped_lock<std::mutex> lock(GetData().Mutex);
+		buffer.Name = name;
+	}
+
+	void Profiler::BeginCapture(uint32_t frameCount, const std::string& outputPath)
+	{
+		ProfilerData& data = GetData();
+		{
+			std::scoped_lock<std::mutex> lock(data.Mutex);
+			for (auto& buffer : data.Threads)
+				buffer->CaptureStart = buffer->WriteIndex.load(std::memory_order_acquire);
+
+			data.FramesRemaining = frameCount;
+			data.CaptureBegin = Now();
+			data.OutputPath = outputPath;
+		}
+		s_Capturing.store(true, std::memory_order_release);
+	}
+
+	void Profiler::EndCapture()
+	{
+		if (!s_Capturing.exchange(false))
+			return;
+
+		std::string outputPath;
+		{
+			std::scoped_lock<std::mutex> lock(GetData().Mutex);
+			outputPath = GetData().OutputPath;
+		}
+
+		if (!outputPath.empty() && ExportChromeTrace(outputPath))
+			std::cout << "[PROFILER] Capture written to " << outputPath << "\n";
+	}
+
+	void Profiler::MarkFrame()
+	{
+		if (!IsCapturing())
+			return;
+
+		ProfilerData& data = GetData();
+		bool finished;
+		{
+			std::scoped_lock<std::mutex> lock(data.Mutex);
+			finished = data.FramesRemaining > 0 && --data.FramesRemaining == 0;
+		}
+
+		if (finished)
+			EndCapture();
+	}
+
+	static void WriteJsonString(std::ofstream& stream, const char* str)
+	{
+		stream << '"';
+		for (const char* c = str; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				stream << '\\';
+			stream << *c;
+		}
+		stream << '"';
+	}
+
+	bool Profiler::ExportChromeTrace(const std::string& path)
+	{
+		std::ofstream stream(path);
+		if (!stream)
+		{
+			std::cerr << "[PROFILER] Could not open " << path << "\n";
+			return false;
+		}
+
+		ProfilerData& data = GetData();
+		std::scoped_lock<std::mutex> lock(data.Mutex);
+
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		for (auto& buffer : data.Threads)
+		{
+			if (!first)
+				stream << ',';
+			first = false;
+			stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->ThreadID << ",\"args\":{\"name\":";
+			WriteJsonString(stream, buffer->Name.c_str());
+			stream << "}}";
+
+			uint64_t end = buffer->WriteIndex.load(std::memory_order_acquire);
+			uint64_t begin = buffer->CaptureStart;
+			if (end - begin > s_EventsPerThread)
+				begin = end - s_EventsPerThread;
+
+			for (uint64_t i = begin; i < end; i++)
+			{
+				const ProfileEvent& event = buffer->Events[i & (s_EventsPerThread - 1)];
+				if (event.Begin < data.CaptureBegin)
+					continue;
+
+				// Complete events ("X"): Chrome rebuilds the hierarchy from the nesting of each thread's scopes
+				stream << ",{\"name\":";
+				WriteJsonString(stream, event.Name);
+				stream << ",\"cat\":\"walnut\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->ThreadID
+					<< ",\"ts\":" << (event.Begin - data.CaptureBegin) / 1000.0
+					<< ",\"dur\":" << (event.End - event.Begin) / 1000.0 << '}';
+			}
+		}
+		stream << "]}\n";
+
+		return true;
+	}
+
+}
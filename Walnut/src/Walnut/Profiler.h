@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+// Set WL_PROFILE to 0 to compile all profiling scopes out
+#ifndef WL_PROFILE
+	#define WL_PROFILE 1
+#endif
+
+namespace Walnut {
+
+	// Hierarchical CPU profiler. Scopes are only recorded while a capture is running; otherwise a scope
+	// costs one relaxed atomic load. Every thread writes into its own ring buffer without locking, and
+	// captures are written out as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+	class Profiler
+	{
+	public:
+		// Records the next frameCount frames (or until EndCapture) and writes them to outputPath
+		static void BeginCapture(uint32_t frameCount, const std::string& outputPath = "WalnutTrace.json");
+		static void EndCapture();
+		static bool IsCapturing() { return s_Capturing.load(std::memory_order_relaxed); }
+
+		// Called by Application once per frame
+		static void MarkFrame();
+
+		static bool ExportChromeTrace(const std::string& path);
+		static void SetThreadName(const char* name);
+
+		static uint64_t Now();
+		// Name has to outlive the capture (string literals, __FUNCTION__)
+		static void WriteScope(const char* name, uint64_t begin, uint64_t end);
+	private:
+		static std::atomic<bool> s_Capturing;
+	};
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(const char* name)
+			: m_Name(name), m_Begin(Profiler::IsCapturing() ? Profiler::Now() : 0) {}
+		~ProfileScope()
+		{
+			if (m_Begin)
+				Profiler::WriteScope(m_Name, m_Begin, Profiler::Now());
+		}
+	private:
+		const char* m_Name;
+		uint64_t m_Begin;
+	};
+
+}
+
+#if WL_PROFILE
+	#define WL_PROFILE_CONCAT_IMPL(a, b) a##b
+	#define WL_PROFILE_CONCAT(a, b) WL_PROFILE_CONCAT_IMPL(a, b)
+	#define WL_PROFILE_SCOPE(name) ::Walnut::ProfileScope WL_PROFILE_CONCAT(wlProfileScope, __LINE__)(name)
+	#define WL_PROFILE_FUNCTION() WL_PROFILE_SCOPE(__FUNCTION__)
+#else
+	#define WL_PROFILE_SCOPE(name)
+	#define WL_PROFILE_FUNCTION()
+#endif
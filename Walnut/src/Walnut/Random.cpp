@@ -1,8 +1,241 @@
 #include "Random.h"
 
+#include "Sampling.h"
+
+#include <atomic>
+#include <random>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define WL_RANDOM_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define WL_RANDOM_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#include <arm_neon.h>
+	#define WL_RANDOM_NEON
+#endif
+
 namespace Walnut {
 
-	std::mt19937 Random::s_RandomEngine;
-	std::uniform_int_distribution<std::mt19937::result_type> Random::s_Distribution;
+	// Fill generates 256-bit blocks (four lanes of 64 bits), converted in chunks of this many values
+	static const size_t s_FillChunk = 256;
+
+	static std::atomic<uint64_t> s_Seed = 0x9e3779b97f4a7c15ull;
+	static std::atomic<uint64_t> s_NextStream = 1;
+
+	static uint64_t SplitMix64(uint64_t& x)
+	{
+		uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	void RandomEngine::Seed(uint64_t seed, uint64_t stream)
+	{
+		uint64_t x = seed ^ (stream * 0xd1b54a32d192ed03ull);
+		SplitMix64(x);
+		for (uint64_t& word : m_State)
+			word = SplitMix64(x);
+		m_LanesSeeded = false;
+	}
+
+	// Writes blockCount * 8 values: lane 0 low, lane 0 high, lane 1 low, ...
+	void RandomEngine::FillBlocks(uint32_t* bits, size_t blockCount)
+	{
+		if (!m_LanesSeeded)
+		{
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				uint64_t x = Next();
+				for (uint32_t word = 0; word < 4; word++)
+					m_Lanes[word][lane] = SplitMix64(x);
+			}
+			m_LanesSeeded = true;
+		}
+
+#if defined(WL_RANDOM_AVX2)
+		#define WL_ROTL(x, k) _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - (k)))
+		__m256i s0 = _mm256_load_si256((const __m256i*)m_Lanes[0]);
+		__m256i s1 = _mm256_load_si256((const __m256i*)m_Lanes[1]);
+		__m256i s2 = _mm256_load_si256((const __m256i*)m_Lanes[2]);
+		__m256i s3 = _mm256_load_si256((const __m256i*)m_Lanes[3]);
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			__m256i sum = _mm256_add_epi64(s0, s3);
+			__m256i result = _mm256_add_epi64(WL_ROTL(sum, 23), s0);
+			_mm256_storeu_si256((__m256i*)(bits + i * 8), result);
+
+			__m256i t = _mm256_slli_epi64(s1, 17);
+			s2 = _mm256_xor_si256(s2, s0);
+			s3 = _mm256_xor_si256(s3, s1);
+			s1 = _mm256_xor_si256(s1, s2);
+			s0 = _mm256_xor_si256(s0, s3);
+			s2 = _mm256_xor_si256(s2, t);
+			s3 = WL_ROTL(s3, 45);
+		}
+		_mm256_store_si256((__m256i*)m_Lanes[0], s0);
+		_mm256_store_si256((__m256i*)m_Lanes[1], s1);
+		_mm256_store_si256((__m256i*)m_Lanes[2], s2);
+		_mm256_store_si256((__m256i*)m_Lanes[3], s3);
+		#undef WL_ROTL
+#elif defined(WL_RANDOM_SSE2)
+		#define WL_ROTL(x, k) _mm_or_si128(_mm_slli_epi64(x, k), _mm_srli_epi64(x, 64 - (k)))
+		for (uint32_t half = 0; half < 2; half++)
+		{
+			__m128i s0 = _mm_load_si128((const __m128i*)&m_Lanes[0][half * 2]);
+			__m128i s1 = _mm_load_si128((const __m128i*)&m_Lanes[1][half * 2]);
+			__m128i s2 = _mm_load_si128((const __m128i*)&m_Lanes[2][half * 2]);
+			__m128i s3 = _mm_load_si128((const __m128i*)&m_Lanes[3][half * 2]);
+			for (size_t i = 0; i < blockCount; i++)
+			{
+				__m128i sum = _mm_add_epi64(s0, s3);
+				__m128i result = _mm_add_epi64(WL_ROTL(sum, 23), s0);
+				_mm_storeu_si128((__m128i*)(bits + i * 8 + half * 4), result);
+
+				__m128i t = _mm_slli_epi64(s1, 17);
+				s2 = _mm_xor_si128(s2, s0);
+				s3 = _mm_xor_si128(s3, s1);
+				s1 = _mm_xor_si128(s1, s2);
+				s0 = _mm_xor_si128(s0, s3);
+				s2 = _mm_xor_si128(s2, t);
+				s3 = WL_ROTL(s3, 45);
+			}
+			_mm_store_si128((__m128i*)&m_Lanes[0][half * 2], s0);
+			_mm_store_si128((__m128i*)&m_Lanes[1][half * 2], s1);
+			_mm_store_si128((__m128i*)&m_Lanes[2][half * 2], s2);
+			_mm_store_si128((__m128i*)&m_Lanes[3][half * 2], s3);
+		}
+		#undef WL_ROTL
+#elif defined(WL_RANDOM_NEON)
+		#define WL_ROTL(x, k) vorrq_u64(vshlq_n_u64(x, k), vshrq_n_u64(x, 64 - (k)))
+		for (uint32_t half = 0; half < 2; half++)
+		{
+			uint64x2_t s0 = vld1q_u64(&m_Lanes[0][half * 2]);
+			uint64x2_t s1 = vld1q_u64(&m_Lanes[1][half * 2]);
+			uint64x2_t s2 = vld1q_u64(&m_Lanes[2][half * 2]);
+			uint64x2_t s3 = vld1q_u64(&m_Lanes[3][half * 2]);
+			for (size_t i = 0; i < blockCount; i++)
+			{
+				uint64x2_t sum = vaddq_u64(s0, s3);
+				uint64x2_t result = vaddq_u64(WL_ROTL(sum, 23), s0);
+				vst1q_u32(bits + i * 8 + half * 4, vreinterpretq_u32_u64(result));
+
+				uint64x2_t t = vshlq_n_u64(s1, 17);
+				s2 = veorq_u64(s2, s0);
+				s3 = veorq_u64(s3, s1);
+				s1 = veorq_u64(s1, s2);
+				s0 = veorq_u64(s0, s3);
+				s2 = veorq_u64(s2, t);
+				s3 = WL_ROTL(s3, 45);
+			}
+			vst1q_u64(&m_Lanes[0][half * 2], s0);
+			vst1q_u64(&m_Lanes[1][half * 2], s1);
+			vst1q_u64(&m_Lanes[2][half * 2], s2);
+			vst1q_u64(&m_Lanes[3][half * 2], s3);
+		}
+		#undef WL_ROTL
+#else
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				uint64_t s0 = m_Lanes[0][lane], s1 = m_Lanes[1][lane], s2 = m_Lanes[2][lane], s3 = m_Lanes[3][lane];
+				uint64_t result = Rotl(s0 + s3, 23) + s0;
+				bits[i * 8 + lane * 2] = (uint32_t)result;
+				bits[i * 8 + lane * 2 + 1] = (uint32_t)(result >> 32);
+
+				uint64_t t = s1 << 17;
+				s2 ^= s0;
+				s3 ^= s1;
+				s1 ^= s2;
+				s0 ^= s3;
+				s2 ^= t;
+				s3 = Rotl(s3, 45);
+				m_Lanes[0][lane] = s0;
+				m_Lanes[1][lane] = s1;
+				m_Lanes[2][lane] = s2;
+				m_Lanes[3][lane] = s3;
+			}
+		}
+#endif
+	}
+
+	void RandomEngine::Fill(uint32_t* values, size_t count)
+	{
+		size_t blocks = count / 8;
+		FillBlocks(values, blocks);
+
+		size_t remaining = count - blocks * 8;
+		if (remaining)
+		{
+			uint32_t tail[8];
+			FillBlocks(tail, 1);
+			for (size_t i = 0; i < remaining; i++)
+				values[blocks * 8 + i] = tail[i];
+		}
+	}
+
+	void RandomEngine::Fill(float* values, size_t count)
+	{
+		Fill(values, count, 0.0f, 1.0f);
+	}
+
+	void RandomEngine::Fill(float* values, size_t count, float min, float max)
+	{
+		// Top 24 bits of every 32-bit half, the same [0, 1) mapping as Float()
+		const float scale = (max - min) * (1.0f / 16777216.0f);
+
+		alignas(32) uint32_t bits[s_FillChunk];
+		for (size_t offset = 0; offset < count; offset += s_FillChunk)
+		{
+			size_t chunk = count - offset < s_FillChunk ? count - offset : s_FillChunk;
+			FillBlocks(bits, (chunk + 7) / 8);
+
+			// Plain loop so that the compiler vectorizes the conversion for whatever target it builds for
+			float* out = values + offset;
+			for (size_t i = 0; i < chunk; i++)
+				out[i] = (float)(int32_t)(bits[i] >> 8) * scale + min;
+		}
+	}
+
+	void Random::Init()
+	{
+		std::random_device device;
+		Init(((uint64_t)device() << 32) | device());
+	}
+
+	void Random::Init(uint64_t seed)
+	{
+		s_Seed.store(seed);
+		s_NextStream.store(1);
+		GetThreadEngine().Seed(seed, 0);
+	}
+
+	uint64_t Random::GetSeed()
+	{
+		return s_Seed.load();
+	}
+
+	void Random::SetThreadStream(uint64_t stream)
+	{
+		GetThreadEngine().Seed(s_Seed.load(), stream);
+	}
+
+	glm::vec3 Random::InUnitSphere()
+	{
+		return Sampling::UniformBall(Vec3());
+	}
+
+	glm::vec3 Random::OnUnitSphere()
+	{
+		return Sampling::UniformSphere(glm::vec2(Float(), Float()));
+	}
+
+	RandomEngine Random::CreateThreadEngine()
+	{
+		return RandomEngine(s_Seed.load(), s_NextStream.fetch_add(1));
+	}
 
-}
\ No newline at end of file
+}
@@ -1,32 +1,118 @@
 #pragma once
 
-#include <random>
+#include <stdint.h>
+#include <stddef.h>
 
 #include <glm/glm.hpp>
 
 namespace Walnut {
 
+	// xoshiro256++. Cheap to copy, so give every thread or tile its own engine:
+	// RandomEngine(seed, stream) is deterministic and streams are statistically independent.
+	class RandomEngine
+	{
+	public:
+		RandomEngine(uint64_t seed = 0, uint64_t stream = 0) { Seed(seed, stream); }
+
+		void Seed(uint64_t seed, uint64_t stream = 0);
+
+		uint64_t Next()
+		{
+			uint64_t result = Rotl(m_State[0] + m_State[3], 23) + m_State[0];
+			uint64_t t = m_State[1] << 17;
+			m_State[2] ^= m_State[0];
+			m_State[3] ^= m_State[1];
+			m_State[1] ^= m_State[2];
+			m_State[0] ^= m_State[3];
+			m_State[2] ^= t;
+			m_State[3] = Rotl(m_State[3], 45);
+			return result;
+		}
+
+		uint32_t UInt() { return (uint32_t)(Next() >> 32); }
+
+		// Unbiased integer in [min, max] (Lemire's multiply-shift with rejection)
+		uint32_t UInt(uint32_t min, uint32_t max)
+		{
+			uint32_t range = max - min + 1;
+			if (range == 0)
+				return UInt();
+
+			uint64_t m = (uint64_t)UInt() * range;
+			uint32_t low = (uint32_t)m;
+			if (low < range)
+			{
+				uint32_t threshold = (0u - range) % range;
+				while (low < threshold)
+				{
+					m = (uint64_t)UInt() * range;
+					low = (uint32_t)m;
+				}
+			}
+			return min + (uint32_t)(m >> 32);
+		}
+
+		// [0, 1)
+		float Float() { return (float)(Next() >> 40) * (1.0f / 16777216.0f); }
+
+		// Bulk generation, SIMD where available (SSE2, AVX2, NEON). Uses four lanes seeded from this engine
+		// on first use, so the output only depends on the seed, not on the instruction set.
+		void Fill(float* values, size_t count);
+		void Fill(float* values, size_t count, float min, float max);
+		void Fill(uint32_t* values, size_t count);
+	private:
+		static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+		void FillBlocks(uint32_t* bits, size_t blockCount);
+	private:
+		uint64_t m_State[4];
+
+		// Lanes for Fill, stored word-major: m_Lanes[word][lane]
+		alignas(32) uint64_t m_Lanes[4][4];
+		bool m_LanesSeeded = false;
+	};
+
+	// One engine per thread, no locking. A thread's stream is the order in which it first used Random
+	// (the thread calling Init is stream 0), or whatever it passed to SetThreadStream. Call Init before
+	// other threads use Random, engines that already exist are not reseeded.
 	class Random
 	{
 	public:
-		static void Init()
+		static void Init();
+		static void Init(uint64_t seed);
+		static uint64_t GetSeed();
+
+		// Reseeds the calling thread's engine, e.g. with a tile or worker index
+		static void SetThreadStream(uint64_t stream);
+
+		static RandomEngine& GetThreadEngine()
 		{
-			s_RandomEngine.seed(std::random_device()());
+			thread_local RandomEngine engine = CreateThreadEngine();
+			return engine;
 		}
 
 		static uint32_t UInt()
 		{
-			return s_Distribution(s_RandomEngine);
+			return GetThreadEngine().UInt();
 		}
 
 		static uint32_t UInt(uint32_t min, uint32_t max)
 		{
-			return min + (s_Distribution(s_RandomEngine) % (max - min + 1));
+			return GetThreadEngine().UInt(min, max);
 		}
 
 		static float Float()
 		{
-			return (float)s_Distribution(s_RandomEngine) / (float)std::numeric_limits<uint32_t>::max();
+			return GetThreadEngine().Float();
+		}
+
+		static void Fill(float* values, size_t count)
+		{
+			GetThreadEngine().Fill(values, count);
+		}
+
+		static void Fill(float* values, size_t count, float min, float max)
+		{
+			GetThreadEngine().Fill(values, count, min, max);
 		}
 
 		static glm::vec3 Vec3()
@@ -39,15 +125,12 @@ namespace Walnut {
 			return glm::vec3(Float() * (max - min) + min, Float() * (max - min) + min, Float() * (max - min) + min);
 		}
 
-		static glm::vec3 InUnitSphere()
-		{
-			return glm::normalize(Vec3(-1.0f, 1.0f));
-		}
+		// Uniform inside the unit ball
+		static glm::vec3 InUnitSphere();
+		// Uniform direction, i.e. on the unit sphere
+		static glm::vec3 OnUnitSphere();
 	private:
-		static std::mt19937 s_RandomEngine;
-		static std::uniform_int_distribution<std::mt19937::result_type> s_Distribution;
+		static RandomEngine CreateThreadEngine();
 	};
 
 }
-
-
@@ -0,0 +1,600 @@
+#include "Sampling.h"
+
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define WL_SAMPLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define WL_SAMPLING_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#include <arm_neon.h>
+	#define WL_SAMPLING_NEON
+#endif
+
+namespace Walnut {
+
+	// Batch warps work on SoA chunks of this many samples
+	static const size_t s_BatchChunk = 256;
+
+	static const float s_OneMinusEpsilon = 0x1.fffffep-1f;
+	static const float s_Pi = 3.14159265358979323846f;
+
+	namespace Utils {
+
+		// Minimal SIMD layer for the batch warps, one lane per sample
+#if defined(WL_SAMPLING_AVX)
+		using FloatV = __m256;
+		using MaskV = __m256;
+		static const size_t s_Width = 8;
+
+		static FloatV Splat(float value) { return _mm256_set1_ps(value); }
+		static FloatV Load(const float* p) { return _mm256_load_ps(p); }
+		static void Store(float* p, FloatV v) { _mm256_store_ps(p, v); }
+		static FloatV Add(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+		static FloatV Sub(FloatV a, FloatV b) { return _mm256_sub_ps(a, b); }
+		static FloatV Mul(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+		static FloatV Div(FloatV a, FloatV b) { return _mm256_div_ps(a, b); }
+		static FloatV Sqrt(FloatV a) { return _mm256_sqrt_ps(a); }
+		static FloatV Max(FloatV a, FloatV b) { return _mm256_max_ps(a, b); }
+		static FloatV Abs(FloatV a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		static FloatV Negate(FloatV a) { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a); }
+		static MaskV Less(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static FloatV Select(MaskV mask, FloatV a, FloatV b) { return _mm256_blendv_ps(b, a, mask); }
+#elif defined(WL_SAMPLING_SSE2)
+		using FloatV = __m128;
+		using MaskV = __m128;
+		static const size_t s_Width = 4;
+
+		static FloatV Splat(float value) { return _mm_set1_ps(value); }
+		static FloatV Load(const float* p) { return _mm_load_ps(p); }
+		static void Store(float* p, FloatV v) { _mm_store_ps(p, v); }
+		static FloatV Add(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+		static FloatV Sub(FloatV a, FloatV b) { return _mm_sub_ps(a, b); }
+		static FloatV Mul(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+		static FloatV Div(FloatV a, FloatV b) { return _mm_div_ps(a, b); }
+		static FloatV Sqrt(FloatV a) { return _mm_sqrt_ps(a); }
+		static FloatV Max(FloatV a, FloatV b) { return _mm_max_ps(a, b); }
+		static FloatV Abs(FloatV a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		static FloatV Negate(FloatV a) { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+		static MaskV Less(FloatV a, FloatV b) { return _mm_cmplt_ps(a, b); }
+		static FloatV Select(MaskV mask, FloatV a, FloatV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#elif defined(WL_SAMPLING_NEON)
+		using FloatV = float32x4_t;
+		using MaskV = uint32x4_t;
+		static const size_t s_Width = 4;
+
+		static FloatV Splat(float value) { return vdupq_n_f32(value); }
+		static FloatV Load(const float* p) { return vld1q_f32(p); }
+		static void Store(float* p, FloatV v) { vst1q_f32(p, v); }
+		static FloatV Add(FloatV a, FloatV b) { return vaddq_f32(a, b); }
+		static FloatV Sub(FloatV a, FloatV b) { return vsubq_f32(a, b); }
+		static FloatV Mul(FloatV a, FloatV b) { return vmulq_f32(a, b); }
+		static FloatV Div(FloatV a, FloatV b) { return vdivq_f32(a, b); }
+		static FloatV Sqrt(FloatV a) { return vsqrtq_f32(a); }
+		static FloatV Max(FloatV a, FloatV b) { return vmaxq_f32(a, b); }
+		static FloatV Abs(FloatV a) { return vabsq_f32(a); }
+		static FloatV Negate(FloatV a) { return vnegq_f32(a); }
+		static MaskV Less(FloatV a, FloatV b) { return vcltq_f32(a, b); }
+		static FloatV Select(MaskV mask, FloatV a, FloatV b) { return vbslq_f32(mask, a, b); }
+#else
+		using FloatV = float;
+		using MaskV = bool;
+		static const size_t s_Width = 1;
+
+		static FloatV Splat(float value) { return value; }
+		static FloatV Load(const float* p) { return *p; }
+		static void Store(float* p, FloatV v) { *p = v; }
+		static FloatV Add(FloatV a, FloatV b) { return a + b; }
+		static FloatV Sub(FloatV a, FloatV b) { return a - b; }
+		static FloatV Mul(FloatV a, FloatV b) { return a * b; }
+		static FloatV Div(FloatV a, FloatV b) { return a / b; }
+		static FloatV Sqrt(FloatV a) { return std::sqrt(a); }
+		static FloatV Max(FloatV a, FloatV b) { return a > b ? a : b; }
+		static FloatV Abs(FloatV a) { return std::fabs(a); }
+		static FloatV Negate(FloatV a) { return -a; }
+		static MaskV Less(FloatV a, FloatV b) { return a < b; }
+		static FloatV Select(MaskV mask, FloatV a, FloatV b) { return mask ? a : b; }
+#endif
+
+		// Taylor polynomials, accurate to ~1e-7 for |x| <= pi / 2
+		static void SinCosPoly(FloatV x, FloatV& sin, FloatV& cos)
+		{
+			FloatV x2 = Mul(x, x);
+			FloatV s = Splat(-1.0f / 39916800.0f);
+			s = Add(Mul(s, x2), Splat(1.0f / 362880.0f));
+			s = Add(Mul(s, x2), Splat(-1.0f / 5040.0f));
+			s = Add(Mul(s, x2), Splat(1.0f / 120.0f));
+			s = Add(Mul(s, x2), Splat(-1.0f / 6.0f));
+			s = Add(Mul(s, x2), Splat(1.0f));
+			sin = Mul(s, x);
+
+			FloatV c = Splat(1.0f / 479001600.0f);
+			c = Add(Mul(c, x2), Splat(-1.0f / 3628800.0f));
+			c = Add(Mul(c, x2), Splat(1.0f / 40320.0f));
+			c = Add(Mul(c, x2), Splat(-1.0f / 720.0f));
+			c = Add(Mul(c, x2), Splat(1.0f / 24.0f));
+			c = Add(Mul(c, x2), Splat(-0.5f));
+			cos = Add(Mul(c, x2), Splat(1.0f));
+		}
+
+		// sin and cos of 2 * pi * u for u in [0, 1), folded into the first quadrant
+		static void SinCos2Pi(FloatV u, FloatV& sin, FloatV& cos)
+		{
+			FloatV t = Select(Less(Splat(0.5f), u), Sub(u, Splat(1.0f)), u); // (-0.5, 0.5]
+			FloatV a = Abs(t);
+			MaskV flip = Less(Splat(0.25f), a);
+			a = Select(flip, Sub(Splat(0.5f), a), a);
+
+			SinCosPoly(Mul(a, Splat(2.0f * s_Pi)), sin, cos);
+			sin = Select(Less(t, Splat(0.0f)), Negate(sin), sin);
+			cos = Select(flip, Negate(cos), cos);
+		}
+
+		static void ConcentricDisk(FloatV u0, FloatV u1, FloatV& x, FloatV& y)
+		{
+			FloatV a = Sub(Mul(u0, Splat(2.0f)), Splat(1.0f));
+			FloatV b = Sub(Mul(u1, Splat(2.0f)), Splat(1.0f));
+			MaskV useA = Less(Abs(b), Abs(a));
+
+			FloatV r = Select(useA, a, b);
+			FloatV other = Select(useA, b, a);
+			FloatV safeR = Select(Less(Splat(0.0f), Abs(r)), r, Splat(1.0f));
+
+			FloatV sin, cos;
+			SinCosPoly(Mul(Div(other, safeR), Splat(0.25f * s_Pi)), sin, cos);
+			x = Mul(r, Select(useA, cos, sin));
+			y = Mul(r, Select(useA, sin, cos));
+		}
+
+		static void UniformSphereKernel(const float* u0, const float* u1, float* x, float* y, float* z)
+		{
+			FloatV cz = Sub(Splat(1.0f), Mul(Load(u0), Splat(2.0f)));
+			FloatV r = Sqrt(Max(Splat(0.0f), Sub(Splat(1.0f), Mul(cz, cz))));
+			FloatV sin, cos;
+			SinCos2Pi(Load(u1), sin, cos);
+			Store(x, Mul(r, cos));
+			Store(y, Mul(r, sin));
+			Store(z, cz);
+		}
+
+		static void UniformHemisphereKernel(const float* u0, const float* u1, float* x, float* y, float* z)
+		{
+			FloatV cz = Load(u0);
+			FloatV r = Sqrt(Max(Splat(0.0f), Sub(Splat(1.0f), Mul(cz, cz))));
+			FloatV sin, cos;
+			SinCos2Pi(Load(u1), sin, cos);
+			Store(x, Mul(r, cos));
+			Store(y, Mul(r, sin));
+			Store(z, cz);
+		}
+
+		// Malley's method: project a uniform disk sample up onto the hemisphere
+		static void CosineHemisphereKernel(const float* u0, const float* u1, float* x, float* y, float* z)
+		{
+			FloatV dx, dy;
+			ConcentricDisk(Load(u0), Load(u1), dx, dy);
+			Store(x, dx);
+			Store(y, dy);
+			Store(z, Sqrt(Max(Splat(0.0f), Sub(Splat(1.0f), Add(Mul(dx, dx), Mul(dy, dy))))));
+		}
+
+		static void UniformDiskKernel(const float* u0, const float* u1, float* x, float* y, float*)
+		{
+			FloatV dx, dy;
+			ConcentricDisk(Load(u0), Load(u1), dx, dy);
+			Store(x, dx);
+			Store(y, dy);
+		}
+
+		static void UniformTriangleKernel(const float* u0, const float* u1, float* x, float* y, float* z)
+		{
+			FloatV su = Sqrt(Load(u0));
+			FloatV b0 = Sub(Splat(1.0f), su);
+			FloatV b1 = Mul(Load(u1), su);
+			Store(x, b0);
+			Store(y, b1);
+			Store(z, Sub(Sub(Splat(1.0f), b0), b1));
+		}
+
+		using BatchKernel = void(*)(const float* u0, const float* u1, float* x, float* y, float* z);
+
+		// Deinterleaves u into SoA chunks, runs the kernel a SIMD width at a time and interleaves
+		// the first Components outputs back into out
+		template<uint32_t Components>
+		static void RunBatch(BatchKernel kernel, const glm::vec2* u, float* out, size_t count)
+		{
+			alignas(32) float u0[s_BatchChunk], u1[s_BatchChunk];
+			alignas(32) float x[s_BatchChunk], y[s_BatchChunk], z[s_BatchChunk];
+
+			for (size_t offset = 0; offset < count; offset += s_BatchChunk)
+			{
+				size_t chunk = std::min(count - offset, s_BatchChunk);
+				size_t padded = (chunk + s_Width - 1) / s_Width * s_Width;
+				for (size_t i = 0; i < chunk; i++)
+				{
+					u0[i] = u[offset + i].x;
+					u1[i] = u[offset + i].y;
+				}
+				for (size_t i = chunk; i < padded; i++)
+					u0[i] = u1[i] = 0.0f;
+
+				for (size_t i = 0; i < padded; i += s_Width)
+					kernel(u0 + i, u1 + i, x + i, y + i, z + i);
+
+				float* dst = out + offset * Components;
+				for (size_t i = 0; i < chunk; i++)
+				{
+					dst[i * Components + 0] = x[i];
+					dst[i * Components + 1] = y[i];
+					if constexpr (Components == 3)
+						dst[i * Components + 2] = z[i];
+				}
+			}
+		}
+
+		template<uint32_t Components, typename T>
+		static void RunBatch(BatchKernel kernel, RandomEngine& engine, T* out, size_t count)
+		{
+			glm::vec2 u[s_BatchChunk];
+			for (size_t offset = 0; offset < count; offset += s_BatchChunk)
+			{
+				size_t chunk = std::min(count - offset, s_BatchChunk);
+				engine.Fill(&u[0].x, chunk * 2);
+				RunBatch<Components>(kernel, u, &out[offset].x, chunk);
+			}
+		}
+
+		// lowbias32 by Chris Wellons
+		static uint32_t Hash(uint32_t x)
+		{
+			x ^= x >> 16;
+			x *= 0x7feb352du;
+			x ^= x >> 15;
+			x *= 0x846ca68bu;
+			x ^= x >> 16;
+			return x;
+		}
+
+		static uint32_t HashCombine(uint32_t seed, uint32_t value)
+		{
+			return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+		}
+
+		static uint32_t ReverseBits(uint32_t x)
+		{
+			x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+			x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+			x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+			x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+			return (x >> 16) | (x << 16);
+		}
+
+		// Hash-based Owen scrambling of the bits of x (Burley 2020, "Practical Hash-based Owen Scrambling"):
+		// every bit is flipped depending on a hash of the bits above it
+		static uint32_t NestedUniformScramble(uint32_t x, uint32_t seed)
+		{
+			x = ReverseBits(x);
+			x ^= x * 0x3d20adeau;
+			x += seed;
+			x *= (seed >> 16) | 1u;
+			x ^= x * 0x05526c56u;
+			x ^= x * 0x53a22864u;
+			return ReverseBits(x);
+		}
+
+		static float BitsToFloat(uint32_t bits)
+		{
+			return (float)(bits >> 8) * (1.0f / 16777216.0f);
+		}
+
+		static uint32_t Part1By1(uint32_t x)
+		{
+			x &= 0x0000ffffu;
+			x = (x | (x << 8)) & 0x00ff00ffu;
+			x = (x | (x << 4)) & 0x0f0f0f0fu;
+			x = (x | (x << 2)) & 0x33333333u;
+			x = (x | (x << 1)) & 0x55555555u;
+			return x;
+		}
+
+	}
+
+	glm::vec3 Sampling::UniformSphere(const glm::vec2& u)
+	{
+		float z = 1.0f - 2.0f * u.x;
+		float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+		float phi = 2.0f * s_Pi * u.y;
+		return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+	}
+
+	glm::vec3 Sampling::UniformHemisphere(const glm::vec2& u)
+	{
+		float z = u.x;
+		float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+		float phi = 2.0f * s_Pi * u.y;
+		return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+	}
+
+	glm::vec3 Sampling::CosineHemisphere(const glm::vec2& u)
+	{
+		glm::vec2 d = UniformDisk(u);
+		return glm::vec3(d.x, d.y, std::sqrt(std::max(0.0f, 1.0f - d.x * d.x - d.y * d.y)));
+	}
+
+	glm::vec3 Sampling::UniformBall(const glm::vec3& u)
+	{
+		return UniformSphere(glm::vec2(u.x, u.y)) * std::cbrt(u.z);
+	}
+
+	glm::vec2 Sampling::UniformDisk(const glm::vec2& u)
+	{
+		float a = 2.0f * u.x - 1.0f;
+		float b = 2.0f * u.y - 1.0f;
+		if (a == 0.0f && b == 0.0f)
+			return glm::vec2(0.0f, 0.0f);
+
+		if (std::fabs(a) > std::fabs(b))
+		{
+			float theta = 0.25f * s_Pi * (b / a);
+			return glm::vec2(a * std::cos(theta), a * std::sin(theta));
+		}
+
+		float theta = 0.25f * s_Pi * (a / b);
+		return glm::vec2(b * std::sin(theta), b * std::cos(theta));
+	}
+
+	glm::vec3 Sampling::UniformTriangle(const glm::vec2& u)
+	{
+		float su = std::sqrt(u.x);
+		float b0 = 1.0f - su;
+		float b1 = u.y * su;
+		return glm::vec3(b0, b1, 1.0f - b0 - b1);
+	}
+
+	glm::vec3 Sampling::UniformTriangle(const glm::vec2& u, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		glm::vec3 barycentric = UniformTriangle(u);
+		return a * barycentric.x + b * barycentric.y + c * barycentric.z;
+	}
+
+	// Duff et al. 2017, "Building an Orthonormal Basis, Revisited"
+	glm::vec3 Sampling::ToWorld(const glm::vec3& local, const glm::vec3& normal)
+	{
+		float sign = std::copysign(1.0f, normal.z);
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+		glm::vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+		return tangent * local.x + bitangent * local.y + normal * local.z;
+	}
+
+	void Sampling::UniformSphere(const glm::vec2* u, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::UniformSphereKernel, u, &out->x, count);
+	}
+
+	void Sampling::UniformHemisphere(const glm::vec2* u, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::UniformHemisphereKernel, u, &out->x, count);
+	}
+
+	void Sampling::CosineHemisphere(const glm::vec2* u, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::CosineHemisphereKernel, u, &out->x, count);
+	}
+
+	void Sampling::UniformDisk(const glm::vec2* u, glm::vec2* out, size_t count)
+	{
+		Utils::RunBatch<2>(Utils::UniformDiskKernel, u, &out->x, count);
+	}
+
+	void Sampling::UniformTriangle(const glm::vec2* u, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::UniformTriangleKernel, u, &out->x, count);
+	}
+
+	void Sampling::UniformSphere(RandomEngine& engine, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::UniformSphereKernel, engine, out, count);
+	}
+
+	void Sampling::UniformHemisphere(RandomEngine& engine, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::UniformHemisphereKernel, engine, out, count);
+	}
+
+	void Sampling::CosineHemisphere(RandomEngine& engine, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::CosineHemisphereKernel, engine, out, count);
+	}
+
+	void Sampling::UniformDisk(RandomEngine& engine, glm::vec2* out, size_t count)
+	{
+		Utils::RunBatch<2>(Utils::UniformDiskKernel, engine, out, count);
+	}
+
+	void Sampling::UniformTriangle(RandomEngine& engine, glm::vec3* out, size_t count)
+	{
+		Utils::RunBatch<3>(Utils::UniformTriangleKernel, engine, out, count);
+	}
+
+	static const uint32_t s_Primes[Sampling::HaltonMaxDimensions] =
+	{
+		2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+		59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+	};
+
+	float Sampling::Halton(uint32_t index, uint32_t dimension)
+	{
+		uint32_t base = s_Primes[dimension % HaltonMaxDimensions];
+		float invBase = 1.0f / (float)base;
+		float invBaseN = 1.0f;
+		uint64_t reversed = 0;
+		while (index)
+		{
+			uint32_t next = index / base;
+			reversed = reversed * base + (index - next * base);
+			invBaseN *= invBase;
+			index = next;
+		}
+		return std::min((float)reversed * invBaseN, s_OneMinusEpsilon);
+	}
+
+	// Every digit gets a random shift that depends on the digits before it. Digits keep being
+	// generated past the end of the index (where they would be 0) until double precision runs out,
+	// which still covers every digit of a 32-bit index in the largest base (8 digits for 131).
+	float Sampling::Halton(uint32_t index, uint32_t dimension, uint32_t seed)
+	{
+		uint32_t base = s_Primes[dimension % HaltonMaxDimensions];
+		uint32_t hash = Utils::Hash(Utils::HashCombine(seed, dimension));
+		double invBase = 1.0 / (double)base;
+		double invBaseN = 1.0;
+		uint64_t reversed = 0;
+		for (uint32_t digitIndex = 0; 1.0 - invBaseN < 1.0; digitIndex++)
+		{
+			uint32_t next = index / base;
+			uint32_t digit = index - next * base;
+			digit = (digit + Utils::Hash(Utils::HashCombine(hash ^ digitIndex, (uint32_t)reversed)) % base) % base;
+			reversed = reversed * base + digit;
+			invBaseN *= invBase;
+			index = next;
+		}
+		return std::min((float)((double)reversed * invBaseN), s_OneMinusEpsilon);
+	}
+
+	// Joe and Kuo's direction numbers (new-joe-kuo-6.21201) for dimensions 1 and up,
+	// dimension 0 is the van der Corput sequence
+	struct SobolPolynomial
+	{
+		uint32_t Degree;
+		uint32_t Coefficients;
+		uint32_t M[6];
+	};
+
+	static const SobolPolynomial s_SobolPolynomials[Sampling::SobolMaxDimensions - 1] =
+	{
+		{ 1, 0,  { 1 } },
+		{ 2, 1,  { 1, 3 } },
+		{ 3, 1,  { 1, 3, 1 } },
+		{ 3, 2,  { 1, 1, 1 } },
+		{ 4, 1,  { 1, 1, 3, 3 } },
+		{ 4, 4,  { 1, 3, 5, 13 } },
+		{ 5, 2,  { 1, 1, 5, 5, 17 } },
+		{ 5, 4,  { 1, 1, 5, 5, 5 } },
+		{ 5, 7,  { 1, 1, 7, 11, 19 } },
+		{ 5, 11, { 1, 1, 5, 1, 1 } },
+		{ 5, 13, { 1, 1, 1, 3, 11 } },
+		{ 5, 14, { 1, 3, 5, 5, 31 } },
+		{ 6, 1,  { 1, 3, 3, 9, 7, 49 } },
+		{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+		{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+	};
+
+	struct SobolMatrices
+	{
+		uint32_t Directions[Sampling::SobolMaxDimensions][32];
+
+		SobolMatrices()
+		{
+			for (uint32_t bit = 0; bit < 32; bit++)
+				Directions[0][bit] = 1u << (31 - bit);
+
+			for (uint32_t dimension = 1; dimension < Sampling::SobolMaxDimensions; dimension++)
+			{
+				const SobolPolynomial& polynomial = s_SobolPolynomials[dimension - 1];
+				uint32_t* v = Directions[dimension];
+				uint32_t s = polynomial.Degree;
+				for (uint32_t bit = 0; bit < 32; bit++)
+				{
+					if (bit < s)
+					{
+						v[bit] = polynomial.M[bit] << (31 - bit);
+						continue;
+					}
+
+					v[bit] = v[bit - s] ^ (v[bit - s] >> s);
+					for (uint32_t k = 1; k < s; k++)
+					{
+						if ((polynomial.Coefficients >> (s - 1 - k)) & 1)
+							v[bit] ^= v[bit - k];
+					}
+				}
+			}
+		}
+	};
+
+	static uint32_t SobolBits(uint32_t index, uint32_t dimension)
+	{
+		static const SobolMatrices s_Matrices;
+		dimension %= Sampling::SobolMaxDimensions;
+		if (dimension == 0)
+			return Utils::ReverseBits(index);
+
+		// Branchless so that scrambled (i.e. random looking) indices don't mispredict, and it vectorizes
+		const uint32_t* v = s_Matrices.Directions[dimension];
+		uint32_t result = 0;
+		for (uint32_t bit = 0; bit < 32; bit++)
+			result ^= v[bit] & (0u - ((index >> bit) & 1u));
+		return result;
+	}
+
+	float Sampling::Sobol(uint32_t index, uint32_t dimension)
+	{
+		return Utils::BitsToFloat(SobolBits(index, dimension));
+	}
+
+	float Sampling::Sobol(uint32_t index, uint32_t dimension, uint32_t seed)
+	{
+		uint32_t hash = Utils::Hash(Utils::HashCombine(seed, dimension));
+		return Utils::BitsToFloat(Utils::NestedUniformScramble(SobolBits(index, dimension), hash));
+	}
+
+	glm::vec2 Sampling::Sobol2D(uint32_t index, uint32_t dimensionPair, uint32_t seed)
+	{
+		uint32_t hash = Utils::Hash(Utils::HashCombine(seed, dimensionPair));
+		index = Utils::NestedUniformScramble(index, hash);
+		return glm::vec2(
+			Utils::BitsToFloat(Utils::NestedUniformScramble(SobolBits(index, 0), Utils::HashCombine(hash, 0))),
+			Utils::BitsToFloat(Utils::NestedUniformScramble(SobolBits(index, 1), Utils::HashCombine(hash, 1))));
+	}
+
+	void Sampling::Sobol2D(uint32_t firstIndex, uint32_t dimensionPair, uint32_t seed, glm::vec2* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			out[i] = Sobol2D(firstIndex + (uint32_t)i, dimensionPair, seed);
+	}
+
+	glm::vec2 Sampling::BlueNoise2D(uint32_t x, uint32_t y, uint32_t sampleIndex, uint32_t samplesPerPixel,
+		uint32_t dimensionPair, uint32_t seed)
+	{
+		uint32_t hash = Utils::Hash(Utils::HashCombine(seed, dimensionPair));
+
+		// Owen scramble the Morton index in base 4: each 2x2 quad keeps a contiguous, stratified run
+		// of the sequence, but which pixel of the quad gets which part is randomized per level
+		uint32_t morton = Utils::Part1By1(x) | (Utils::Part1By1(y) << 1);
+		uint32_t scrambled = 0;
+		for (int32_t level = 15; level >= 0; level--)
+		{
+			uint32_t shift = (uint32_t)level * 2;
+			uint32_t prefix = (uint32_t)((uint64_t)morton >> (shift + 2));
+			uint32_t digit = (morton >> shift) & 3;
+			digit ^= Utils::Hash(Utils::HashCombine(hash ^ (uint32_t)level, prefix)) & 3;
+			scrambled |= digit << shift;
+		}
+
+		// Large images at high sample counts go past the 2^32 points of the sequence. Each further run of
+		// 2^32 gets its own scramble instead of wrapping around onto the pixels at the start.
+		uint64_t index = (uint64_t)scrambled * samplesPerPixel + sampleIndex;
+		if (index >> 32)
+			hash = Utils::Hash(Utils::HashCombine(hash, (uint32_t)(index >> 32)));
+		return glm::vec2(
+			Utils::BitsToFloat(Utils::NestedUniformScramble(SobolBits((uint32_t)index, 0), Utils::HashCombine(hash, 0))),
+			Utils::BitsToFloat(Utils::NestedUniformScramble(SobolBits((uint32_t)index, 1), Utils::HashCombine(hash, 1))));
+	}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <glm/glm.hpp>
+
+namespace Walnut {
+
+	class RandomEngine;
+
+	// Warps uniform points in [0, 1)^2 onto common domains. Directions are in a local frame around +Z,
+	// rotate them onto a surface normal with ToWorld. Feed them with Random or with the low-discrepancy
+	// sequences below, the warps preserve stratification so sequences keep their faster convergence.
+	class Sampling
+	{
+	public:
+		static glm::vec3 UniformSphere(const glm::vec2& u);
+		static glm::vec3 UniformHemisphere(const glm::vec2& u);
+		static glm::vec3 CosineHemisphere(const glm::vec2& u);
+		// Uniform inside the unit ball
+		static glm::vec3 UniformBall(const glm::vec3& u);
+		// Concentric (Shirley-Chiu) mapping onto the unit disk
+		static glm::vec2 UniformDisk(const glm::vec2& u);
+		// Barycentric coordinates of a uniform point on a triangle
+		static glm::vec3 UniformTriangle(const glm::vec2& u);
+		static glm::vec3 UniformTriangle(const glm::vec2& u, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+		static constexpr float InvPi = 0.318309886183790671f;
+
+		static float UniformSpherePDF() { return 0.25f * InvPi; }
+		static float UniformHemispherePDF() { return 0.5f * InvPi; }
+		static float CosineHemispherePDF(float cosTheta) { return cosTheta * InvPi; }
+		static float UniformDiskPDF() { return InvPi; }
+
+		// Rotates a local +Z direction onto normal (which must be normalized)
+		static glm::vec3 ToWorld(const glm::vec3& local, const glm::vec3& normal);
+
+		// Batch versions, SIMD where available (SSE2, AVX, NEON). They use polynomial sin/cos, so results
+		// differ from the single-sample versions by up to ~1e-5. The RandomEngine overloads draw u themselves.
+		static void UniformSphere(const glm::vec2* u, glm::vec3* out, size_t count);
+		static void UniformHemisphere(const glm::vec2* u, glm::vec3* out, size_t count);
+		static void CosineHemisphere(const glm::vec2* u, glm::vec3* out, size_t count);
+		static void UniformDisk(const glm::vec2* u, glm::vec2* out, size_t count);
+		static void UniformTriangle(const glm::vec2* u, glm::vec3* out, size_t count);
+
+		static void UniformSphere(RandomEngine& engine, glm::vec3* out, size_t count);
+		static void UniformHemisphere(RandomEngine& engine, glm::vec3* out, size_t count);
+		static void CosineHemisphere(RandomEngine& engine, glm::vec3* out, size_t count);
+		static void UniformDisk(RandomEngine& engine, glm::vec2* out, size_t count);
+		static void UniformTriangle(RandomEngine& engine, glm::vec3* out, size_t count);
+
+		// Low-discrepancy sequences, all in [0, 1). The seeded versions are Owen scrambled: every seed gives
+		// a different randomization with the same stratification, so averaging over seeds is unbiased.
+		static const uint32_t HaltonMaxDimensions = 32;
+		static const uint32_t SobolMaxDimensions = 16;
+
+		static float Halton(uint32_t index, uint32_t dimension);
+		static float Halton(uint32_t index, uint32_t dimension, uint32_t seed);
+
+		static float Sobol(uint32_t index, uint32_t dimension);
+		static float Sobol(uint32_t index, uint32_t dimension, uint32_t seed);
+		// Padded 2D Sobol: every dimension pair uses the first two Sobol dimensions with its own
+		// shuffle and scramble, so any number of pairs can be drawn without degrading quality
+		static glm::vec2 Sobol2D(uint32_t index, uint32_t dimensionPair, uint32_t seed);
+		static void Sobol2D(uint32_t firstIndex, uint32_t dimensionPair, uint32_t seed, glm::vec2* out, size_t count);
+
+		// Screen-space blue noise (Ahmed and Wonka 2020): pixels take consecutive runs of one scrambled Sobol
+		// sequence in a scrambled Morton order, so neighbouring pixels get complementary samples and the
+		// remaining error is spread as blue noise. samplesPerPixel should be a power of two.
+		static glm::vec2 BlueNoise2D(uint32_t x, uint32_t y, uint32_t sampleIndex, uint32_t samplesPerPixel,
+			uint32_t dimensionPair, uint32_t seed);
+	};
+
+}
@@ -0,0 +1,286 @@
+#include "StreamingImage.h"
+
+#include "Application.h"
+#include "Buffer.h"
+#include "GpuTimer.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+namespace Walnut {
+
+	enum class StreamingSlotState : uint64_t
+	{
+		Free = 0,
+		Writing,   // Owned by a producer
+		Ready,     // Published, waiting for Update
+		Displayed, // The image Update shows
+		Retiring   // Replaced, but a frame in flight may still draw it
+	};
+
+	// State and publish sequence share one word, so a compare-exchange can't mistake a republished slot for the one it looked at
+	struct StreamingSlot
+	{
+		std::atomic<uint64_t> Tag = 0;
+		std::atomic<uint64_t> PublishNanos = 0;
+
+		std::unique_ptr<Buffer> Staging;
+		std::unique_ptr<Image> Texture;
+	};
+
+	struct StreamingImageState
+	{
+		std::unique_ptr<StreamingSlot[]> Slots;
+		uint32_t SlotCount = 0;
+		std::atomic<uint64_t> NextSequence = 1;
+		uint32_t DisplayedSlot = UINT32_MAX; // Main thread only
+
+		Counter PresentedFrames;
+		Counter DroppedFrames;
+		Histogram Latency;
+	};
+
+	namespace Utils {
+
+		static uint32_t BytesPerPixel(ImageFormat format)
+		{
+			switch (format)
+			{
+				case ImageFormat::RGBA:    return 4;
+				case ImageFormat::RGBA32F: return 16;
+			}
+			return 0;
+		}
+
+		static uint64_t GetTimeNanos()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static uint64_t MakeTag(uint64_t sequence, StreamingSlotState state) { return (sequence << 3) | (uint64_t)state; }
+		static uint64_t GetSequence(uint64_t tag) { return tag >> 3; }
+		static StreamingSlotState GetState(uint64_t tag) { return (StreamingSlotState)(tag & 7); }
+
+		// Only succeeds if the slot still has the tag that was read
+		static bool TransitionSlot(StreamingSlot& slot, uint64_t tag, StreamingSlotState to)
+		{
+			return slot.Tag.compare_exchange_strong(tag, MakeTag(GetSequence(tag), to), std::memory_order_acq_rel);
+		}
+
+		static void RecordSlotUpload(VkCommandBuffer commandBuffer, StreamingSlot& slot, uint32_t width, uint32_t height)
+		{
+			ScopedGpuTimer gpuTimer(commandBuffer, "Streaming Upload");
+
+			// The slot was free, so no frame in flight uses its image anymore
+			VkImageMemoryBarrier copy_barrier = {};
+			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			copy_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			copy_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			copy_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.image = slot.Texture->GetVulkanImage();
+			copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy_barrier.subresourceRange.levelCount = 1;
+			copy_barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &copy_barrier);
+
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent.width = width;
+			region.imageExtent.height = height;
+			region.imageExtent.depth = 1;
+			vkCmdCopyBufferToImage(commandBuffer, slot.Staging->GetVulkanBuffer(), slot.Texture->GetVulkanImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+			VkImageMemoryBarrier use_barrier = copy_barrier;
+			use_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			use_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			use_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			use_barrier.newLayout = slot.Texture->GetLayout();
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &use_barrier);
+		}
+
+	}
+
+	StreamingImage::StreamingImage(uint32_t width, uint32_t height, ImageFormat format, uint32_t slotCount)
+		: m_Width(width), m_Height(height), m_Format(format), m_State(std::make_shared<StreamingImageState>())
+	{
+		if (slotCount == 0)
+			slotCount = 3 + Application::GetFramesInFlight();
+
+		m_State->SlotCount = slotCount;
+		m_State->Slots = std::make_unique<StreamingSlot[]>(slotCount);
+
+		uint64_t size = (uint64_t)m_Width * m_Height * Utils::BytesPerPixel(m_Format);
+		for (uint32_t i = 0; i < slotCount; i++)
+		{
+			StreamingSlot& slot = m_State->Slots[i];
+			slot.Staging = std::make_unique<Buffer>(size, BufferUsage::None, BufferMemory::HostVisible);
+			slot.Texture = std::make_unique<Image>(m_Width, m_Height, m_Format);
+		}
+	}
+
+	StreamingImage::~StreamingImage()
+	{
+		// Producers have to be stopped by now. Queued uploads hold the state, so the slots are released by whichever
+		// lets go last: this, or the frame that records the upload, whose free queue slot is fenced on that frame.
+	}
+
+	bool StreamingImage::Publish(const void* data)
+	{
+		uint32_t slot;
+		void* destination = BeginWrite(slot);
+		if (!destination)
+			return false;
+
+		memcpy(destination, data, (size_t)m_Width * m_Height * Utils::BytesPerPixel(m_Format));
+		EndWrite(slot);
+		return true;
+	}
+
+	void* StreamingImage::BeginWrite(uint32_t& outSlot)
+	{
+		StreamingImageState& state = *m_State;
+
+		for (uint32_t i = 0; i < state.SlotCount; i++)
+		{
+			uint64_t tag = state.Slots[i].Tag.load(std::memory_order_acquire);
+			if (Utils::GetState(tag) == StreamingSlotState::Free && Utils::TransitionSlot(state.Slots[i], tag, StreamingSlotState::Writing))
+			{
+				outSlot = i;
+				return state.Slots[i].Staging->GetMappedData();
+			}
+		}
+
+		// No free slot: overwrite the oldest frame that hasn't been shown yet
+		while (true)
+		{
+			uint32_t oldest = UINT32_MAX;
+			uint64_t oldestTag = UINT64_MAX;
+			for (uint32_t i = 0; i < state.SlotCount; i++)
+			{
+				uint64_t tag = state.Slots[i].Tag.load(std::memory_order_acquire);
+				if (Utils::GetState(tag) == StreamingSlotState::Ready && tag < oldestTag)
+				{
+					oldest = i;
+					oldestTag = tag;
+				}
+			}
+
+			if (oldest == UINT32_MAX)
+			{
+				state.DroppedFrames.Increment();
+				return nullptr;
+			}
+
+			if (Utils::TransitionSlot(state.Slots[oldest], oldestTag, StreamingSlotState::Writing))
+			{
+				state.DroppedFrames.Increment();
+				outSlot = oldest;
+				return state.Slots[oldest].Staging->GetMappedData();
+			}
+		}
+	}
+
+	void StreamingImage::EndWrite(uint32_t slot)
+	{
+		StreamingImageState& state = *m_State;
+		StreamingSlot& streamingSlot = state.Slots[slot];
+		streamingSlot.PublishNanos.store(Utils::GetTimeNanos(), std::memory_order_relaxed);
+		uint64_t sequence = state.NextSequence.fetch_add(1, std::memory_order_relaxed);
+		streamingSlot.Tag.store(Utils::MakeTag(sequence, StreamingSlotState::Ready), std::memory_order_release);
+	}
+
+	bool StreamingImage::Update()
+	{
+		WL_PROFILE_FUNCTION();
+
+		StreamingImageState& state = *m_State;
+
+		uint32_t newest = UINT32_MAX;
+		uint64_t newestTag = 0;
+		for (uint32_t i = 0; i < state.SlotCount; i++)
+		{
+			uint64_t tag = state.Slots[i].Tag.load(std::memory_order_acquire);
+			if (Utils::GetState(tag) == StreamingSlotState::Ready && tag > newestTag)
+			{
+				newest = i;
+				newestTag = tag;
+			}
+		}
+
+		// A producer can take the slot back between the scan and here, in which case the next frame picks up its replacement
+		if (newest == UINT32_MAX || !Utils::TransitionSlot(state.Slots[newest], newestTag, StreamingSlotState::Displayed))
+			return false;
+
+		// Frames published before this one will never be shown
+		for (uint32_t i = 0; i < state.SlotCount; i++)
+		{
+			uint64_t tag = state.Slots[i].Tag.load(std::memory_order_acquire);
+			if (Utils::GetState(tag) == StreamingSlotState::Ready && tag < newestTag && Utils::TransitionSlot(state.Slots[i], tag, StreamingSlotState::Free))
+				state.DroppedFrames.Increment();
+		}
+
+		StreamingSlot& slot = state.Slots[newest];
+		state.Latency.Record((Utils::GetTimeNanos() - slot.PublishNanos.load(std::memory_order_relaxed)) / 1000);
+		state.PresentedFrames.Increment();
+
+		Application::SubmitFrameCommands([state = m_State, newest, width = m_Width, height = m_Height](VkCommandBuffer commandBuffer)
+		{
+			Utils::RecordSlotUpload(commandBuffer, state->Slots[newest], width, height);
+		});
+
+		// The previous image was drawn by the last frame, it goes back to the producers once that is done
+		uint32_t previous = state.DisplayedSlot;
+		state.DisplayedSlot = newest;
+		if (previous != UINT32_MAX)
+		{
+			StreamingSlot& previousSlot = state.Slots[previous];
+			uint64_t sequence = Utils::GetSequence(previousSlot.Tag.load(std::memory_order_relaxed));
+			previousSlot.Tag.store(Utils::MakeTag(sequence, StreamingSlotState::Retiring), std::memory_order_relaxed);
+			Application::SubmitResourceFree([state = m_State, previous, sequence]()
+			{
+				state->Slots[previous].Tag.store(Utils::MakeTag(sequence, StreamingSlotState::Free), std::memory_order_release);
+			});
+		}
+
+		return true;
+	}
+
+	VkDescriptorSet StreamingImage::GetDescriptorSet() const
+	{
+		const Image* image = GetImage();
+		return image ? image->GetDescriptorSet() : nullptr;
+	}
+
+	const Image* StreamingImage::GetImage() const
+	{
+		if (m_State->DisplayedSlot == UINT32_MAX)
+			return nullptr;
+		return m_State->Slots[m_State->DisplayedSlot].Texture.get();
+	}
+
+	uint32_t StreamingImage::GetSlotCount() const
+	{
+		return m_State->SlotCount;
+	}
+
+	uint64_t StreamingImage::GetPresentedFrameCount() const
+	{
+		return (uint64_t)m_State->PresentedFrames.Get();
+	}
+
+	uint64_t StreamingImage::GetDroppedFrameCount() const
+	{
+		return (uint64_t)m_State->DroppedFrames.Get();
+	}
+
+	const Histogram& StreamingImage::GetLatency() const
+	{
+		return m_State->Latency;
+	}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Image.h"
+#include "Metrics.h"
+
+#include <memory>
+
+namespace Walnut {
+
+	struct StreamingImageState;
+
+	// An image fed by producer threads (video decoders, cameras, renderers) at their own rate.
+	// Every slot is a persistently mapped staging buffer plus its own VkImage. Producers claim a free slot,
+	// fill it and publish it without locks. Update() on the main thread shows the newest published frame.
+	// Its copy is recorded into the frame's command buffer, so it never stalls or tears a frame that is still in flight.
+	// Older published frames that were never shown are dropped. Slots come back once the GPU is done with them.
+	class StreamingImage
+	{
+	public:
+		// slotCount 0 is triple buffering plus one slot per frame in flight, enough for producers to never run dry
+		StreamingImage(uint32_t width, uint32_t height, ImageFormat format, uint32_t slotCount = 0);
+		~StreamingImage();
+
+		// Producer side, any number of threads. Returns false if every slot was busy and the frame was dropped.
+		bool Publish(const void* data);
+
+		// Zero-copy variant of Publish: fill Width * Height pixels at the returned pointer, then EndWrite.
+		// Returns nullptr (and counts a dropped frame) if every slot is busy.
+		void* BeginWrite(uint32_t& outSlot);
+		void EndWrite(uint32_t slot);
+
+		// Main thread, once per frame before drawing. Never blocks. Returns true if a new frame was picked up.
+		bool Update();
+
+		// The newest frame picked up by Update, nullptr before the first one
+		VkDescriptorSet GetDescriptorSet() const;
+		const Image* GetImage() const;
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		uint32_t GetSlotCount() const;
+
+		// Frames shown by Update, and frames that were published but replaced (or had no slot) before being shown
+		uint64_t GetPresentedFrameCount() const;
+		uint64_t GetDroppedFrameCount() const;
+		// Microseconds from EndWrite/Publish until Update picked the frame up
+		const Histogram& GetLatency() const;
+	private:
+		uint32_t m_Width = 0, m_Height = 0;
+		ImageFormat m_Format = ImageFormat::None;
+
+		// Shared with frame commands and deferred frees, which can outlive the image by a few frames
+		std::shared_ptr<StreamingImageState> m_State;
+	};
+
+}
@@ -29,6 +29,11 @@ namespace Walnut {
 			return Elapsed() * 1000.0f;
 		}
 
+		uint64_t ElapsedNanos()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - m_Start).count();
+		}
+
 	private:
 		std::chrono::time_point<std::chrono::high_resolution_clock> m_Start;
 	};
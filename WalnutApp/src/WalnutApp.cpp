@@ -3,6 +3,9 @@
 
 #include "Walnut/Image.h"
 
+#include <cstdlib>
+#include <cstring>
+
 class ExampleLayer : public Walnut::Layer
 {
 public:
@@ -12,6 +15,14 @@ public:
 		ImGui::Button("Button");
 		ImGui::End();
 
+		const Walnut::StartupReport& startup = Walnut::Application::Get().GetStartupReport();
+		ImGui::Begin("Startup");
+		for (const Walnut::StartupPhase& phase : startup.Phases)
+			ImGui::Text("%s%s - %.2fms", phase.Name.c_str(), phase.Async ? " (async)" : "", phase.Milliseconds);
+		ImGui::Separator();
+		ImGui::Text("Init - %.2fms, first frame - %.2fms", startup.InitMilliseconds, startup.FirstFrameMilliseconds);
+		ImGui::End();
+
 		ImGui::ShowDemoWindow();
 	}
 };
@@ -21,12 +32,51 @@ Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 	Walnut::ApplicationSpecification spec;
 	spec.Name = "Walnut Example";
 
+	// --record <file> captures a session, --replay <file> plays it back with a fixed timestep.
+	// --capture <directory|file.y4m> writes every presented frame as PNGs or a Y4M video.
+	// --render-thread <depth> builds frames ahead of a render thread that submits and presents them.
+	// --frames-in-flight <1-3> trades latency (fewer) for throughput (more).
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--record") == 0)
+			spec.InputRecordPath = argv[++i];
+		else if (strcmp(argv[i], "--replay") == 0)
+			spec.InputReplayPath = argv[++i];
+		else if (strcmp(argv[i], "--capture") == 0)
+		{
+			spec.Capture.Path = argv[++i];
+			if (spec.Capture.Path.size() > 4 && spec.Capture.Path.compare(spec.Capture.Path.size() - 4, 4, ".y4m") == 0)
+				spec.Capture.Format = Walnut::FrameCaptureFormat::Y4M;
+		}
+		else if (strcmp(argv[i], "--render-thread") == 0)
+			spec.RenderThreadDepth = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--frames-in-flight") == 0)
+			spec.FramesInFlight = (uint32_t)atoi(argv[++i]);
+	}
+
 	Walnut::Application* app = new Walnut::Application(spec);
 	app->PushLayer<ExampleLayer>();
 	app->SetMenubarCallback([app]()
 	{
 		if (ImGui::BeginMenu("File"))
 		{
+			if (ImGui::MenuItem(Walnut::FrameCapture::IsCapturing() ? "Stop Capture" : "Start Capture"))
+			{
+				if (Walnut::FrameCapture::IsCapturing())
+				{
+					Walnut::FrameCapture::Stop();
+				}
+				else
+				{
+					Walnut::FrameCaptureSpecification capture;
+					capture.Path = "Capture";
+					Walnut::FrameCapture::Start(capture);
+				}
+			}
+			if (ImGui::MenuItem("Restart"))
+			{
+				app->Restart();
+			}
 			if (ImGui::MenuItem("Exit"))
 			{
 				app->Close();
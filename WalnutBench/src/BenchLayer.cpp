@@ -0,0 +1,60 @@
+#include "BenchLayer.h"
+
+#include "Walnut/Application.h"
+
+void BenchLayer::OnUpdate(float ts)
+{
+	uint32_t totalFrames = m_Config.WarmupFrames + m_Config.Frames;
+	if (m_Frame >= totalFrames)
+		return;
+
+	// Frame time and draw stats of the previous frame
+	if (m_Frame > m_Config.WarmupFrames)
+	{
+		m_FrameTimes.Record(m_FrameTimer.ElapsedNanos() / 1000);
+
+		const Walnut::FrameStatsSample& stats = Walnut::Application::Get().GetFrameStats().GetLatest();
+		m_DrawCalls += stats.DrawCalls;
+		m_Vertices += stats.Vertices;
+		m_InputLatencies.Record((uint64_t)(stats.InputLatencyMillis * 1000.0f));
+		m_MeasuredFrames++;
+	}
+	m_FrameTimer.Reset();
+
+	if (m_Frame == m_Config.WarmupFrames)
+		m_RunTimer.Reset();
+
+	Walnut::Timer workTimer;
+	Update(m_Frame);
+	m_WorkNanos = workTimer.ElapsedNanos();
+}
+
+void BenchLayer::OnUIRender()
+{
+	uint32_t totalFrames = m_Config.WarmupFrames + m_Config.Frames;
+	if (m_Frame >= totalFrames)
+		return;
+
+	Walnut::Timer workTimer;
+	UIRender();
+	m_WorkNanos += workTimer.ElapsedNanos();
+
+	if (IsMeasuring())
+		m_WorkTimes.Record(m_WorkNanos / 1000);
+
+	if (++m_Frame == totalFrames)
+	{
+		m_Seconds = m_RunTimer.Elapsed();
+		Walnut::Application::Get().Close();
+	}
+}
+
+double BenchLayer::GetAverageDrawCalls() const
+{
+	return m_MeasuredFrames ? (double)m_DrawCalls / m_MeasuredFrames : 0.0;
+}
+
+double BenchLayer::GetAverageVertices() const
+{
+	return m_MeasuredFrames ? (double)m_Vertices / m_MeasuredFrames : 0.0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Walnut/Layer.h"
+#include "Walnut/Metrics.h"
+#include "Walnut/Timer.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BenchConfig
+{
+	uint32_t Frames = 300;
+	uint32_t WarmupFrames = 30;
+	std::string ImagePath;      // Extra image for the decode_file scenario
+	std::string TempDirectory = ".";
+};
+
+// Runs one scenario for WarmupFrames + Frames frames, then closes the application.
+// Frame time is measured between OnUpdate calls, work time covers the scenario's Update and UIRender.
+class BenchLayer : public Walnut::Layer
+{
+public:
+	BenchLayer(const BenchConfig& config)
+		: m_Config(config) {}
+
+	virtual void OnUpdate(float ts) override final;
+	virtual void OnUIRender() override final;
+
+	bool IsMeasuring() const { return m_Frame >= m_Config.WarmupFrames; }
+
+	const Walnut::Histogram& GetFrameTimes() const { return m_FrameTimes; }
+	const Walnut::Histogram& GetWorkTimes() const { return m_WorkTimes; }
+	// From polling input to presenting, as reported by the frame stats
+	const Walnut::Histogram& GetInputLatencies() const { return m_InputLatencies; }
+	float GetSeconds() const { return m_Seconds; }
+	uint64_t GetItems() const { return m_Items; }
+	double GetAverageDrawCalls() const;
+	double GetAverageVertices() const;
+protected:
+	virtual void Update(uint32_t frame) {}
+	virtual void UIRender() {}
+
+	// Scenario throughput (bytes, images, widgets...), only counted after warmup
+	void AddItems(uint64_t count) { if (IsMeasuring()) m_Items += count; }
+
+	const BenchConfig& GetConfig() const { return m_Config; }
+private:
+	BenchConfig m_Config;
+	uint32_t m_Frame = 0;
+	uint32_t m_MeasuredFrames = 0;
+
+	Walnut::Timer m_FrameTimer;
+	Walnut::Timer m_RunTimer;
+	uint64_t m_WorkNanos = 0;
+	float m_Seconds = 0.0f;
+
+	Walnut::Histogram m_FrameTimes;
+	Walnut::Histogram m_WorkTimes;
+	Walnut::Histogram m_InputLatencies;
+	uint64_t m_Items = 0;
+	uint64_t m_DrawCalls = 0;
+	uint64_t m_Vertices = 0;
+};
+
+struct BenchScenario
+{
+	std::string Name;
+	std::string Unit; // What AddItems counts
+	std::function<std::shared_ptr<BenchLayer>(const BenchConfig&)> Create;
+};
+
+const std::vector<BenchScenario>& GetBenchScenarios();
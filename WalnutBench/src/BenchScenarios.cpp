@@ -0,0 +1,675 @@
+#include "BenchLayer.h"
+
+#include "Walnut/Application.h"
+#include "Walnut/Image.h"
+#include "Walnut/Buffer.h"
+#include "Walnut/StreamingImage.h"
+#include "Walnut/FrameCapture.h"
+#include "Walnut/Compute/Tonemapper.h"
+
+#include "imgui.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace Utils {
+
+	static void FillPattern(std::vector<uint8_t>& data, uint32_t seed)
+	{
+		uint32_t state = seed * 747796405u + 2891336453u;
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			state = state * 1664525u + 1013904223u;
+			data[i] = (uint8_t)(state >> 24);
+		}
+	}
+
+	static uint32_t BytesPerPixel(Walnut::ImageFormat format)
+	{
+		return format == Walnut::ImageFormat::RGBA32F ? 16 : 4;
+	}
+
+	// 24-bit uncompressed BMP, decoded through the ImageFormat::RGBA path
+	static bool WriteBMP(const std::string& path, uint32_t width, uint32_t height)
+	{
+		uint32_t rowSize = (width * 3 + 3) & ~3u;
+		uint32_t dataSize = rowSize * height;
+		uint8_t header[54] = { 'B', 'M' };
+		auto write32 = [&header](uint32_t offset, uint32_t value)
+		{
+			for (uint32_t i = 0; i < 4; i++)
+				header[offset + i] = (uint8_t)(value >> (i * 8));
+		};
+		write32(2, 54 + dataSize);
+		write32(10, 54);
+		write32(14, 40);
+		write32(18, width);
+		write32(22, height);
+		header[26] = 1;  // Planes
+		header[28] = 24; // Bits per pixel
+		write32(34, dataSize);
+
+		std::vector<uint8_t> pixels(dataSize);
+		FillPattern(pixels, width);
+
+		std::ofstream stream(path, std::ios::binary);
+		stream.write((const char*)header, sizeof(header));
+		stream.write((const char*)pixels.data(), pixels.size());
+		return (bool)stream;
+	}
+
+	// Flat (not run-length encoded) Radiance RGBE, decoded through the ImageFormat::RGBA32F path
+	static bool WriteHDR(const std::string& path, uint32_t width, uint32_t height)
+	{
+		std::vector<uint8_t> pixels((size_t)width * height * 4);
+		FillPattern(pixels, height);
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			pixels[i] |= 0x80;   // Never starts with the 2, 2 marker of an RLE scanline
+			pixels[i + 3] = 128; // Exponent
+		}
+
+		std::ofstream stream(path, std::ios::binary);
+		stream << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " << height << " +X " << width << "\n";
+		stream.write((const char*)pixels.data(), pixels.size());
+		return (bool)stream;
+	}
+
+}
+
+// One full-frame SetData per frame
+class UploadScenario : public BenchLayer
+{
+public:
+	UploadScenario(const BenchConfig& config, uint32_t width, uint32_t height, Walnut::ImageFormat format)
+		: BenchLayer(config), m_Width(width), m_Height(height), m_Format(format) {}
+
+	virtual void OnAttach() override
+	{
+		m_Data.resize((size_t)m_Width * m_Height * Utils::BytesPerPixel(m_Format));
+		Utils::FillPattern(m_Data, m_Width);
+		m_Image = std::make_unique<Walnut::Image>(m_Width, m_Height, m_Format);
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Image.reset();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		m_Data[frame % m_Data.size()] ^= 0xff;
+		m_Image->SetData(m_Data.data());
+		AddItems(m_Data.size());
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Upload");
+		ImGui::Image(m_Image->GetDescriptorSet(), ImVec2(256.0f, 256.0f));
+		ImGui::End();
+	}
+private:
+	uint32_t m_Width, m_Height;
+	Walnut::ImageFormat m_Format;
+	std::vector<uint8_t> m_Data;
+	std::unique_ptr<Walnut::Image> m_Image;
+};
+
+// A grid of small images, a slice of them updated and a few recreated every frame
+class ManySmallImagesScenario : public BenchLayer
+{
+public:
+	static const uint32_t ImageCount = 1024;
+	static const uint32_t ImageSize = 64;
+	static const uint32_t UpdatesPerFrame = 128;
+	static const uint32_t RecreatesPerFrame = 8;
+public:
+	using BenchLayer::BenchLayer;
+
+	virtual void OnAttach() override
+	{
+		m_Data.resize(ImageSize * ImageSize * 4);
+		Utils::FillPattern(m_Data, ImageSize);
+		m_Images.resize(ImageCount);
+		for (auto& image : m_Images)
+			image = std::make_unique<Walnut::Image>(ImageSize, ImageSize, Walnut::ImageFormat::RGBA, m_Data.data());
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Images.clear();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		for (uint32_t i = 0; i < UpdatesPerFrame; i++)
+			m_Images[(frame * UpdatesPerFrame + i) % ImageCount]->SetData(m_Data.data());
+
+		for (uint32_t i = 0; i < RecreatesPerFrame; i++)
+		{
+			auto& image = m_Images[(frame * RecreatesPerFrame + i * 97) % ImageCount];
+			image = std::make_unique<Walnut::Image>(ImageSize, ImageSize, Walnut::ImageFormat::RGBA, m_Data.data());
+		}
+
+		AddItems(UpdatesPerFrame + RecreatesPerFrame);
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Images");
+		for (uint32_t i = 0; i < ImageCount; i++)
+		{
+			if (i % 32 != 0)
+				ImGui::SameLine(0.0f, 1.0f);
+			ImGui::Image(m_Images[i]->GetDescriptorSet(), ImVec2(16.0f, 16.0f));
+		}
+		ImGui::End();
+	}
+private:
+	std::vector<uint8_t> m_Data;
+	std::vector<std::unique_ptr<Walnut::Image>> m_Images;
+};
+
+// Worker threads creating and uploading images in parallel, as an asset loader would. The frame waits for them,
+// so comparing thread counts shows how well uploads scale with per-thread command pools.
+class ThreadedUploadScenario : public BenchLayer
+{
+public:
+	static const uint32_t ImagesPerFrame = 64;
+	static const uint32_t ImageSize = 256;
+public:
+	ThreadedUploadScenario(const BenchConfig& config, uint32_t threadCount)
+		: BenchLayer(config), m_ThreadCount(threadCount) {}
+
+	virtual void OnAttach() override
+	{
+		m_Data.resize(ImageSize * ImageSize * 4);
+		Utils::FillPattern(m_Data, ImageSize);
+		m_Images.resize(ImagesPerFrame);
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Images.clear();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		std::vector<std::thread> threads(m_ThreadCount);
+		for (uint32_t t = 0; t < m_ThreadCount; t++)
+		{
+			threads[t] = std::thread([this, t]()
+			{
+				// Replacing an image releases the previous one from the worker as well
+				for (uint32_t i = t; i < ImagesPerFrame; i += m_ThreadCount)
+					m_Images[i] = std::make_unique<Walnut::Image>(ImageSize, ImageSize, Walnut::ImageFormat::RGBA, m_Data.data());
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+
+		AddItems(ImagesPerFrame);
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Images");
+		for (uint32_t i = 0; i < ImagesPerFrame; i++)
+		{
+			if (i % 16 != 0)
+				ImGui::SameLine(0.0f, 1.0f);
+			ImGui::Image(m_Images[i]->GetDescriptorSet(), ImVec2(32.0f, 32.0f));
+		}
+		ImGui::End();
+	}
+private:
+	uint32_t m_ThreadCount;
+	std::vector<uint8_t> m_Data;
+	std::vector<std::unique_ptr<Walnut::Image>> m_Images;
+};
+
+// Resizes the window and an image every frame, the swapchain is rebuilt every frame with --resize-debounce 0
+class ResizeStormScenario : public BenchLayer
+{
+public:
+	using BenchLayer::BenchLayer;
+
+	virtual void OnAttach() override
+	{
+		m_Data.resize(400 * 225 * 4); // Largest image size below
+		Utils::FillPattern(m_Data, 0);
+		m_Image = std::make_unique<Walnut::Image>(256, 256, Walnut::ImageFormat::RGBA, m_Data.data());
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Image.reset();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		static const int sizes[][2] = { { 1280, 720 }, { 1024, 768 }, { 1600, 900 }, { 800, 600 } };
+		const int* size = sizes[frame % 4];
+		glfwSetWindowSize(Walnut::Application::Get().GetWindowHandle(), size[0], size[1]);
+		m_Image->Resize(size[0] / 4, size[1] / 4);
+		m_Image->SetData(m_Data.data());
+		AddItems(1);
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Resize");
+		ImGui::Image(m_Image->GetDescriptorSet(), ImVec2((float)m_Image->GetWidth(), (float)m_Image->GetHeight()));
+		ImGui::End();
+	}
+private:
+	std::vector<uint8_t> m_Data;
+	std::unique_ptr<Walnut::Image> m_Image;
+};
+
+// Drags the window corner a few pixels per frame back and forth, counting the swapchain rebuilds it causes.
+// Frame time percentiles show the stutter, compare --resize-debounce 0 against the default.
+class ResizeDragScenario : public BenchLayer
+{
+public:
+	static const int StepPixels = 8;
+	static const int MinWidth = 960, MaxWidth = 1600;
+public:
+	using BenchLayer::BenchLayer;
+
+	virtual void OnAttach() override
+	{
+		m_LastRebuilds = m_Rebuilds.Get();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		// Triangle wave between MinWidth and MaxWidth, 16:9
+		int range = (MaxWidth - MinWidth) / StepPixels;
+		int step = (int)(frame % (range * 2));
+		int width = MinWidth + (step < range ? step : range * 2 - step) * StepPixels;
+		glfwSetWindowSize(Walnut::Application::Get().GetWindowHandle(), width, width * 9 / 16);
+
+		int64_t rebuilds = m_Rebuilds.Get();
+		AddItems((uint64_t)(rebuilds - m_LastRebuilds));
+		m_LastRebuilds = rebuilds;
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::ShowDemoWindow();
+	}
+private:
+	Walnut::Counter& m_Rebuilds = Walnut::MetricsRegistry::GetCounter("Walnut/SwapchainRebuilds");
+	int64_t m_LastRebuilds = 0;
+};
+
+// The demo window plus a few thousand unclipped widgets
+class ImGuiWidgetsScenario : public BenchLayer
+{
+public:
+	static const uint32_t RowCount = 1000;
+public:
+	using BenchLayer::BenchLayer;
+protected:
+	virtual void UIRender() override
+	{
+		ImGui::ShowDemoWindow();
+
+		ImGui::SetNextWindowSize(ImVec2(800.0f, 600.0f));
+		ImGui::Begin("Widgets");
+		if (ImGui::BeginTable("Rows", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			for (uint32_t i = 0; i < RowCount; i++)
+			{
+				ImGui::PushID(i);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("Row %u", i);
+				ImGui::TableNextColumn();
+				ImGui::Button("Button");
+				ImGui::TableNextColumn();
+				ImGui::SliderFloat("##Slider", &m_Values[i % 16], 0.0f, 1.0f);
+				ImGui::TableNextColumn();
+				ImGui::Checkbox("##Check", &m_Checks[i % 16]);
+				ImGui::PopID();
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+
+		AddItems(RowCount * 4);
+	}
+private:
+	float m_Values[16] = {};
+	bool m_Checks[16] = {};
+};
+
+// Loads (decodes and uploads) an image file every frame
+class DecodeScenario : public BenchLayer
+{
+public:
+	enum class Source { BMP, HDR, File };
+public:
+	DecodeScenario(const BenchConfig& config, Source source)
+		: BenchLayer(config), m_Source(source) {}
+
+	virtual void OnAttach() override
+	{
+		const uint32_t size = 1024;
+		switch (m_Source)
+		{
+			case Source::BMP:
+				m_Path = GetConfig().TempDirectory + "/WalnutBench.bmp";
+				Utils::WriteBMP(m_Path, size, size);
+				break;
+			case Source::HDR:
+				m_Path = GetConfig().TempDirectory + "/WalnutBench.hdr";
+				Utils::WriteHDR(m_Path, size, size);
+				break;
+			case Source::File:
+				m_Path = GetConfig().ImagePath;
+				break;
+		}
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Image.reset();
+		if (m_Source != Source::File)
+			std::remove(m_Path.c_str());
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		m_Image = std::make_unique<Walnut::Image>(m_Path);
+		AddItems(1);
+	}
+private:
+	Source m_Source;
+	std::string m_Path;
+	std::unique_ptr<Walnut::Image> m_Image;
+};
+
+// Ranged updates of a device-local buffer: many small ones (inline in the frame's command buffer),
+// one large one (staging buffer) and a readback every frame
+class BufferUpdateScenario : public BenchLayer
+{
+public:
+	static const uint32_t BufferSize = 16 * 1024 * 1024;
+	static const uint32_t SmallUpdateSize = 4096;
+	static const uint32_t SmallUpdatesPerFrame = 256;
+	static const uint32_t LargeUpdateSize = 1024 * 1024;
+	static const uint32_t ReadbackSize = 64 * 1024;
+public:
+	using BenchLayer::BenchLayer;
+
+	virtual void OnAttach() override
+	{
+		m_Data.resize(LargeUpdateSize);
+		Utils::FillPattern(m_Data, LargeUpdateSize);
+		m_Buffer = std::make_unique<Walnut::Buffer>(BufferSize, Walnut::BufferUsage::Storage);
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Buffer.reset();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		for (uint32_t i = 0; i < SmallUpdatesPerFrame; i++)
+		{
+			uint32_t slot = (frame * SmallUpdatesPerFrame + i * 61) % (BufferSize / SmallUpdateSize);
+			m_Buffer->SetData(m_Data.data() + (i % 16) * SmallUpdateSize, SmallUpdateSize, (uint64_t)slot * SmallUpdateSize);
+		}
+		m_Buffer->SetData(m_Data.data(), LargeUpdateSize, (uint64_t)(frame % (BufferSize / LargeUpdateSize)) * LargeUpdateSize);
+
+		// The callback can run after the layer is gone
+		m_Buffer->ReadData([readbackBytes = m_ReadbackBytes](const void* data, uint64_t size) { *readbackBytes += size; }, 0, ReadbackSize);
+
+		AddItems(SmallUpdatesPerFrame * SmallUpdateSize + LargeUpdateSize);
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Buffer");
+		ImGui::Text("Read back %llu bytes", (unsigned long long)*m_ReadbackBytes);
+		ImGui::End();
+	}
+private:
+	std::vector<uint8_t> m_Data;
+	std::unique_ptr<Walnut::Buffer> m_Buffer;
+	std::shared_ptr<uint64_t> m_ReadbackBytes = std::make_shared<uint64_t>(0);
+};
+
+// A producer thread publishing 1080p frames at ~120 fps into a StreamingImage that the UI shows
+class StreamingImageScenario : public BenchLayer
+{
+public:
+	static const uint32_t Width = 1920;
+	static const uint32_t Height = 1080;
+public:
+	using BenchLayer::BenchLayer;
+
+	virtual void OnAttach() override
+	{
+		m_Image = std::make_unique<Walnut::StreamingImage>(Width, Height, Walnut::ImageFormat::RGBA);
+		m_Running = true;
+		m_Producer = std::thread([this]()
+		{
+			std::vector<uint8_t> data((size_t)Width * Height * 4);
+			Utils::FillPattern(data, Width);
+			for (uint32_t frame = 0; m_Running; frame++)
+			{
+				data[frame % data.size()] ^= 0xff;
+				m_Image->Publish(data.data());
+				std::this_thread::sleep_for(std::chrono::milliseconds(8));
+			}
+		});
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Running = false;
+		m_Producer.join();
+		m_Image.reset();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		if (m_Image->Update())
+			AddItems(1);
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Streaming");
+		if (VkDescriptorSet descriptorSet = m_Image->GetDescriptorSet())
+			ImGui::Image(descriptorSet, ImVec2(480.0f, 270.0f));
+		ImGui::Text("Presented %llu, dropped %llu, p99 latency %llu us", (unsigned long long)m_Image->GetPresentedFrameCount(),
+			(unsigned long long)m_Image->GetDroppedFrameCount(), (unsigned long long)m_Image->GetLatency().Percentile(99.0));
+		ImGui::End();
+	}
+private:
+	std::unique_ptr<Walnut::StreamingImage> m_Image;
+	std::thread m_Producer;
+	std::atomic<bool> m_Running = false;
+};
+
+// Tonemaps an HDR image into a displayed RGBA image every frame, either with the Tonemap compute
+// kernel or on the CPU followed by a full-frame upload (what an app without compute has to do)
+class TonemapScenario : public BenchLayer
+{
+public:
+	TonemapScenario(const BenchConfig& config, uint32_t width, uint32_t height, bool compute)
+		: BenchLayer(config), m_Width(width), m_Height(height), m_Compute(compute) {}
+
+	virtual void OnAttach() override
+	{
+		std::vector<uint8_t> pattern((size_t)m_Width * m_Height * 4);
+		Utils::FillPattern(pattern, m_Width);
+		m_HDR.resize(pattern.size());
+		for (size_t i = 0; i < pattern.size(); i++)
+			m_HDR[i] = pattern[i] / 64.0f;
+
+		if (m_Compute)
+		{
+			m_Input = std::make_unique<Walnut::Image>(m_Width, m_Height, Walnut::ImageFormat::RGBA32F, m_HDR.data());
+			m_Output = std::make_unique<Walnut::Image>(m_Width, m_Height, Walnut::ImageFormat::RGBA, nullptr, Walnut::ImageUsage::Storage);
+			m_Tonemapper = std::make_unique<Walnut::Tonemapper>();
+			if (!m_Tonemapper->IsValid())
+				std::cerr << "Tonemap shader missing, Walnut was built without glslc\n";
+		}
+		else
+		{
+			m_LDR.resize(pattern.size());
+			m_Output = std::make_unique<Walnut::Image>(m_Width, m_Height, Walnut::ImageFormat::RGBA);
+		}
+	}
+
+	virtual void OnDetach() override
+	{
+		m_Tonemapper.reset();
+		m_Input.reset();
+		m_Output.reset();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		float exposure = 0.5f + (frame % 64) / 32.0f;
+		if (m_Compute)
+		{
+			m_Tonemapper->Dispatch(*m_Input, *m_Output, exposure);
+		}
+		else
+		{
+			// Same curve as Tonemap.comp
+			for (size_t i = 0; i < m_HDR.size(); i++)
+			{
+				float x = m_HDR[i] * exposure;
+				x = std::clamp((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f), 0.0f, 1.0f);
+				m_LDR[i] = (i % 4 == 3) ? 255 : (uint8_t)(std::pow(x, 1.0f / 2.2f) * 255.0f + 0.5f);
+			}
+			m_Output->SetData(m_LDR.data());
+		}
+		AddItems((uint64_t)m_Width * m_Height);
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::Begin("Tonemap");
+		ImGui::Image(m_Output->GetDescriptorSet(), ImVec2(480.0f, 270.0f));
+		ImGui::End();
+	}
+private:
+	uint32_t m_Width, m_Height;
+	bool m_Compute;
+	std::vector<float> m_HDR;
+	std::vector<uint8_t> m_LDR;
+	std::unique_ptr<Walnut::Image> m_Input, m_Output;
+	std::unique_ptr<Walnut::Tonemapper> m_Tonemapper;
+};
+
+// The demo window captured every frame, to a Y4M file or a PNG sequence in the temp directory.
+// Frame time against imgui_widgets is the cost of capturing, the stall count shows whether the encoder kept up.
+class CaptureScenario : public BenchLayer
+{
+public:
+	CaptureScenario(const BenchConfig& config, Walnut::FrameCaptureFormat format)
+		: BenchLayer(config), m_Format(format) {}
+
+	virtual void OnAttach() override
+	{
+		Walnut::FrameCaptureSpecification spec;
+		spec.Format = m_Format;
+		spec.Path = GetConfig().TempDirectory + (m_Format == Walnut::FrameCaptureFormat::Y4M ? "/WalnutBench.y4m" : "/WalnutBenchCapture");
+		if (!Walnut::FrameCapture::Start(spec))
+			std::cerr << "Can't capture to " << spec.Path << "\n";
+	}
+
+	virtual void OnDetach() override
+	{
+		Walnut::FrameCapture::Stop();
+	}
+protected:
+	virtual void Update(uint32_t frame) override
+	{
+		Walnut::FrameCaptureStats stats = Walnut::FrameCapture::GetStats();
+		AddItems(stats.CapturedFrames - m_LastCaptured);
+		m_LastCaptured = stats.CapturedFrames;
+	}
+
+	virtual void UIRender() override
+	{
+		ImGui::ShowDemoWindow();
+
+		Walnut::FrameCaptureStats stats = Walnut::FrameCapture::GetStats();
+		ImGui::Begin("Capture");
+		ImGui::Text("Captured %llu, encoded %llu, stalls %llu", (unsigned long long)stats.CapturedFrames,
+			(unsigned long long)stats.EncodedFrames, (unsigned long long)stats.Stalls);
+		ImGui::Text("%.1f us/frame capture, %.1f us/frame encode", stats.CaptureMicroseconds, stats.EncodeMicroseconds);
+		ImGui::End();
+	}
+private:
+	Walnut::FrameCaptureFormat m_Format;
+	uint64_t m_LastCaptured = 0;
+};
+
+const std::vector<BenchScenario>& GetBenchScenarios()
+{
+	using Walnut::ImageFormat;
+
+	auto upload = [](uint32_t width, uint32_t height, ImageFormat format)
+	{
+		return [=](const BenchConfig& config) { return std::make_shared<UploadScenario>(config, width, height, format); };
+	};
+	auto threadedUpload = [](uint32_t threadCount)
+	{
+		return [=](const BenchConfig& config) { return std::make_shared<ThreadedUploadScenario>(config, threadCount); };
+	};
+	auto decode = [](DecodeScenario::Source source)
+	{
+		return [=](const BenchConfig& config) { return std::make_shared<DecodeScenario>(config, source); };
+	};
+	auto tonemap = [](bool compute)
+	{
+		return [=](const BenchConfig& config) { return std::make_shared<TonemapScenario>(config, 1920, 1080, compute); };
+	};
+	auto capture = [](Walnut::FrameCaptureFormat format)
+	{
+		return [=](const BenchConfig& config) { return std::make_shared<CaptureScenario>(config, format); };
+	};
+
+	static const std::vector<BenchScenario> scenarios =
+	{
+		{ "upload_rgba_256",      "bytes",   upload(256, 256, ImageFormat::RGBA) },
+		{ "upload_rgba_1080p",    "bytes",   upload(1920, 1080, ImageFormat::RGBA) },
+		{ "upload_rgba_4k",       "bytes",   upload(3840, 2160, ImageFormat::RGBA) },
+		{ "upload_rgba32f_1080p", "bytes",   upload(1920, 1080, ImageFormat::RGBA32F) },
+		{ "many_small_images",    "images",  [](const BenchConfig& config) { return std::make_shared<ManySmallImagesScenario>(config); } },
+		{ "upload_images_1t",     "images",  threadedUpload(1) },
+		{ "upload_images_4t",     "images",  threadedUpload(4) },
+		{ "resize_storm",         "resizes", [](const BenchConfig& config) { return std::make_shared<ResizeStormScenario>(config); } },
+		{ "resize_drag",          "rebuilds", [](const BenchConfig& config) { return std::make_shared<ResizeDragScenario>(config); } },
+		{ "imgui_widgets",        "widgets", [](const BenchConfig& config) { return std::make_shared<ImGuiWidgetsScenario>(config); } },
+		{ "decode_bmp_1k",        "images",  decode(DecodeScenario::Source::BMP) },
+		{ "decode_hdr_1k",        "images",  decode(DecodeScenario::Source::HDR) },
+		{ "decode_file",          "images",  decode(DecodeScenario::Source::File) }, // Only runs with --image
+		{ "buffer_updates_16mb",  "bytes",   [](const BenchConfig& config) { return std::make_shared<BufferUpdateScenario>(config); } },
+		{ "stream_image_1080p",   "frames",  [](const BenchConfig& config) { return std::make_shared<StreamingImageScenario>(config); } },
+		{ "tonemap_cpu_1080p",    "pixels",  tonemap(false) },
+		{ "tonemap_gpu_1080p",    "pixels",  tonemap(true) },
+		{ "capture_y4m",          "frames",  capture(Walnut::FrameCaptureFormat::Y4M) },
+		{ "capture_png",          "frames",  capture(Walnut::FrameCaptureFormat::PNG) },
+	};
+	return scenarios;
+}
@@ -0,0 +1,202 @@
+#include "MicroBenchmarks.h"
+
+#include "Walnut/FrameAllocator.h"
+#include "Walnut/Random.h"
+#include "Walnut/Sampling.h"
+#include "Walnut/ImGui/FontAtlasCache.h"
+#include "Walnut/ImGui/Roboto-Regular.embed"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace Legacy {
+
+	// What Walnut::Random did before it had per-thread engines
+	static std::mt19937 s_RandomEngine;
+	static std::uniform_int_distribution<std::mt19937::result_type> s_Distribution;
+	static std::mutex s_Mutex;
+
+	static float Float()
+	{
+		return (float)s_Distribution(s_RandomEngine) / (float)std::numeric_limits<uint32_t>::max();
+	}
+
+	// What Walnut::Random::InUnitSphere did before the sampling module (neither uniform nor inside the sphere)
+	static glm::vec3 InUnitSphere()
+	{
+		return glm::normalize(Walnut::Random::Vec3(-1.0f, 1.0f));
+	}
+
+}
+
+static const uint32_t s_RandomBatch = 1 << 18;
+static const uint32_t s_ThreadCount = 4;
+
+// Keeps the optimizer from dropping the generated values
+static volatile float s_Sink;
+
+template<typename Func>
+static uint64_t RunOnThreads(Func&& func)
+{
+	std::thread threads[s_ThreadCount];
+	for (uint32_t i = 0; i < s_ThreadCount; i++)
+		threads[i] = std::thread(func);
+	for (std::thread& thread : threads)
+		thread.join();
+	return s_RandomBatch;
+}
+
+static const uint32_t s_ScratchLists = 1024;
+
+// A layer's per-frame scratch work: a few short lists of visible items, sorted, plus a label per list
+template<typename MakeVector, typename MakeString>
+static uint64_t BuildScratchLists(MakeVector&& makeVector, MakeString&& makeString)
+{
+	uint64_t items = 0;
+	for (uint32_t i = 0; i < s_ScratchLists; i++)
+	{
+		auto visible = makeVector();
+		for (uint32_t j = 0; j < 16 + (i & 31); j++)
+			visible.push_back((i * 2654435761u) ^ j);
+		std::sort(visible.begin(), visible.end());
+
+		auto label = makeString();
+		label += "Item ";
+		label += std::to_string(visible.front()).c_str();
+		items += visible.size() + label.size();
+	}
+	s_Sink = (float)items;
+	return s_ScratchLists;
+}
+
+// The atlas Application::Init builds
+static void AddDefaultFont(ImFontAtlas& atlas)
+{
+	ImFontConfig fontConfig;
+	fontConfig.FontDataOwnedByAtlas = false;
+	atlas.AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
+}
+
+const std::vector<MicroBenchmark>& GetMicroBenchmarks()
+{
+	static const std::vector<MicroBenchmark> benchmarks =
+	{
+		{ "micro_random_mt19937", "floats", []()
+		{
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < s_RandomBatch; i++)
+				sum += Legacy::Float();
+			s_Sink = sum;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_random_mt19937_locked_4t", "floats", []()
+		{
+			return RunOnThreads([]()
+			{
+				float sum = 0.0f;
+				for (uint32_t i = 0; i < s_RandomBatch / s_ThreadCount; i++)
+				{
+					std::scoped_lock<std::mutex> lock(Legacy::s_Mutex);
+					sum += Legacy::Float();
+				}
+				s_Sink = sum;
+			});
+		} },
+		{ "micro_random_float", "floats", []()
+		{
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < s_RandomBatch; i++)
+				sum += Walnut::Random::Float();
+			s_Sink = sum;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_random_float_4t", "floats", []()
+		{
+			return RunOnThreads([]()
+			{
+				float sum = 0.0f;
+				for (uint32_t i = 0; i < s_RandomBatch / s_ThreadCount; i++)
+					sum += Walnut::Random::Float();
+				s_Sink = sum;
+			});
+		} },
+		{ "micro_random_fill", "floats", []()
+		{
+			static std::vector<float> values(s_RandomBatch);
+			Walnut::Random::Fill(values.data(), values.size());
+			s_Sink = values[values.size() / 2];
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_random_uint_bounded", "ints", []()
+		{
+			uint32_t sum = 0;
+			for (uint32_t i = 0; i < s_RandomBatch; i++)
+				sum += Walnut::Random::UInt(0, 999);
+			s_Sink = (float)sum;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_sampling_in_unit_sphere_old", "samples", []()
+		{
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < s_RandomBatch; i++)
+				sum += Legacy::InUnitSphere().z;
+			s_Sink = sum;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_sampling_cosine_hemisphere", "samples", []()
+		{
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < s_RandomBatch; i++)
+				sum += Walnut::Sampling::CosineHemisphere(glm::vec2(Walnut::Random::Float(), Walnut::Random::Float())).z;
+			s_Sink = sum;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_sampling_cosine_hemisphere_batch", "samples", []()
+		{
+			static std::vector<glm::vec3> samples(s_RandomBatch);
+			Walnut::Sampling::CosineHemisphere(Walnut::Random::GetThreadEngine(), samples.data(), samples.size());
+			s_Sink = samples[samples.size() / 2].z;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_sampling_sobol2d", "samples", []()
+		{
+			static std::vector<glm::vec2> samples(s_RandomBatch);
+			Walnut::Sampling::Sobol2D(0, 0, Walnut::Random::UInt(), samples.data(), samples.size());
+			s_Sink = samples[samples.size() / 2].x;
+			return (uint64_t)s_RandomBatch;
+		} },
+		{ "micro_scratch_lists_malloc", "lists", []()
+		{
+			return BuildScratchLists([]() { return std::vector<uint32_t>(); }, []() { return std::string(); });
+		} },
+		{ "micro_scratch_lists_frame_arena", "lists", []()
+		{
+			static Walnut::FrameArena arena;
+			arena.Reset(); // What Application does once per frame
+			return BuildScratchLists([]() { return Walnut::FrameVector<uint32_t>(arena); }, []() { return Walnut::FrameString(arena); });
+		} },
+		{ "micro_font_atlas_rasterize", "texels", []()
+		{
+			ImFontAtlas atlas;
+			AddDefaultFont(atlas);
+			atlas.Build();
+			s_Sink = atlas.TexUvWhitePixel.x;
+			return (uint64_t)atlas.TexWidth * (uint64_t)atlas.TexHeight;
+		} },
+		{ "micro_font_atlas_cache_load", "texels", []()
+		{
+			static const std::string directory = (std::filesystem::temp_directory_path() / "WalnutBenchFontCache").string();
+			ImFontAtlas atlas;
+			AddDefaultFont(atlas);
+			Walnut::FontAtlasCache::Build(&atlas, directory); // Only the first (warmup) iteration rasterizes
+			s_Sink = atlas.TexUvWhitePixel.x;
+			return (uint64_t)atlas.TexWidth * (uint64_t)atlas.TexHeight;
+		} },
+	};
+	return benchmarks;
+}
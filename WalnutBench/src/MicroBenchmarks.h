@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// CPU-only benchmarks, run without an Application. One call of Run is one measured iteration
+// (a "frame" in the report) and returns the number of items it processed.
+struct MicroBenchmark
+{
+	std::string Name;
+	std::string Unit;
+	std::function<uint64_t()> Run;
+};
+
+const std::vector<MicroBenchmark>& GetMicroBenchmarks();
@@ -0,0 +1,303 @@
+#include "Walnut/Application.h"
+
+#include "BenchLayer.h"
+#include "MicroBenchmarks.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// Normally defined by EntryPoint.h, WalnutBench drives Application itself
+bool g_ApplicationRunning = true;
+
+struct BenchResult
+{
+	std::string Name;
+	std::string Unit;
+	uint32_t Frames = 0;
+	float Seconds = 0.0f;
+	Walnut::Histogram::Summary FrameTime;
+	Walnut::Histogram::Summary WorkTime;
+	Walnut::Histogram::Summary InputLatency;
+	uint64_t Items = 0;
+	double DrawCalls = 0.0;
+	double Vertices = 0.0;
+	uint64_t ResidentKilobytes = 0;
+	uint64_t PeakResidentKilobytes = 0;
+};
+
+namespace Utils {
+
+	static uint64_t GetResidentKilobytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.WorkingSetSize / 1024;
+		return 0;
+#else
+		std::ifstream statm("/proc/self/statm");
+		uint64_t size = 0, resident = 0;
+		if (statm >> size >> resident)
+			return resident * (uint64_t)sysconf(_SC_PAGESIZE) / 1024;
+		return 0;
+#endif
+	}
+
+	static uint64_t GetPeakResidentKilobytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.PeakWorkingSetSize / 1024;
+		return 0;
+#else
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return (uint64_t)usage.ru_maxrss / 1024;
+#else
+		return (uint64_t)usage.ru_maxrss;
+#endif
+#endif
+	}
+
+	static void WriteSummary(std::ostream& stream, const char* name, const Walnut::Histogram::Summary& s)
+	{
+		stream << "\"" << name << "\": { \"min\": " << s.Min << ", \"mean\": " << s.Mean << ", \"p50\": " << s.P50 << ", \"p90\": " << s.P90
+			<< ", \"p95\": " << s.P95 << ", \"p99\": " << s.P99 << ", \"p999\": " << s.P999 << ", \"max\": " << s.Max << " }";
+	}
+
+	static void WriteJSON(std::ostream& stream, const std::string& device, const BenchConfig& config, const Walnut::ApplicationSpecification& spec, const std::vector<BenchResult>& results)
+	{
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\n  \"device\": \"" << device << "\",\n  \"frames\": " << config.Frames << ",\n  \"warmup_frames\": " << config.WarmupFrames
+			<< ",\n  \"frames_in_flight\": " << spec.FramesInFlight << ",\n  \"resize_debounce_ms\": " << spec.ResizeDebounceMillis << ",\n  \"render_thread_depth\": " << spec.RenderThreadDepth << ",\n  \"scenarios\": [";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const BenchResult& result = results[i];
+			double seconds = result.Seconds > 0.0f ? result.Seconds : 1.0;
+			stream << (i ? ",\n" : "\n") << "    {\n"
+				<< "      \"name\": \"" << result.Name << "\",\n"
+				<< "      \"seconds\": " << result.Seconds << ",\n"
+				<< "      \"fps\": " << result.Frames / seconds << ",\n"
+				<< "      \"unit\": \"" << result.Unit << "\",\n"
+				<< "      \"items_per_second\": " << result.Items / seconds << ",\n"
+				<< "      ";
+			WriteSummary(stream, "frame_time_us", result.FrameTime);
+			stream << ",\n      ";
+			WriteSummary(stream, "work_time_us", result.WorkTime);
+			stream << ",\n      ";
+			WriteSummary(stream, "input_latency_us", result.InputLatency);
+			stream << ",\n"
+				<< "      \"draw_calls\": " << result.DrawCalls << ",\n"
+				<< "      \"vertices\": " << result.Vertices << ",\n"
+				<< "      \"resident_kb\": " << result.ResidentKilobytes << ",\n"
+				<< "      \"peak_resident_kb\": " << result.PeakResidentKilobytes << "\n"
+				<< "    }";
+		}
+		stream << "\n  ]\n}\n";
+	}
+
+	static bool MatchesFilter(const std::string& name, const std::string& filter)
+	{
+		if (filter.empty() || filter == "all")
+			return true;
+
+		std::stringstream stream(filter);
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			// Trailing * matches a prefix, e.g. upload_*
+			if (!item.empty() && item.back() == '*')
+			{
+				if (name.compare(0, item.size() - 1, item, 0, item.size() - 1) == 0)
+					return true;
+			}
+			else if (name == item)
+				return true;
+		}
+		return false;
+	}
+
+}
+
+static void PrintUsage()
+{
+	std::cout << "Usage: WalnutBench [options]\n"
+		"  --scenario <names>  Comma separated scenario names, trailing * matches a prefix (default: all)\n"
+		"  --frames <n>        Measured frames per scenario (default: 300)\n"
+		"  --warmup <n>        Frames before measuring (default: 30)\n"
+		"  --output <path>     JSON report (default: WalnutBench.json)\n"
+		"  --image <path>      Image file for the decode_file scenario\n"
+		"  --windowed          Show the window instead of running headless\n"
+		"  --render-thread <n> Pipeline n frames through a render thread (default: 0, render on the main thread)\n"
+		"  --frames-in-flight <n> Frames the GPU may queue up, 1-3 (default: 2)\n"
+		"  --resize-debounce <ms> Delay swapchain rebuilds while the window size keeps changing (default: 50)\n"
+		"  --list              List scenarios and exit\n";
+}
+
+int main(int argc, char** argv)
+{
+	BenchConfig config;
+	std::string filter = "all";
+	std::string outputPath = "WalnutBench.json";
+	bool headless = true;
+	uint32_t renderThreadDepth = 0;
+	uint32_t framesInFlight = 2;
+	float resizeDebounceMillis = 50.0f;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--scenario" && hasValue)
+			filter = argv[++i];
+		else if (arg == "--frames" && hasValue)
+			config.Frames = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--warmup" && hasValue)
+			config.WarmupFrames = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--output" && hasValue)
+			outputPath = argv[++i];
+		else if (arg == "--image" && hasValue)
+			config.ImagePath = argv[++i];
+		else if (arg == "--windowed")
+			headless = false;
+		else if (arg == "--render-thread" && hasValue)
+			renderThreadDepth = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--frames-in-flight" && hasValue)
+			framesInFlight = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--resize-debounce" && hasValue)
+			resizeDebounceMillis = std::stof(argv[++i]);
+		else if (arg == "--list")
+		{
+			for (const BenchScenario& scenario : GetBenchScenarios())
+				std::cout << scenario.Name << "\n";
+			for (const MicroBenchmark& benchmark : GetMicroBenchmarks())
+				std::cout << benchmark.Name << "\n";
+			return 0;
+		}
+		else
+		{
+			PrintUsage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	Walnut::ApplicationSpecification spec;
+	spec.Name = "WalnutBench";
+	spec.Width = 1280;
+	spec.Height = 720;
+	spec.Headless = headless;
+	spec.VSync = false;
+	spec.FixedTimeStep = 1.0f / 60.0f;
+	spec.RenderThreadDepth = renderThreadDepth;
+	spec.FramesInFlight = framesInFlight;
+	spec.ResizeDebounceMillis = resizeDebounceMillis;
+
+	std::string device;
+	std::vector<BenchResult> results;
+	for (const BenchScenario& scenario : GetBenchScenarios())
+	{
+		if (!Utils::MatchesFilter(scenario.Name, filter))
+			continue;
+		if (scenario.Name == "decode_file" && config.ImagePath.empty())
+			continue;
+
+		std::cout << "[BENCH] " << scenario.Name << "..." << std::flush;
+
+		Walnut::Application* app = new Walnut::Application(spec);
+		if (device.empty())
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(Walnut::Application::GetPhysicalDevice(), &properties);
+			device = properties.deviceName;
+		}
+
+		std::shared_ptr<BenchLayer> layer = scenario.Create(config);
+		app->PushLayer(layer);
+		app->Run();
+
+		BenchResult& result = results.emplace_back();
+		result.Name = scenario.Name;
+		result.Unit = scenario.Unit;
+		result.Frames = config.Frames;
+		result.Seconds = layer->GetSeconds();
+		result.FrameTime = layer->GetFrameTimes().GetSummary();
+		result.WorkTime = layer->GetWorkTimes().GetSummary();
+		result.InputLatency = layer->GetInputLatencies().GetSummary();
+		result.Items = layer->GetItems();
+		result.DrawCalls = layer->GetAverageDrawCalls();
+		result.Vertices = layer->GetAverageVertices();
+		result.ResidentKilobytes = Utils::GetResidentKilobytes();
+		result.PeakResidentKilobytes = Utils::GetPeakResidentKilobytes();
+
+		delete app;
+
+		std::cout << " " << std::fixed << std::setprecision(2) << result.Frames / (result.Seconds > 0.0f ? result.Seconds : 1.0f) << " fps, p99 "
+			<< result.FrameTime.P99 / 1000.0 << " ms, input latency p50 " << result.InputLatency.P50 / 1000.0 << " ms\n";
+	}
+
+	for (const MicroBenchmark& benchmark : GetMicroBenchmarks())
+	{
+		if (!Utils::MatchesFilter(benchmark.Name, filter))
+			continue;
+
+		std::cout << "[BENCH] " << benchmark.Name << "..." << std::flush;
+
+		for (uint32_t i = 0; i < config.WarmupFrames; i++)
+			benchmark.Run();
+
+		Walnut::Histogram iterationTimes;
+		uint64_t items = 0;
+		Walnut::Timer runTimer;
+		for (uint32_t i = 0; i < config.Frames; i++)
+		{
+			Walnut::Timer timer;
+			items += benchmark.Run();
+			iterationTimes.Record(timer.ElapsedNanos() / 1000);
+		}
+
+		BenchResult& result = results.emplace_back();
+		result.Name = benchmark.Name;
+		result.Unit = benchmark.Unit;
+		result.Frames = config.Frames;
+		result.Seconds = runTimer.Elapsed();
+		result.FrameTime = iterationTimes.GetSummary();
+		result.WorkTime = result.FrameTime;
+		result.Items = items;
+		result.ResidentKilobytes = Utils::GetResidentKilobytes();
+		result.PeakResidentKilobytes = Utils::GetPeakResidentKilobytes();
+
+		std::cout << " " << std::fixed << std::setprecision(2) << result.Items / (result.Seconds > 0.0f ? result.Seconds : 1.0f) / 1e6 << " M"
+			<< result.Unit << "/s\n";
+	}
+
+	if (results.empty())
+	{
+		std::cerr << "[BENCH] No scenario matches '" << filter << "'\n";
+		return 1;
+	}
+
+	std::ofstream stream(outputPath);
+	if (!stream)
+	{
+		std::cerr << "[BENCH] Could not open " << outputPath << "\n";
+		return 1;
+	}
+	// Only CPU micro benchmarks ran, no device was created
+	if (device.empty())
+		device = "cpu";
+	Utils::WriteJSON(stream, device, config, spec, results);
+	std::cout << "[BENCH] Report written to " << outputPath << "\n";
+	return 0;
+}
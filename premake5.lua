@@ -7,4 +7,5 @@ workspace "WalnutApp"
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 include "WalnutExternal.lua"
-include "WalnutApp"
\ No newline at end of file
+include "WalnutApp"
+include "WalnutBench"
\ No newline at end of file